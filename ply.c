@@ -0,0 +1,1311 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L /* mmap, posix_madvise, fstat */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <float.h>
+#include <math.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "voxel.h"
+#include "ply.h"
+#include "vxsys.h"
+#include "vxsimd.h"
+
+/* =========================================================
+ *  Глобальные переменные — границы модели
+ * ========================================================= */
+float x_max = 0;
+float x_min = 10;
+float y_max = 0;
+float y_min = 10;
+float z_max = 0;
+float z_min = 10;
+int   vert_count = 0;
+
+vx_bounds vx_global_bounds(void)
+{
+    return (vx_bounds){x_min, x_max, y_min, y_max, z_min, z_max};
+}
+
+void vx_set_global_bounds(const vx_bounds *b)
+{
+    x_min = b->x_min; x_max = b->x_max;
+    y_min = b->y_min; y_max = b->y_max;
+    z_min = b->z_min; z_max = b->z_max;
+}
+
+/* =========================================================
+ *  Таблица имён типов PLY
+ * ========================================================= */
+static const struct {
+    const char *name;
+    ply_type    type;
+} ply_type_names[] = {
+    {"char",    PLY_CHAR},   {"int8",    PLY_CHAR},
+    {"uchar",   PLY_UCHAR},  {"uint8",   PLY_UCHAR},
+    {"short",   PLY_SHORT},  {"int16",   PLY_SHORT},
+    {"ushort",  PLY_USHORT}, {"uint16",  PLY_USHORT},
+    {"int",     PLY_INT},    {"int32",   PLY_INT},
+    {"uint",    PLY_UINT},   {"uint32",  PLY_UINT},
+    {"float",   PLY_FLOAT},  {"float32", PLY_FLOAT},
+    {"double",  PLY_DOUBLE}, {"float64", PLY_DOUBLE},
+};
+
+int ply_type_size(ply_type type)
+{
+    switch (type) {
+    case PLY_CHAR:  case PLY_UCHAR:  return 1;
+    case PLY_SHORT: case PLY_USHORT: return 2;
+    case PLY_INT:   case PLY_UINT:   case PLY_FLOAT: return 4;
+    case PLY_DOUBLE: return 8;
+    }
+    return 0;
+}
+
+static bool ply_type_from_name(const char *name, ply_type *type)
+{
+    for (size_t i = 0; i < sizeof(ply_type_names) / sizeof(ply_type_names[0]); i++) {
+        if (!strcmp(name, ply_type_names[i].name)) {
+            *type = ply_type_names[i].type;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* =========================================================
+ *  ply_parse_header
+ *  Разбирает заголовок построчно прямо из отображённого
+ *  буфера. Строки могут заканчиваться как "\n", так и "\r\n".
+ * ========================================================= */
+bool ply_parse_header(const char *data, size_t size, ply_header *header)
+{
+    memset(header, 0, sizeof(*header));
+
+    size_t pos        = 0;
+    bool   got_magic  = false;
+    bool   got_format = false;
+
+    while (pos < size) {
+        const char *eol = memchr(data + pos, '\n', size - pos);
+        if (eol == NULL) return false; /* заголовок оборван */
+
+        size_t len = (size_t)(eol - (data + pos));
+        char   line[256];
+        if (len >= sizeof(line)) len = sizeof(line) - 1;
+        memcpy(line, data + pos, len);
+        if (len > 0 && line[len - 1] == '\r') len--;
+        line[len] = '\0';
+        pos = (size_t)(eol - data) + 1;
+
+        if (!got_magic) {
+            if (strcmp(line, "ply")) return false;
+            got_magic = true;
+            continue;
+        }
+
+        char kw[PLY_NAME_LEN], a[PLY_NAME_LEN], b[PLY_NAME_LEN], c[PLY_NAME_LEN];
+        int  fields = sscanf(line, "%31s %31s %31s %31s", kw, a, b, c);
+        if (fields <= 0) continue;
+
+        if (!strcmp(kw, "format") && fields >= 2) {
+            if      (!strcmp(a, "ascii"))                header->format = PLY_ASCII;
+            else if (!strcmp(a, "binary_little_endian")) header->format = PLY_BINARY_LE;
+            else if (!strcmp(a, "binary_big_endian"))    header->format = PLY_BINARY_BE;
+            else return false;
+            got_format = true;
+        } else if (!strcmp(kw, "element") && fields >= 3) {
+            if (header->element_count >= PLY_MAX_ELEMENTS) return false;
+            ply_element *el = &header->elements[header->element_count++];
+            strcpy(el->name, a);
+            el->count = atol(b);
+            if (el->count < 0) return false;
+        } else if (!strcmp(kw, "property") && fields >= 3) {
+            if (header->element_count == 0) return false;
+            ply_element *el = &header->elements[header->element_count - 1];
+            if (el->prop_count >= PLY_MAX_PROPERTIES) return false;
+            ply_property *p = &el->props[el->prop_count++];
+
+            if (!strcmp(a, "list")) {
+                if (fields < 4) return false;
+                /* property list <count_type> <item_type> <name> */
+                char name[PLY_NAME_LEN];
+                if (sscanf(line, "%*s %*s %*s %*s %31s", name) != 1) return false;
+                if (!ply_type_from_name(b, &p->count_type)) return false;
+                if (!ply_type_from_name(c, &p->type))       return false;
+                strcpy(p->name, name);
+                p->is_list = true;
+            } else {
+                if (!ply_type_from_name(a, &p->type)) return false;
+                strcpy(p->name, b);
+            }
+        } else if (!strcmp(kw, "end_header")) {
+            if (!got_format) return false;
+            header->data_offset = pos;
+            break;
+        }
+        /* comment / obj_info и прочие строки пропускаются */
+    }
+
+    if (header->data_offset == 0) return false;
+
+    /* Смещения свойств внутри binary-записи; после первого list — неизвестны */
+    for (int e = 0; e < header->element_count; e++) {
+        ply_element *el = &header->elements[e];
+        int off = 0;
+        for (int p = 0; p < el->prop_count; p++) {
+            if (off < 0 || el->props[p].is_list) {
+                el->props[p].offset = -1;
+                off = -1;
+                continue;
+            }
+            el->props[p].offset = off;
+            off += ply_type_size(el->props[p].type);
+        }
+        el->stride = off;
+    }
+    return true;
+}
+
+int ply_find_element(const ply_header *header, const char *name)
+{
+    for (int i = 0; i < header->element_count; i++) {
+        if (!strcmp(header->elements[i].name, name)) return i;
+    }
+    return -1;
+}
+
+int ply_find_property(const ply_element *elem, const char *name)
+{
+    for (int i = 0; i < elem->prop_count; i++) {
+        if (!strcmp(elem->props[i].name, name)) return i;
+    }
+    return -1;
+}
+
+/* =========================================================
+ *  ply_map_file / ply_unmap_file
+ *  Отображение файла в память только для чтения. Ядро само
+ *  подкачивает страницы, поэтому загрузка упирается в диск,
+ *  а не в буферизацию stdio.
+ * ========================================================= */
+#ifdef _WIN32
+const char *ply_map_file(const char *filename, size_t *size)
+{
+    HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) return NULL;
+
+    LARGE_INTEGER len;
+    if (!GetFileSizeEx(file, &len) || len.QuadPart == 0) {
+        CloseHandle(file);
+        return NULL;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (mapping == NULL) return NULL;
+
+    const char *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping); /* представление удерживает отображение само */
+    if (data == NULL) return NULL;
+
+    *size = (size_t)len.QuadPart;
+    return data;
+}
+
+void ply_unmap_file(const char *data, size_t size)
+{
+    (void)size;
+    if (data != NULL) UnmapViewOfFile(data);
+}
+#else
+const char *ply_map_file(const char *filename, size_t *size)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return NULL;
+    }
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); /* отображение остаётся валидным после закрытия дескриптора */
+    if (data == MAP_FAILED) return NULL;
+
+    posix_madvise(data, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+    *size = (size_t)st.st_size;
+    return data;
+}
+
+void ply_unmap_file(const char *data, size_t size)
+{
+    if (data != NULL) munmap((void *)data, size);
+}
+#endif
+
+/* =========================================================
+ *  Чтение скалярных значений из binary-записи
+ * ========================================================= */
+static void bswap_bytes(unsigned char *b, int n)
+{
+    for (int i = 0; i < n / 2; i++) {
+        unsigned char t = b[i];
+        b[i]         = b[n - 1 - i];
+        b[n - 1 - i] = t;
+    }
+}
+
+/** Считывает значение типа @p type по адресу @p p (без требований к выравниванию). */
+static double ply_read_scalar(const unsigned char *p, ply_type type, bool swap)
+{
+    unsigned char b[8];
+    int n = ply_type_size(type);
+    memcpy(b, p, n);
+    if (swap) bswap_bytes(b, n);
+
+    switch (type) {
+    case PLY_CHAR:   { int8_t   v; memcpy(&v, b, 1); return v; }
+    case PLY_UCHAR:  { uint8_t  v; memcpy(&v, b, 1); return v; }
+    case PLY_SHORT:  { int16_t  v; memcpy(&v, b, 2); return v; }
+    case PLY_USHORT: { uint16_t v; memcpy(&v, b, 2); return v; }
+    case PLY_INT:    { int32_t  v; memcpy(&v, b, 4); return v; }
+    case PLY_UINT:   { uint32_t v; memcpy(&v, b, 4); return v; }
+    case PLY_FLOAT:  { float    v; memcpy(&v, b, 4); return v; }
+    case PLY_DOUBLE: { double   v; memcpy(&v, b, 8); return v; }
+    }
+    return 0.0;
+}
+
+/* =========================================================
+ *  verts_from_ply_binary
+ *  Читает XYZ прямо из отображённого блока вершин, шагая по
+ *  записям с размером stride из заголовка. Прочие свойства
+ *  (нормали, цвет, confidence) просто перешагиваются.
+ * ========================================================= */
+static vx_status verts_from_ply_binary(const char *data, size_t size, const ply_header *h,
+                                       vx_bounds *b, int *count, Vector3 **out, vx_error *err)
+{
+    int ve = ply_find_element(h, "vertex");
+    if (ve < 0) return vx_fail(err, VX_ERR_FORMAT, "В PLY-файле нет element vertex");
+
+    /* Смещение блока вершин: все предшествующие элементы должны иметь фиксированный размер */
+    size_t block = h->data_offset;
+    for (int e = 0; e < ve; e++) {
+        if (h->elements[e].stride < 0) {
+            return vx_fail(err, VX_ERR_FORMAT,
+                            "Элемент %s перед vertex содержит list — пропустить его нельзя",
+                            h->elements[e].name);
+        }
+        block += (size_t)h->elements[e].stride * (size_t)h->elements[e].count;
+    }
+
+    const ply_element *el = &h->elements[ve];
+    const char *axis[3]   = {"x", "y", "z"};
+    int         off[3];
+    ply_type    type[3];
+    for (int a = 0; a < 3; a++) {
+        int p = ply_find_property(el, axis[a]);
+        if (p < 0 || el->props[p].offset < 0) {
+            return vx_fail(err, VX_ERR_FORMAT, "У element vertex нет скалярного свойства %s",
+                            axis[a]);
+        }
+        off[a]  = el->props[p].offset;
+        type[a] = el->props[p].type;
+    }
+    if (el->stride < 0) {
+        return vx_fail(err, VX_ERR_FORMAT,
+                        "element vertex содержит list-свойства — формат не поддерживается");
+    }
+
+    size_t stride = (size_t)el->stride;
+    size_t n      = (size_t)el->count;
+    if (block > size || n > (size - block) / (stride ? stride : 1)) {
+        return vx_fail(err, VX_ERR_TRUNCATED, "PLY-файл обрезан: блок вершин выходит за конец файла");
+    }
+
+    Vector3 *verties = malloc((n ? n : 1) * sizeof(Vector3));
+    assert(verties != NULL);
+
+    float mn[3] = { FLT_MAX,  FLT_MAX,  FLT_MAX};
+    float mx[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+
+    bool swap = (h->format == PLY_BINARY_LE) != ply_host_little_endian();
+    const unsigned char *rec = (const unsigned char *)data + block;
+
+    if (!swap && type[0] == PLY_FLOAT && type[1] == PLY_FLOAT && type[2] == PLY_FLOAT) {
+        /* Частый случай: float32 в родном порядке байт — только memcpy */
+        for (size_t i = 0; i < n; i++, rec += stride) {
+            Vector3 v;
+            memcpy(&v.x, rec + off[0], sizeof(float));
+            memcpy(&v.y, rec + off[1], sizeof(float));
+            memcpy(&v.z, rec + off[2], sizeof(float));
+            verties[i] = v;
+        }
+    } else {
+        for (size_t i = 0; i < n; i++, rec += stride) {
+            Vector3 v = {
+                (float)ply_read_scalar(rec + off[0], type[0], swap),
+                (float)ply_read_scalar(rec + off[1], type[1], swap),
+                (float)ply_read_scalar(rec + off[2], type[2], swap),
+            };
+            verties[i] = v;
+        }
+    }
+
+    vx_minmax_aos(verties, (int)n, mn, mx);
+    if (n > 0) *b = (vx_bounds){mn[0], mx[0], mn[1], mx[1], mn[2], mx[2]};
+    *count = (int)n;
+    *out   = verties;
+    return VX_OK;
+}
+
+/* =========================================================
+ *  ply_strtof
+ *  Разбор десятичного числа без локали и без выделения памяти.
+ *  Мантисса набирается в uint64 (до 19 значащих цифр), затем
+ *  масштабируется степенью 10 из таблицы: при |exp| <= 22 и
+ *  мантиссе < 2^53 результат в double точен (быстрый путь Клингера).
+ * ========================================================= */
+static const double pow10_table[23] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+static bool is_digit(char c) { return (unsigned)(c - '0') < 10u; }
+
+static bool match_word(const char *s, const char *end, const char *word)
+{
+    for (; *word; s++, word++) {
+        if (s >= end || (*s | 0x20) != *word) return false;
+    }
+    return true;
+}
+
+const char *ply_strtof(const char *p, const char *end, float *out)
+{
+    const char *s   = p;
+    bool        neg = false;
+    if (s < end && (*s == '-' || *s == '+')) neg = (*s++ == '-');
+
+    uint64_t mant   = 0;
+    int      digits = 0;    /* значащие цифры в mant */
+    int      exp10  = 0;
+    bool     any    = false;
+
+    for (; s < end && is_digit(*s); s++) {
+        any = true;
+        if (digits < 19) {
+            mant = mant * 10 + (uint64_t)(*s - '0');
+            if (mant != 0) digits++;
+        } else {
+            exp10++;
+        }
+    }
+    if (s < end && *s == '.') {
+        for (s++; s < end && is_digit(*s); s++) {
+            any = true;
+            if (digits < 19) {
+                mant = mant * 10 + (uint64_t)(*s - '0');
+                if (mant != 0) digits++;
+                exp10--;
+            }
+        }
+    }
+
+    if (!any) {
+        /* inf / nan — допускаются для совместимости с выгрузками сканеров */
+        if (match_word(s, end, "inf")) {
+            *out = neg ? -HUGE_VALF : HUGE_VALF;
+            s += 3;
+            if (match_word(s, end, "inity")) s += 5;
+            return s;
+        }
+        if (match_word(s, end, "nan")) {
+            *out = NAN;
+            return s + 3;
+        }
+        return NULL;
+    }
+
+    if (s < end && (*s == 'e' || *s == 'E')) {
+        const char *e    = s + 1;
+        bool        eneg = false;
+        if (e < end && (*e == '-' || *e == '+')) eneg = (*e++ == '-');
+        if (e < end && is_digit(*e)) {
+            int ev = 0;
+            for (; e < end && is_digit(*e); e++) {
+                if (ev < 10000) ev = ev * 10 + (*e - '0');
+            }
+            exp10 += eneg ? -ev : ev;
+            s = e;
+        }
+    }
+
+    double v = (double)mant;
+    if (mant == 0) {
+        v = 0.0;
+    } else if (exp10 > 400) {
+        v = HUGE_VAL;
+    } else if (exp10 < -400) {
+        v = 0.0;
+    } else if (exp10 >= 0) {
+        while (exp10 > 22) { v *= 1e22; exp10 -= 22; }
+        v *= pow10_table[exp10];
+    } else {
+        while (exp10 < -22) { v /= 1e22; exp10 += 22; }
+        v /= pow10_table[-exp10];
+    }
+    *out = (float)(neg ? -v : v);
+    return s;
+}
+
+/* =========================================================
+ *  verts_from_ply_ascii_parallel
+ *  Тело файла режется на newline-выровненные куски по числу
+ *  потоков. Проход 1 считает строки в каждом куске (memchr),
+ *  префиксная сумма даёт номер первой строки куска. Проход 2
+ *  разбирает строки куска прямо в итоговый массив и считает
+ *  min/max куска; затем границы сливаются в глобальные.
+ * ========================================================= */
+typedef struct {
+    const char *begin;       /* начало куска (начало строки)          */
+    const char *end;         /* конец куска                           */
+    long        lines;       /* проход 1: строк в куске               */
+    long        first_line;  /* номер первой строки куска от data_offset */
+    float       mn[3];
+    float       mx[3];
+} ply_chunk;
+
+typedef struct {
+    ply_chunk *chunks;
+    Vector3   *out;
+    long       first_vertex; /* номер строки первой вершины           */
+    long       vertex_count;
+    int        col[3];       /* номера колонок x, y, z                */
+    int        last_col;     /* максимальная из колонок               */
+} ply_ascii_job;
+
+static void ply_count_lines_task(void *ctx, int task, int task_count)
+{
+    (void)task_count;
+    ply_ascii_job *job = ctx;
+    ply_chunk     *c   = &job->chunks[task];
+
+    long        lines = 0;
+    const char *s     = c->begin;
+    while (s < c->end) {
+        const char *nl = memchr(s, '\n', (size_t)(c->end - s));
+        if (nl == NULL) { lines++; break; } /* последняя строка без '\n' */
+        lines++;
+        s = nl + 1;
+    }
+    c->lines = lines;
+}
+
+static const char *skip_blanks(const char *s, const char *eol)
+{
+    while (s < eol && (*s == ' ' || *s == '\t' || *s == '\r')) s++;
+    return s;
+}
+
+/* Значения колонок col[0..count) из строки [s, eol) в out; прочие
+ * токены до last_col перешагиваются, недостающие значения — 0 */
+static void parse_line_columns(const char *s, const char *eol, const int *col, int count,
+                               int last_col, float *out)
+{
+    for (int k = 0; k < count; k++) out[k] = 0.0f;
+    for (int c = 0; c <= last_col; c++) {
+        s = skip_blanks(s, eol);
+        if (s >= eol) break;
+
+        int k = 0;
+        while (k < count && col[k] != c) k++;
+        const char *next = NULL;
+        if (k < count) next = ply_strtof(s, eol, &out[k]);
+        if (next == NULL) {
+            /* колонку не читаем — пропускаем токен */
+            next = s;
+            while (next < eol && *next != ' ' && *next != '\t' && *next != '\r') next++;
+        }
+        s = next;
+    }
+}
+
+/* x, y, z из строки вершины: колонки col[0..2] */
+static Vector3 parse_vertex_line(const char *s, const char *eol, const int col[3], int last_col)
+{
+    float xyz[3];
+    parse_line_columns(s, eol, col, 3, last_col, xyz);
+    return (Vector3){xyz[0], xyz[1], xyz[2]};
+}
+
+static void ply_parse_lines_task(void *ctx, int task, int task_count)
+{
+    (void)task_count;
+    ply_ascii_job *job = ctx;
+    ply_chunk     *c   = &job->chunks[task];
+
+    for (int a = 0; a < 3; a++) { c->mn[a] = FLT_MAX; c->mx[a] = -FLT_MAX; }
+
+    long        line = c->first_line;
+    const char *s    = c->begin;
+    while (s < c->end) {
+        const char *eol = memchr(s, '\n', (size_t)(c->end - s));
+        if (eol == NULL) eol = c->end;
+
+        long v = line - job->first_vertex;
+        if (v >= job->vertex_count) break;
+        if (v >= 0) job->out[v] = parse_vertex_line(s, eol, job->col, job->last_col);
+        line++;
+        s = eol + 1;
+    }
+
+    /* Вершины куска лежат в out подряд: границы — векторным ядром */
+    long first = c->first_line - job->first_vertex;
+    long last  = line - job->first_vertex;
+    if (first < 0) first = 0;
+    if (last > job->vertex_count) last = job->vertex_count;
+    if (last > first) vx_minmax_aos(job->out + first, (int)(last - first), c->mn, c->mx);
+}
+
+static vx_status verts_from_ply_ascii_parallel(const char *data, size_t size, const ply_header *h,
+                                               vx_bounds *b, int *count, Vector3 **out,
+                                               vx_error *err)
+{
+    int ve = ply_find_element(h, "vertex");
+    if (ve < 0) return vx_fail(err, VX_ERR_FORMAT, "В PLY-файле нет element vertex");
+
+    /* В ascii каждая запись — одна строка: пропускаем строки предыдущих элементов */
+    long first_vertex = 0;
+    for (int e = 0; e < ve; e++) first_vertex += h->elements[e].count;
+
+    const ply_element *el = &h->elements[ve];
+    ply_ascii_job job = {
+        .first_vertex = first_vertex,
+        .vertex_count = el->count,
+        .last_col     = 0,
+    };
+    const char *axis[3] = {"x", "y", "z"};
+    for (int a = 0; a < 3; a++) {
+        int p = ply_find_property(el, axis[a]);
+        if (p < 0) return vx_fail(err, VX_ERR_FORMAT, "У element vertex нет свойства %s", axis[a]);
+        for (int q = 0; q < p; q++) {
+            if (el->props[q].is_list) {
+                return vx_fail(err, VX_ERR_FORMAT,
+                                "list-свойство перед %s в element vertex не поддерживается",
+                                axis[a]);
+            }
+        }
+        job.col[a] = p;
+        if (p > job.last_col) job.last_col = p;
+    }
+
+    Vector3 *verties = malloc((el->count ? el->count : 1) * sizeof(Vector3));
+    assert(verties != NULL);
+    job.out = verties;
+
+    /* Режем тело на куски, выровненные по началу строки */
+    const char *body  = data + h->data_offset;
+    const char *end   = data + size;
+    size_t      len   = (size_t)(end - body);
+    int         tasks = vx_thread_count();
+    if ((size_t)tasks > len / 4096 + 1) tasks = (int)(len / 4096 + 1);
+
+    ply_chunk *chunks = calloc(tasks, sizeof(ply_chunk));
+    assert(chunks != NULL);
+    job.chunks = chunks;
+
+    const char *prev = body;
+    for (int t = 0; t < tasks; t++) {
+        const char *cut = (t == tasks - 1) ? end : body + len / tasks * (t + 1);
+        if (cut < prev) cut = prev;
+        if (cut < end) {
+            const char *nl = memchr(cut, '\n', (size_t)(end - cut));
+            cut = nl ? nl + 1 : end;
+        }
+        chunks[t].begin = prev;
+        chunks[t].end   = cut;
+        prev = cut;
+    }
+
+    vx_parallel_run(tasks, ply_count_lines_task, &job);
+    long line = 0;
+    for (int t = 0; t < tasks; t++) {
+        chunks[t].first_line = line;
+        line += chunks[t].lines;
+    }
+    if (line - first_vertex < el->count) {
+        free(chunks);
+        free(verties);
+        return vx_fail(err, VX_ERR_TRUNCATED, "PLY-файл обрезан: ожидалось %ld вершин, найдено %ld",
+                        el->count, line - first_vertex < 0 ? 0 : line - first_vertex);
+    }
+    vx_parallel_run(tasks, ply_parse_lines_task, &job);
+
+    if (el->count > 0) {
+        float mn[3] = { FLT_MAX,  FLT_MAX,  FLT_MAX};
+        float mx[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+        for (int t = 0; t < tasks; t++) {
+            for (int a = 0; a < 3; a++) {
+                mn[a] = chunks[t].mn[a] < mn[a] ? chunks[t].mn[a] : mn[a];
+                mx[a] = chunks[t].mx[a] > mx[a] ? chunks[t].mx[a] : mx[a];
+            }
+        }
+        *b = (vx_bounds){mn[0], mx[0], mn[1], mx[1], mn[2], mx[2]};
+    }
+    *count = (int)el->count;
+    *out   = verties;
+
+    free(chunks);
+    return VX_OK;
+}
+
+/* =========================================================
+ *  verts_from_ply_stdio
+ *  Построчный разбор текстового PLY через fgets/atof.
+ *  Эталонная однопоточная реализация — для сравнения в бенчмарке.
+ * ========================================================= */
+Vector3 *verts_from_ply_stdio(char *filename, Vector3 *verties)
+{
+    FILE *f = fopen(filename, "r");
+    if (f == NULL) {
+        printf("Файл не был открыт\n");
+        exit(EXIT_FAILURE);
+    }
+
+    char line[255];
+    int  counter     = 1;
+    int  vertex_num  = 0;
+    bool end_header  = false;
+    int  cycle_count = 100000; /* достаточно большое число */
+
+    while (fgets(line, sizeof(line), f) && counter < cycle_count) {
+
+        if (!strncmp(line, "element vertex", 14)) {
+            char *ptr_x = strchr(line, 'x');
+            if (ptr_x != NULL) {
+                ptr_x += 2;
+                vertex_num = atoi(ptr_x);
+            }
+        }
+
+        if (!strncmp(line, "end_header", 10)) {
+            end_header  = true;
+            cycle_count = counter + vertex_num;
+            verties     = malloc(vertex_num * sizeof(Vector3));
+            assert(verties != NULL);
+            continue;
+        }
+
+        counter++;
+
+        if (end_header) {
+            /* --- парсинг X --- */
+            verties[vert_count].x = atof(line);
+            if (verties[vert_count].x > x_max) x_max = verties[vert_count].x;
+            if (verties[vert_count].x < x_min) x_min = verties[vert_count].x;
+
+            /* --- парсинг Y --- */
+            char *ptr_line = strchr(line, ' ');
+            if (ptr_line == NULL) { vert_count++; continue; }
+            ++ptr_line;
+            verties[vert_count].y = atof(ptr_line);
+            if (verties[vert_count].y > y_max) y_max = verties[vert_count].y;
+            if (verties[vert_count].y < y_min) y_min = verties[vert_count].y;
+
+            /* --- парсинг Z --- */
+            ptr_line = strchr(ptr_line, ' ');
+            if (ptr_line == NULL) { vert_count++; continue; }
+            ++ptr_line;
+            verties[vert_count].z = atof(ptr_line);
+            if (verties[vert_count].z > z_max) z_max = verties[vert_count].z;
+            if (verties[vert_count].z < z_min) z_min = verties[vert_count].z;
+
+            vert_count++;
+        }
+    }
+
+    fclose(f);
+    return verties;
+}
+
+/* =========================================================
+ *  load_ply
+ *  Определяет формат по заголовку и выбирает загрузчик:
+ *  binary — чтение из отображения, ascii — параллельный разбор
+ *  того же отображения по кускам. Границы пишутся в b, только
+ *  если вершины есть.
+ * ========================================================= */
+static vx_status load_ply(const char *filename, vx_bounds *b, int *count, Vector3 **out,
+                          vx_error *err)
+{
+    size_t      size = 0;
+    const char *data = ply_map_file(filename, &size);
+    if (data == NULL) return vx_fail(err, VX_ERR_OPEN, "Файл не был открыт: %s", filename);
+
+    ply_header h;
+    if (!ply_parse_header(data, size, &h)) {
+        ply_unmap_file(data, size);
+        return vx_fail(err, VX_ERR_HEADER, "Некорректный заголовок PLY: %s", filename);
+    }
+
+    vx_status st;
+    if (h.format == PLY_ASCII) {
+        st = verts_from_ply_ascii_parallel(data, size, &h, b, count, out, err);
+    } else {
+        st = verts_from_ply_binary(data, size, &h, b, count, out, err);
+    }
+    ply_unmap_file(data, size);
+    return st;
+}
+
+Vector3 *verts_from_ply(char *filename, Vector3 *verties)
+{
+    vx_bounds b = vx_global_bounds();
+    vx_error  err;
+    /* массив всегда выделяется заново */
+    if (load_ply(filename, &b, &vert_count, &verties, &err) != VX_OK) {
+        printf("%s\n", err.message);
+        exit(EXIT_FAILURE);
+    }
+    vx_set_global_bounds(&b);
+    return verties;
+}
+
+vx_status vx_ctx_load_ply(vx_ctx *ctx, const char *filename)
+{
+    vx_stats stats = ctx->stats; /* замеры переживают смену модели */
+    vx_ctx_free(ctx);
+    ctx->stats = stats;
+
+    vx_status st = VX_OK;
+    VX_STATS_SCOPE(&ctx->stats, VX_STAGE_PARSE) {
+        st = load_ply(filename, &ctx->bounds, &ctx->vert_count, &ctx->vertices, &ctx->error);
+    }
+    if (st != VX_OK) return st; /* загрузчики пишут вершины и границы только при успехе */
+    ctx->owns_vertices = true;
+    return VX_OK;
+}
+
+/* =========================================================
+ *  faces_from_ply
+ *  Читает element face: список индексов каждой грани
+ *  (vertex_indices или vertex_index) разбивается веером на
+ *  треугольники (a, b, c), (a, c, d), ... Прочие свойства
+ *  граней перешагиваются. Индексы проверяются по числу
+ *  вершин из заголовка.
+ * ========================================================= */
+
+/* Грань из n индексов -> n - 2 треугольника */
+static vx_status push_polygon(vx_trilist *t, const int *idx, long n, long vertex_count,
+                              vx_error *err)
+{
+    for (long k = 0; k < n; k++) {
+        if (idx[k] < 0 || idx[k] >= vertex_count) {
+            return vx_fail(err, VX_ERR_DATA, "Индекс вершины %d вне диапазона [0, %ld)",
+                            idx[k], vertex_count);
+        }
+    }
+    for (long k = 2; k < n; k++) {
+        vx_tri tri = {{idx[0], idx[k - 1], idx[k]}};
+        da_append(t, tri);
+    }
+    return VX_OK;
+}
+
+/* Целое из ascii-тела; NULL, если числа нет */
+static const char *parse_long(const char *s, const char *end, long *out)
+{
+    bool neg = false;
+    if (s < end && (*s == '-' || *s == '+')) neg = (*s++ == '-');
+    if (s >= end || !is_digit(*s)) return NULL;
+    long v = 0;
+    for (; s < end && is_digit(*s); s++) v = v * 10 + (*s - '0');
+    *out = neg ? -v : v;
+    return s;
+}
+
+/* Свойство индексов грани; -1, если его нет */
+static int face_index_property(const ply_element *el)
+{
+    int p = ply_find_property(el, "vertex_indices");
+    if (p < 0) p = ply_find_property(el, "vertex_index");
+    return p >= 0 && el->props[p].is_list ? p : -1;
+}
+
+static vx_status no_index_property(vx_error *err)
+{
+    return vx_fail(err, VX_ERR_FORMAT, "У element face нет list-свойства vertex_indices");
+}
+
+static vx_status faces_binary(const char *data, size_t size, const ply_header *h, int fe,
+                              long vertex_count, vx_trilist *t, vx_error *err)
+{
+    size_t block = h->data_offset;
+    for (int e = 0; e < fe; e++) {
+        if (h->elements[e].stride < 0) {
+            return vx_fail(err, VX_ERR_FORMAT,
+                            "Элемент %s перед face содержит list — пропустить его нельзя",
+                            h->elements[e].name);
+        }
+        block += (size_t)h->elements[e].stride * (size_t)h->elements[e].count;
+    }
+
+    const ply_element   *el   = &h->elements[fe];
+    int                  ip   = face_index_property(el);
+    if (ip < 0) return no_index_property(err);
+    bool                 swap = (h->format == PLY_BINARY_LE) != ply_host_little_endian();
+    const unsigned char *rec  = (const unsigned char *)data + block;
+    const unsigned char *end  = (const unsigned char *)data + size;
+
+    int       *idx     = NULL;
+    long       idx_cap = 0;
+    vx_status  st      = VX_OK;
+    for (long f = 0; f < el->count && st == VX_OK; f++) {
+        for (int p = 0; p < el->prop_count && st == VX_OK; p++) {
+            const ply_property *pr = &el->props[p];
+            if (!pr->is_list) {
+                rec += ply_type_size(pr->type);
+                continue;
+            }
+            int cs = ply_type_size(pr->count_type), is = ply_type_size(pr->type);
+            if (rec > end || (size_t)(end - rec) < (size_t)cs) {
+                st = VX_ERR_TRUNCATED;
+                break;
+            }
+            long n = (long)ply_read_scalar(rec, pr->count_type, swap);
+            rec += cs;
+            if (n < 0 || n > (long)((size_t)(end - rec) / (size_t)is)) {
+                st = VX_ERR_TRUNCATED;
+                break;
+            }
+            if (p == ip) {
+                if (n > idx_cap) {
+                    idx_cap = n;
+                    idx     = realloc(idx, (size_t)idx_cap * sizeof(int));
+                    assert(idx != NULL);
+                }
+                for (long k = 0; k < n; k++) idx[k] = (int)ply_read_scalar(rec + k * is, pr->type, swap);
+                st = push_polygon(t, idx, n, vertex_count, err);
+            }
+            rec += (size_t)n * (size_t)is;
+        }
+        if (st == VX_OK && rec > end) st = VX_ERR_TRUNCATED;
+    }
+    free(idx);
+    if (st == VX_ERR_TRUNCATED) {
+        return vx_fail(err, st, "PLY-файл обрезан: блок граней выходит за конец файла");
+    }
+    return st;
+}
+
+static vx_status faces_ascii(const char *data, size_t size, const ply_header *h, int fe,
+                             long vertex_count, vx_trilist *t, vx_error *err)
+{
+    /* Каждая запись — одна строка: пропускаем строки предыдущих элементов */
+    const char *s   = data + h->data_offset;
+    const char *end = data + size;
+    for (int e = 0; e < fe; e++) {
+        for (long r = 0; r < h->elements[e].count && s < end; r++) {
+            const char *nl = memchr(s, '\n', (size_t)(end - s));
+            s = nl ? nl + 1 : end;
+        }
+    }
+
+    const ply_element *el = &h->elements[fe];
+    int                ip = face_index_property(el);
+    if (ip < 0) return no_index_property(err);
+
+    int       *idx     = NULL;
+    long       idx_cap = 0;
+    vx_status  st      = VX_OK;
+    for (long f = 0; f < el->count && st == VX_OK; f++) {
+        if (s >= end) {
+            st = vx_fail(err, VX_ERR_TRUNCATED, "PLY-файл обрезан: ожидалось %ld граней, найдено %ld",
+                          el->count, f);
+            break;
+        }
+        const char *eol = memchr(s, '\n', (size_t)(end - s));
+        if (eol == NULL) eol = end;
+
+        const char *c = s;
+        for (int p = 0; p < el->prop_count && st == VX_OK; p++) {
+            const ply_property *pr = &el->props[p];
+            long n = 1;
+            if (pr->is_list) {
+                c = parse_long(skip_blanks(c, eol), eol, &n);
+                if (c == NULL || n < 0) {
+                    st = vx_fail(err, VX_ERR_DATA, "Некорректная строка грани %ld", f);
+                    break;
+                }
+            }
+            if (p == ip && n > idx_cap) {
+                idx_cap = n;
+                idx     = realloc(idx, (size_t)idx_cap * sizeof(int));
+                assert(idx != NULL);
+            }
+            for (long k = 0; k < n; k++) {
+                c = skip_blanks(c, eol);
+                if (p == ip) {
+                    long v;
+                    c = parse_long(c, eol, &v);
+                    if (c == NULL) {
+                        st = vx_fail(err, VX_ERR_DATA, "Некорректная строка грани %ld", f);
+                        break;
+                    }
+                    idx[k] = (int)v;
+                } else {
+                    while (c < eol && *c != ' ' && *c != '\t' && *c != '\r') c++;
+                }
+            }
+            if (st == VX_OK && p == ip) st = push_polygon(t, idx, n, vertex_count, err);
+        }
+        s = eol + 1;
+    }
+    free(idx);
+    return st;
+}
+
+vx_status faces_from_ply(const char *filename, vx_trilist *t, vx_error *err)
+{
+    *t = (vx_trilist){0};
+    size_t      size = 0;
+    const char *data = ply_map_file(filename, &size);
+    if (data == NULL) return vx_fail(err, VX_ERR_OPEN, "Файл не был открыт: %s", filename);
+
+    ply_header h;
+    if (!ply_parse_header(data, size, &h)) {
+        ply_unmap_file(data, size);
+        return vx_fail(err, VX_ERR_HEADER, "Некорректный заголовок PLY: %s", filename);
+    }
+
+    vx_status st = VX_OK;
+    int       ve = ply_find_element(&h, "vertex");
+    int       fe = ply_find_element(&h, "face");
+    if (ve >= 0 && fe >= 0) {
+        long vertex_count = h.elements[ve].count;
+        /* Ёмкость — по числу граней: чаще всего они треугольные */
+        t->capacity = h.elements[fe].count > 0 ? (int)h.elements[fe].count : 1;
+        t->items    = malloc((size_t)t->capacity * sizeof(vx_tri));
+        assert(t->items != NULL);
+        if (h.format == PLY_ASCII) st = faces_ascii(data, size, &h, fe, vertex_count, t, err);
+        else                       st = faces_binary(data, size, &h, fe, vertex_count, t, err);
+    }
+    ply_unmap_file(data, size);
+    if (st != VX_OK) free_trilist(t);
+    return st;
+}
+
+void free_trilist(vx_trilist *t)
+{
+    free(t->items);
+    *t = (vx_trilist){0};
+}
+
+/* =========================================================
+ *  ply_stream
+ *  Вершины читаются через буфер постоянного размера: в памяти
+ *  не больше одного буфера файла и одного куска вершин, сколько
+ *  бы их ни было в файле. Binary — записи по stride, ascii —
+ *  строки, разбираемые тем же кодом, что и в
+ *  verts_from_ply_ascii_parallel. Буфер хранит непрочитанный
+ *  хвост [pos, len); при нехватке хвост сдвигается в начало и
+ *  дочитывается.
+ * ========================================================= */
+#define PLY_STREAM_BUFFER (4 << 20)
+
+#ifdef _WIN32
+#define ply_fseek _fseeki64
+#else
+#define ply_fseek fseeko
+#endif
+
+/* Свойства вершины: x, y, z, затем необязательные цвет и нормаль */
+#define PLY_STREAM_PROPS 9
+
+static const char *ply_stream_names[PLY_STREAM_PROPS] = {
+    "x", "y", "z", "red", "green", "blue", "nx", "ny", "nz",
+};
+
+struct ply_stream {
+    FILE       *file;
+    ply_header  header;
+    bool        ascii;
+    int         attrs;      /* PLY_ATTR_*, найденные в заголовке             */
+    long        count;      /* вершин в файле                              */
+    long        done;       /* выдано с начала прохода                     */
+    long long   start;      /* binary: блок вершин; ascii: начало тела     */
+    long        skip_lines; /* ascii: строк других элементов перед вершинами */
+    long        skip_left;  /* ascii: сколько из них ещё пропустить        */
+    int         off[PLY_STREAM_PROPS];  /* binary: смещения в записи       */
+    ply_type    type[PLY_STREAM_PROPS];
+    int         stride;
+    bool        swap;
+    int         col[PLY_STREAM_PROPS];  /* ascii: колонки (-1 — нет)       */
+    int         last_col;
+    float       color_scale; /* 255 для цвета в float/double, иначе 1      */
+    char       *buf;
+    size_t      len;
+    size_t      pos;
+    vx_error    error;       /* первая ошибка; дальше ply_stream_read даёт -1 */
+};
+
+/* Сдвигает хвост в начало буфера и дочитывает файл; 0 — конец файла */
+static size_t stream_fill(ply_stream *s)
+{
+    memmove(s->buf, s->buf + s->pos, s->len - s->pos);
+    s->len -= s->pos;
+    s->pos  = 0;
+    size_t got = fread(s->buf + s->len, 1, PLY_STREAM_BUFFER - s->len, s->file);
+    s->len += got;
+    return got;
+}
+
+/* Колонка свойства name или -1; свойство должно быть скалярным и (для
+ * binary) с известным смещением, list перед ним не допускается */
+static int stream_property(const ply_stream *s, const ply_element *el, const char *name)
+{
+    int p = ply_find_property(el, name);
+    if (p < 0 || el->props[p].is_list || (!s->ascii && el->props[p].offset < 0)) return -1;
+    for (int q = 0; q < p; q++) {
+        if (el->props[q].is_list) return -1;
+    }
+    return p;
+}
+
+/* Ошибка открытия: поток закрывается, код — в err */
+static ply_stream *stream_open_failed(ply_stream *s, vx_error *err)
+{
+    if (err != NULL) *err = s->error;
+    ply_stream_close(s);
+    return NULL;
+}
+
+ply_stream *ply_stream_open(const char *filename, long *vertex_count, vx_error *err)
+{
+    ply_stream *s = calloc(1, sizeof(ply_stream));
+    assert(s != NULL);
+    s->buf = malloc(PLY_STREAM_BUFFER);
+    assert(s->buf != NULL);
+
+    s->file = fopen(filename, "rb");
+    if (s->file == NULL) {
+        vx_fail(&s->error, VX_ERR_OPEN, "Файл не был открыт: %s", filename);
+        return stream_open_failed(s, err);
+    }
+
+    /* Заголовок целиком помещается в буфер */
+    stream_fill(s);
+    ply_header *h = &s->header;
+    if (!ply_parse_header(s->buf, s->len, h)) {
+        vx_fail(&s->error, VX_ERR_HEADER, "Некорректный заголовок PLY: %s", filename);
+        return stream_open_failed(s, err);
+    }
+
+    int ve = ply_find_element(h, "vertex");
+    if (ve < 0) {
+        vx_fail(&s->error, VX_ERR_FORMAT, "В PLY-файле нет element vertex");
+        return stream_open_failed(s, err);
+    }
+    const ply_element *el = &h->elements[ve];
+    s->count = el->count;
+    s->ascii = h->format == PLY_ASCII;
+    s->start = (long long)h->data_offset;
+
+    for (int k = 0; k < PLY_STREAM_PROPS; k++) {
+        int p = stream_property(s, el, ply_stream_names[k]);
+        if (p < 0 && k < 3) {
+            vx_fail(&s->error, VX_ERR_FORMAT, "У element vertex нет скалярного свойства %s",
+                     ply_stream_names[k]);
+            return stream_open_failed(s, err);
+        }
+        s->col[k]  = p;
+        s->off[k]  = p >= 0 ? el->props[p].offset : -1;
+        s->type[k] = p >= 0 ? el->props[p].type : PLY_FLOAT;
+    }
+    /* Цвет и нормаль учитываются, только если есть все три компоненты */
+    for (int group = 0; group < 2; group++) {
+        int *col = &s->col[3 + 3 * group];
+        if (col[0] >= 0 && col[1] >= 0 && col[2] >= 0) {
+            s->attrs |= group == 0 ? PLY_ATTR_COLOR : PLY_ATTR_NORMAL;
+        } else {
+            col[0] = col[1] = col[2] = -1;
+        }
+    }
+    for (int k = 0; k < PLY_STREAM_PROPS; k++) {
+        if (s->col[k] > s->last_col) s->last_col = s->col[k];
+    }
+    s->color_scale = s->type[3] == PLY_FLOAT || s->type[3] == PLY_DOUBLE ? 255.0f : 1.0f;
+
+    for (int e = 0; e < ve; e++) {
+        if (s->ascii) {
+            s->skip_lines += h->elements[e].count;
+        } else if (h->elements[e].stride < 0) {
+            vx_fail(&s->error, VX_ERR_FORMAT,
+                     "Элемент %s перед vertex содержит list — пропустить его нельзя",
+                     h->elements[e].name);
+            return stream_open_failed(s, err);
+        } else {
+            s->start += (long long)h->elements[e].stride * h->elements[e].count;
+        }
+    }
+    if (!s->ascii) {
+        if (el->stride < 0) {
+            vx_fail(&s->error, VX_ERR_FORMAT,
+                     "element vertex содержит list-свойства — формат не поддерживается");
+            return stream_open_failed(s, err);
+        }
+        s->stride = el->stride;
+        s->swap   = (h->format == PLY_BINARY_LE) != ply_host_little_endian();
+    }
+
+    if (ply_stream_rewind(s) != VX_OK) return stream_open_failed(s, err);
+    if (vertex_count) *vertex_count = s->count;
+    return s;
+}
+
+int ply_stream_attrs(const ply_stream *s)
+{
+    return s->attrs;
+}
+
+const vx_error *ply_stream_error(const ply_stream *s)
+{
+    return &s->error;
+}
+
+vx_status ply_stream_rewind(ply_stream *s)
+{
+    if (ply_fseek(s->file, s->start, SEEK_SET) != 0) {
+        return vx_fail(&s->error, VX_ERR_OPEN, "Не удалось перейти к вершинам PLY-файла");
+    }
+    s->len = s->pos = 0;
+    s->done      = 0;
+    s->skip_left = s->skip_lines;
+    return VX_OK;
+}
+
+/* ascii: следующая строка [*line, *eol); 1 — строка есть, 0 — файл
+ * кончился, -1 — строка длиннее буфера (ошибка в s->error) */
+static int stream_line(ply_stream *s, const char **line, const char **eol)
+{
+    const char *nl = memchr(s->buf + s->pos, '\n', s->len - s->pos);
+    if (nl == NULL) {
+        bool more = stream_fill(s) > 0;
+        nl = memchr(s->buf + s->pos, '\n', s->len - s->pos);
+        if (nl == NULL) {
+            if (s->len == PLY_STREAM_BUFFER) {
+                vx_fail(&s->error, VX_ERR_DATA, "Строка PLY длиннее буфера чтения");
+                return -1;
+            }
+            if (!more && s->len == s->pos) return 0;
+            nl = s->buf + s->len; /* последняя строка без '\n' */
+        }
+    }
+    *line  = s->buf + s->pos;
+    *eol   = nl;
+    s->pos = nl < s->buf + s->len ? (size_t)(nl - s->buf) + 1 : s->len;
+    return 1;
+}
+
+/* Раскладывает 9 значений вершины k по выходным массивам */
+static void stream_store(const ply_stream *s, const float *val, long k, Vector3 *out,
+                         Vector3 *color, Vector3 *normal)
+{
+    out[k] = (Vector3){val[0], val[1], val[2]};
+    if (color) {
+        float c = s->color_scale;
+        color[k] = (Vector3){val[3] * c, val[4] * c, val[5] * c};
+    }
+    if (normal) normal[k] = (Vector3){val[6], val[7], val[8]};
+}
+
+long ply_stream_read(ply_stream *s, Vector3 *out, long max)
+{
+    return ply_stream_read_attrs(s, out, NULL, NULL, max);
+}
+
+long ply_stream_read_attrs(ply_stream *s, Vector3 *out, Vector3 *color, Vector3 *normal, long max)
+{
+    if (s->error.status != VX_OK) return -1;
+    long n = s->count - s->done < max ? s->count - s->done : max;
+    long k = 0;
+    int  props = color || normal ? PLY_STREAM_PROPS : 3;
+
+    if (s->ascii) {
+        const char *line, *eol;
+        for (; s->skip_left > 0; s->skip_left--) {
+            int got = stream_line(s, &line, &eol);
+            if (got < 0) return -1;
+            if (got == 0) break;
+        }
+        int last = props == 3 ? 0 : s->last_col;
+        for (int p = 0; p < 3; p++) if (s->col[p] > last) last = s->col[p];
+        for (; k < n; k++) {
+            int got = stream_line(s, &line, &eol);
+            if (got < 0) return -1;
+            if (got == 0) break;
+            float val[PLY_STREAM_PROPS];
+            parse_line_columns(line, eol, s->col, props, last, val);
+            stream_store(s, val, k, out, color, normal);
+        }
+    } else {
+        size_t stride = (size_t)s->stride;
+        bool   fast   = props == 3 && !s->swap && s->type[0] == PLY_FLOAT &&
+                        s->type[1] == PLY_FLOAT && s->type[2] == PLY_FLOAT;
+        while (k < n) {
+            if (s->len - s->pos < stride && stream_fill(s) == 0) break;
+            long avail = (long)((s->len - s->pos) / (stride ? stride : 1));
+            long take  = n - k < avail ? n - k : avail;
+            const unsigned char *rec = (const unsigned char *)s->buf + s->pos;
+            for (long i = 0; i < take; i++, rec += stride) {
+                if (fast) {
+                    Vector3 v;
+                    memcpy(&v.x, rec + s->off[0], sizeof(float));
+                    memcpy(&v.y, rec + s->off[1], sizeof(float));
+                    memcpy(&v.z, rec + s->off[2], sizeof(float));
+                    out[k + i] = v;
+                    continue;
+                }
+                float val[PLY_STREAM_PROPS] = {0};
+                for (int p = 0; p < props; p++) {
+                    if (s->off[p] >= 0) val[p] = (float)ply_read_scalar(rec + s->off[p], s->type[p], s->swap);
+                }
+                stream_store(s, val, k + i, out, color, normal);
+            }
+            s->pos += (size_t)take * stride;
+            k      += take;
+        }
+    }
+
+    if (k < n) {
+        vx_fail(&s->error, VX_ERR_TRUNCATED, "PLY-файл обрезан: ожидалось %ld вершин, найдено %ld",
+                 s->count, s->done + k);
+        return -1;
+    }
+    s->done += k;
+    return k;
+}
+
+void ply_stream_close(ply_stream *s)
+{
+    if (s == NULL) return;
+    if (s->file != NULL) fclose(s->file);
+    free(s->buf);
+    free(s);
+}
@@ -0,0 +1,146 @@
+#ifndef PLY_H
+#define PLY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* =========================================================
+ *  Описание заголовка PLY-файла
+ * ========================================================= */
+
+/** Максимальное число элементов (vertex, face, ...) в заголовке. */
+#define PLY_MAX_ELEMENTS   8
+/** Максимальное число свойств у одного элемента. */
+#define PLY_MAX_PROPERTIES 32
+/** Максимальная длина имени элемента или свойства (включая '\0'). */
+#define PLY_NAME_LEN       32
+
+/**
+ * @brief Формат хранения данных после end_header.
+ */
+typedef enum {
+    PLY_ASCII,             /**< format ascii 1.0                */
+    PLY_BINARY_LE,         /**< format binary_little_endian 1.0 */
+    PLY_BINARY_BE,         /**< format binary_big_endian 1.0    */
+} ply_format;
+
+/**
+ * @brief Скалярные типы свойств PLY (включая синонимы int8/float32 и т.п.).
+ */
+typedef enum {
+    PLY_CHAR,    /**< char / int8     — 1 байт */
+    PLY_UCHAR,   /**< uchar / uint8   — 1 байт */
+    PLY_SHORT,   /**< short / int16   — 2 байта */
+    PLY_USHORT,  /**< ushort / uint16 — 2 байта */
+    PLY_INT,     /**< int / int32     — 4 байта */
+    PLY_UINT,    /**< uint / uint32   — 4 байта */
+    PLY_FLOAT,   /**< float / float32 — 4 байта */
+    PLY_DOUBLE,  /**< double / float64 — 8 байт */
+} ply_type;
+
+/**
+ * @brief Свойство элемента (например, x, y, z, red, nx, vertex_indices).
+ */
+typedef struct ply_property {
+    char     name[PLY_NAME_LEN]; /**< Имя свойства.                                   */
+    ply_type type;               /**< Тип значения (для list — тип элементов списка).  */
+    bool     is_list;            /**< true для "property list <count> <item> <name>".  */
+    ply_type count_type;         /**< Тип счётчика списка (только для is_list).         */
+    int      offset;             /**< Смещение внутри binary-записи (-1 после list).    */
+} ply_property;
+
+/**
+ * @brief Элемент PLY (vertex, face, ...) и его свойства.
+ */
+typedef struct ply_element {
+    char         name[PLY_NAME_LEN];             /**< Имя элемента.                       */
+    long         count;                          /**< Количество записей.                 */
+    ply_property props[PLY_MAX_PROPERTIES];      /**< Свойства в порядке объявления.      */
+    int          prop_count;                     /**< Количество свойств.                 */
+    int          stride;                         /**< Размер binary-записи; -1, если есть list. */
+} ply_element;
+
+/**
+ * @brief Разобранный заголовок PLY-файла.
+ */
+typedef struct ply_header {
+    ply_format  format;                          /**< Формат данных.                     */
+    size_t      data_offset;                     /**< Смещение первого байта после end_header. */
+    ply_element elements[PLY_MAX_ELEMENTS];      /**< Элементы в порядке объявления.     */
+    int         element_count;                   /**< Количество элементов.              */
+} ply_header;
+
+/* =========================================================
+ *  Разбор заголовка и отображение файла в память
+ * ========================================================= */
+
+/**
+ * @brief Разбирает заголовок PLY из буфера @p data длиной @p size.
+ *
+ * @param data   Начало файла (обычно — отображение через ply_map_file).
+ * @param size   Размер буфера в байтах.
+ * @param header [out] Разобранный заголовок.
+ * @return true при успехе; false, если заголовок повреждён или не поддерживается.
+ */
+bool ply_parse_header(const char *data, size_t size, ply_header *header);
+
+/**
+ * @brief Ищет элемент по имени.
+ *
+ * @return Индекс элемента или -1, если элемент не объявлен.
+ */
+int ply_find_element(const ply_header *header, const char *name);
+
+/**
+ * @brief Ищет свойство элемента по имени.
+ *
+ * @return Индекс свойства или -1, если свойство не объявлено.
+ */
+int ply_find_property(const ply_element *elem, const char *name);
+
+/**
+ * @brief Возвращает размер скалярного типа в байтах.
+ */
+int ply_type_size(ply_type type);
+
+/**
+ * @brief Порядок байт машины: true — little endian.
+ *
+ * Читатели по нему решают, переставлять ли байты binary-записи,
+ * писатели — какой binary-формат объявить в заголовке.
+ */
+static inline bool ply_host_little_endian(void)
+{
+    const uint16_t one = 1;
+    return *(const uint8_t *)&one == 1;
+}
+
+/**
+ * @brief Разбирает десятичное число с плавающей точкой.
+ *
+ * Не зависит от текущей локали и не выделяет память; понимает знак,
+ * дробную часть, экспоненту, а также inf/nan.
+ *
+ * @param p   Начало числа.
+ * @param end Конец буфера (за число не заходит).
+ * @param out [out] Разобранное значение.
+ * @return Указатель на первый символ после числа или NULL, если числа нет.
+ */
+const char *ply_strtof(const char *p, const char *end, float *out);
+
+/**
+ * @brief Отображает файл в память только для чтения.
+ *
+ * @param filename Путь к файлу.
+ * @param size     [out] Размер файла в байтах.
+ * @return Указатель на отображение или NULL при ошибке.
+ */
+const char *ply_map_file(const char *filename, size_t *size);
+
+/**
+ * @brief Снимает отображение, созданное ply_map_file.
+ */
+void ply_unmap_file(const char *data, size_t size);
+
+#endif /* PLY_H */
@@ -0,0 +1,113 @@
+/* =========================================================
+ *  ply_bench — пропускная способность разбора ASCII PLY
+ *
+ *  Сравнивает эталонный verts_from_ply_stdio (fgets + atof)
+ *  с параллельным разбором verts_from_ply при 1, 2, 4, ...
+ *  потоках и печатает МБ/с и ускорение.
+ *
+ *  Запуск:  ./ply-bench [число_точек] [файл.ply]
+ *  Без файла генерируется синтетическое облако во временном
+ *  файле ply_bench_tmp.ply (удаляется по завершении).
+ * ========================================================= */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "voxel.h"
+#include "vxsys.h"
+
+#define BENCH_TMP "ply_bench_tmp.ply"
+
+static void reset_bounds(void)
+{
+    x_max = 0; x_min = 10;
+    y_max = 0; y_min = 10;
+    z_max = 0; z_min = 10;
+    vert_count = 0;
+}
+
+/* Синтетический скан: точки на сфере + нормали, как в выгрузках сканеров */
+static void write_ascii_ply(const char *path, long n)
+{
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        printf("Не удалось создать %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+    fprintf(f, "ply\nformat ascii 1.0\nelement vertex %ld\n"
+               "property float x\nproperty float y\nproperty float z\n"
+               "property float nx\nproperty float ny\nproperty float nz\n"
+               "end_header\n", n);
+    unsigned int seed = 12345u;
+    for (long i = 0; i < n; i++) {
+        float v[3];
+        for (int a = 0; a < 3; a++) {
+            seed = seed * 1664525u + 1013904223u;
+            v[a] = (float)(seed >> 8) / 16777216.0f * 2.0f - 1.0f;
+        }
+        float len = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]) + 1e-6f;
+        fprintf(f, "%.6f %.6f %.6f %.4f %.4f %.4f\n",
+                0.1f * v[0] / len, 0.1f * v[1] / len, 0.1f * v[2] / len,
+                v[0] / len, v[1] / len, v[2] / len);
+    }
+    fclose(f);
+}
+
+static long file_size(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) return 0;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fclose(f);
+    return size;
+}
+
+int main(int argc, char **argv)
+{
+    long  n    = argc > 1 ? atol(argv[1]) : 2000000;
+    char *path = argc > 2 ? argv[2] : NULL;
+    bool  tmp  = path == NULL;
+
+    if (tmp) {
+        path = BENCH_TMP;
+        write_ascii_ply(path, n);
+    }
+    double mb = (double)file_size(path) / (1024.0 * 1024.0);
+
+    /* --- эталон --- */
+    reset_bounds();
+    double   t0  = vx_now();
+    Vector3 *ref = verts_from_ply_stdio(path, NULL);
+    double   ref_s = vx_now() - t0;
+    int      ref_n = vert_count;
+
+    printf("file: %s, %.1f MB, %d vertices\n", path, mb, ref_n);
+    printf("%-22s %8s %10s %8s %10s\n", "parser", "threads", "MB/s", "speedup", "max|diff|");
+    printf("%-22s %8d %10.1f %8.2f %10s\n", "stdio (fgets+atof)", 1, mb / ref_s, 1.0, "-");
+
+    int hw = vx_thread_count();
+    for (int t = 1; ; t *= 2) {
+        if (t > hw) t = hw;
+        vx_set_thread_count(t);
+        reset_bounds();
+
+        t0 = vx_now();
+        Vector3 *v = verts_from_ply(path, NULL);
+        double   s = vx_now() - t0;
+
+        double diff = vert_count == ref_n ? 0.0 : INFINITY;
+        for (int i = 0; i < ref_n && vert_count == ref_n; i++) {
+            double d = fabs(v[i].x - ref[i].x) + fabs(v[i].y - ref[i].y) + fabs(v[i].z - ref[i].z);
+            if (d > diff) diff = d;
+        }
+        printf("%-22s %8d %10.1f %8.2f %10.2g\n", "parallel (ply_strtof)", t, mb / s, ref_s / s, diff);
+        free(v);
+        if (t == hw) break;
+    }
+    vx_set_thread_count(0);
+
+    free(ref);
+    if (tmp) remove(path);
+    return 0;
+}
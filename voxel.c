@@ -0,0 +1,1076 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <math.h>
+#include <float.h>
+#include "voxel.h"
+#include "vxsys.h"
+#include "vxsimd.h"
+#include "vxmorton.h"
+#include "vxstats.h"
+
+/* =========================================================
+ *  make_voxel
+ *  Создаёт пустой воксель. Вершины вокселя живут в общем
+ *  буфере сетки — сам воксель хранит только offset и count.
+ * ========================================================= */
+Voxel make_voxel(int cap, float size)
+{
+    (void)cap; /* параметр оставлен для совместимости сигнатуры */
+    Voxel vx = {
+        .offset    = 0,
+        .count     = 0,
+        .vx_center = (Vector3){0.0f, 0.0f, 0.0f},
+        .size      = size,
+    };
+    return vx;
+}
+
+/* =========================================================
+ *  make_vxlist
+ *  Создаёт список вокселей заданной ёмкости.
+ *  calloc гарантирует, что у всех Voxel offset == 0 и
+ *  count == 0 — без дополнительной инициализации.
+ * ========================================================= */
+vxlist make_vxlist(int cap)
+{
+    Voxel *buf = calloc(cap, sizeof(Voxel));
+    assert(buf != NULL);
+    vxlist lst = {
+        .items       = buf,
+        .count       = 0,
+        .capacity    = cap,
+        .points      = NULL,
+        .point_count = 0,
+    };
+    return lst;
+}
+
+/* =========================================================
+ *  freeContainer
+ *  Освобождает общий буфер вершин, массив вокселей и
+ *  (для разреженной сетки) таблицу ячеек.
+ * ========================================================= */
+void freeContainer(vxlist *c)
+{
+    if (c == NULL) return;
+    vxhash_free(&c->cells);
+    free(c->occupied);
+    free(c->ranked);
+    c->occupied       = NULL;
+    c->ranked         = NULL;
+    c->occupied_count = 0;
+    free(c->points);
+    c->points      = NULL;
+    c->point_count = 0;
+    free(c->items);
+    c->items    = NULL;
+    c->count    = 0;
+    c->capacity = 0;
+}
+
+/* =========================================================
+ *  vxlist_bytes
+ * ========================================================= */
+size_t vxlist_bytes(const vxlist *c)
+{
+    return (size_t)c->capacity * sizeof(Voxel) +
+           (size_t)c->point_count * sizeof(Vector3) +
+           (size_t)c->occupied_count * 2 * sizeof(int) +
+           (size_t)c->cells.capacity * (sizeof(uint64_t) + sizeof(int));
+}
+
+/* =========================================================
+ *  normalize_verties
+ *  Нормализует координаты в диапазон [0, norm_factor] и
+ *  заменяет границы b нормализованными. Векторное ядро
+ *  работает прямо по массиву Vector3 (см. vx_normalize_aos).
+ * ========================================================= */
+static void normalize_aos(Vector3 *verties, int count, vx_bounds *b, float norm_factor)
+{
+    float mx[3] = {0, 0, 0};
+    float mn[3] = {norm_factor, norm_factor, norm_factor};
+    float lo[3] = {b->x_min, b->y_min, b->z_min};
+    float rg[3] = {b->x_max - b->x_min, b->y_max - b->y_min, b->z_max - b->z_min};
+
+    vx_normalize_aos(verties, count, lo, rg, norm_factor, mn, mx);
+    *b = (vx_bounds){mn[0], mx[0], mn[1], mx[1], mn[2], mx[2]};
+}
+
+void normalize_verties(Vector3 *verties, float norm_factor)
+{
+    vx_bounds b = vx_global_bounds();
+    normalize_aos(verties, vert_count, &b, norm_factor);
+    vx_set_global_bounds(&b);
+}
+
+/* =========================================================
+ *  make_soa / free_soa / soa_from_aos
+ * ========================================================= */
+vx_soa make_soa(int count)
+{
+    size_t n = count > 0 ? (size_t)count : 1;
+    vx_soa s = {
+        .x     = malloc(n * sizeof(float)),
+        .y     = malloc(n * sizeof(float)),
+        .z     = malloc(n * sizeof(float)),
+        .count = count,
+    };
+    assert(s.x != NULL && s.y != NULL && s.z != NULL);
+    return s;
+}
+
+void free_soa(vx_soa *s)
+{
+    if (s == NULL) return;
+    free(s->x);
+    free(s->y);
+    free(s->z);
+    s->x = s->y = s->z = NULL;
+    s->count = 0;
+}
+
+vx_soa soa_from_aos(const Vector3 *verties, int count)
+{
+    vx_soa s = make_soa(count);
+    for (int i = 0; i < count; i++) {
+        s.x[i] = verties[i].x;
+        s.y[i] = verties[i].y;
+        s.z[i] = verties[i].z;
+    }
+    return s;
+}
+
+/* =========================================================
+ *  normalize_verties_soa
+ * ========================================================= */
+void normalize_verties_soa(vx_soa *verties, float norm_factor)
+{
+    float mx[3] = {0, 0, 0};
+    float mn[3] = {norm_factor, norm_factor, norm_factor};
+
+    vx_normalize_axis(verties->x, verties->count, x_min, x_max - x_min, norm_factor, &mn[0], &mx[0]);
+    vx_normalize_axis(verties->y, verties->count, y_min, y_max - y_min, norm_factor, &mn[1], &mx[1]);
+    vx_normalize_axis(verties->z, verties->count, z_min, z_max - z_min, norm_factor, &mn[2], &mx[2]);
+
+    x_max = mx[0]; x_min = mn[0];
+    y_max = mx[1]; y_min = mn[1];
+    z_max = mx[2]; z_min = mn[2];
+}
+
+/* =========================================================
+ *  parallel_mesh
+ *  Заполняет mesh_vox вокселями равномерной сетки.
+ *  Воксели создаются пустыми (буфер вершин строится
+ *  позже в ind_finder).
+ * ========================================================= */
+void parallel_mesh(int voxel_num, vxlist *mesh_vox,
+                   float wall_w, float wall_h, float wall_l,
+                   float voxel_w, Vector3 start_pos)
+{
+    /*
+     * Выделяем сразу точный буфер под voxel_num вокселей через calloc —
+     * это гарантирует offset == 0 и count == 0 у каждого вокселя.
+     * Буфер вершин прежней раскладки больше не нужен.
+     */
+    free(mesh_vox->items);
+    free(mesh_vox->points);
+    free(mesh_vox->occupied);
+    free(mesh_vox->ranked);
+    mesh_vox->points         = NULL;
+    mesh_vox->point_count    = 0;
+    mesh_vox->occupied       = NULL;
+    mesh_vox->ranked         = NULL;
+    mesh_vox->occupied_count = 0;
+    mesh_vox->items    = calloc(voxel_num, sizeof(Voxel));
+    assert(mesh_vox->items != NULL);
+    mesh_vox->count    = voxel_num;
+    mesh_vox->capacity = voxel_num;
+
+    /* Геометрия сетки: n ячеек по оси, угол — на полвокселя от центра первой */
+    int n = (int)round(cbrt((double)voxel_num));
+    mesh_vox->nx      = n;
+    mesh_vox->ny      = n;
+    mesh_vox->nz      = n;
+    mesh_vox->voxel_w = voxel_w;
+    mesh_vox->origin  = (Vector3){start_pos.x - voxel_w * 0.5f,
+                                  start_pos.y - voxel_w * 0.5f,
+                                  start_pos.z - voxel_w * 0.5f};
+    mesh_vox->sparse  = false;
+    mesh_vox->morton  = false;
+
+    float cx = start_pos.x;
+    float cy = start_pos.y;
+    float cz = start_pos.z;
+
+    for (int i = 0; i < voxel_num; i++) {
+        mesh_vox->items[i].size        = voxel_w;
+        mesh_vox->items[i].vx_center.x = cx;
+        mesh_vox->items[i].vx_center.y = cy;
+        mesh_vox->items[i].vx_center.z = cz;
+        /* offset/count уже 0 благодаря calloc */
+
+        /* Шаг по X */
+        cx += voxel_w;
+        if (cx >= start_pos.x + wall_w - voxel_w * 0.5f) {
+            cx = start_pos.x;
+            cy += voxel_w;
+            if (cy >= start_pos.y + wall_h - voxel_w * 0.5f) {
+                cy = start_pos.y;
+                cz += voxel_w;
+                if (cz >= start_pos.z + wall_l - voxel_w * 0.5f) {
+                    cz = start_pos.z;
+                }
+            }
+        }
+    }
+}
+
+/* =========================================================
+ *  point_in_voxel
+ * ========================================================= */
+bool point_in_voxel(Voxel vx, Vector3 vert)
+{
+    float half = vx.size * 0.5f;
+    return (vert.x >= vx.vx_center.x - half && vert.x <= vx.vx_center.x + half &&
+            vert.y >= vx.vx_center.y - half && vert.y <= vx.vx_center.y + half &&
+            vert.z >= vx.vx_center.z - half && vert.z <= vx.vx_center.z + half);
+}
+
+/* =========================================================
+ *  ind_finder
+ *  Распределяет вершины по вокселям сортировкой подсчётом.
+ *  nx/ny/nz берутся из сетки (для плотной — кубический корень
+ *  voxel_num), чтобы гарантировать ind < voxel_num без
+ *  погрешностей float. Индексы ячеек плотной сетки считаются
+ *  векторным ядром vx_quantize блоками по VX_BIN_BLOCK вершин.
+ * ========================================================= */
+#define VX_BIN_BLOCK 512
+
+/* Источник вершин: массив Vector3 (AoS) либо vx_soa */
+typedef struct {
+    const Vector3 *aos;
+    const vx_soa  *soa;
+    int            count;
+} vx_src;
+
+static Vector3 src_point(const vx_src *s, int i)
+{
+    if (s->aos) return s->aos[i];
+    return (Vector3){s->soa->x[i], s->soa->y[i], s->soa->z[i]};
+}
+
+/* Индексы ячеек вершин [b, b + n), n <= VX_BIN_BLOCK; в сетке
+ * Мортона — коды Мортона ячеек (SoA — без перестановки в Vector3,
+ * то же квантование, что у vx_morton_cells) */
+static void src_cells(const vx_src *s, int b, int n, const vx_quant *q, bool morton,
+                      int32_t *out)
+{
+    if (morton) {
+        uint64_t code[VX_BIN_BLOCK];
+        if (s->aos) {
+            vx_morton_cells(s->aos + b, n, q, code);
+        } else {
+            const vx_soa *v = s->soa;
+            for (int k = 0; k < n; k++) {
+                code[k] = vx_morton_encode((uint32_t)vx_quantize_axis(v->x[b + k], q->inv_w, q->nx),
+                                           (uint32_t)vx_quantize_axis(v->y[b + k], q->inv_w, q->ny),
+                                           (uint32_t)vx_quantize_axis(v->z[b + k], q->inv_w, q->nz));
+            }
+        }
+        for (int k = 0; k < n; k++) out[k] = (int32_t)code[k];
+        return;
+    }
+    if (s->aos) vx_quantize_aos(s->aos + b, n, q, out);
+    else        vx_quantize(s->soa->x + b, s->soa->y + b, s->soa->z + b, n, q, out);
+}
+
+/* Линейный индекс ячейки в 64 битах (разреженная сетка) */
+static int64_t vx_cell_of(Vector3 p, float inv_w, int nx, int ny, int nz)
+{
+    int xi = vx_quantize_axis(p.x, inv_w, nx);
+    int yi = vx_quantize_axis(p.y, inv_w, ny);
+    int zi = vx_quantize_axis(p.z, inv_w, nz);
+    return (int64_t)zi * nx * ny + (int64_t)yi * nx + xi;
+}
+
+/* Префиксная сумма: offset каждого вокселя; count обнуляется и
+ * на проходе 2 служит курсором записи */
+static void vx_prefix_offsets(vxlist *mesh, int point_count, const vx_bin_opts *opts)
+{
+    int offset = 0;
+    for (int j = 0; j < mesh->count; j++) {
+        mesh->items[j].offset = offset;
+        offset += mesh->items[j].count;
+        mesh->items[j].count = 0;
+    }
+
+    free(mesh->points);
+    mesh->points      = malloc((point_count ? point_count : 1) * sizeof(Vector3));
+    assert(mesh->points != NULL);
+    mesh->point_count = point_count;
+    VX_STATS_ALLOC(opts->stats, (point_count ? point_count : 1) * sizeof(Vector3));
+}
+
+/* Отмена и прогресс (opts->cancel / opts->progress) */
+static bool bin_cancelled(const vx_bin_opts *opts)
+{
+    return opts->cancel != NULL && __atomic_load_n(opts->cancel, __ATOMIC_RELAXED) != 0;
+}
+
+/* done из total шагов; каждая вершина проходится дважды */
+static void bin_progress(const vx_bin_opts *opts, int64_t done, int64_t total)
+{
+    if (opts->progress == NULL || total <= 0) return;
+    __atomic_store_n(opts->progress, (int)(done * 1000 / total), __ATOMIC_RELAXED);
+}
+
+/* Шаг проверки отмены в последовательных проходах, вершин */
+#define VX_BIN_POLL 16384
+
+/* Выделения при росте удвоением (da_append, vxhash) от вместимости
+ * from до to: считаются по итогу, а не на каждой вершине */
+static void bin_stats_growth(const vx_bin_opts *opts, int from, int to, size_t elem)
+{
+    for (int64_t c = from ? 2 * (int64_t)from : 1; c <= to; c *= 2) {
+        VX_STATS_ALLOC(opts->stats, (size_t)c * elem);
+    }
+}
+
+/* =========================================================
+ *  vx_index_occupied
+ *  Список занятых вокселей и его упорядочение по count:
+ *  поразрядная (LSD, 8 бит) устойчивая сортировка — столько
+ *  проходов, сколько байт в наибольшем count.
+ * ========================================================= */
+static void vx_index_occupied(vxlist *mesh, const vx_bin_opts *opts)
+{
+    free(mesh->occupied);
+    free(mesh->ranked);
+
+    int k = 0, max_count = 0;
+    for (int j = 0; j < mesh->count; j++) {
+        k += mesh->items[j].count > 0;
+        if (mesh->items[j].count > max_count) max_count = mesh->items[j].count;
+    }
+    mesh->occupied       = malloc((k ? k : 1) * sizeof(int));
+    mesh->ranked         = malloc((k ? k : 1) * sizeof(int));
+    int *tmp             = malloc((k ? k : 1) * sizeof(int));
+    assert(mesh->occupied != NULL && mesh->ranked != NULL && tmp != NULL);
+    mesh->occupied_count = k;
+    for (int a = 0; a < 3; a++) VX_STATS_ALLOC(opts->stats, (k ? k : 1) * sizeof(int));
+    VX_STATS_SET(opts->stats, occupied, k);
+    VX_STATS_SET(opts->stats, points, mesh->point_count);
+
+    k = 0;
+    for (int j = 0; j < mesh->count; j++) {
+        if (mesh->items[j].count > 0) mesh->occupied[k++] = j;
+    }
+    memcpy(mesh->ranked, mesh->occupied, (size_t)k * sizeof(int));
+
+    int *src = mesh->ranked, *dst = tmp;
+    for (int shift = 0; shift < 32 && (max_count >> shift) > 0; shift += 8) {
+        int hist[257] = {0};
+        for (int i = 0; i < k; i++) hist[((mesh->items[src[i]].count >> shift) & 0xff) + 1]++;
+        for (int d = 0; d < 256; d++) hist[d + 1] += hist[d];
+        for (int i = 0; i < k; i++) dst[hist[(mesh->items[src[i]].count >> shift) & 0xff]++] = src[i];
+        int *t = src; src = dst; dst = t;
+    }
+    if (src != mesh->ranked) {
+        memcpy(mesh->ranked, src, (size_t)k * sizeof(int));
+    }
+    free(tmp);
+}
+
+int vx_cells_at_least(const vxlist *mesh, int min_count, const int **cells)
+{
+    /* Первая позиция в ranked с count >= min_count */
+    if (min_count < 1) min_count = 1;
+    int lo = 0, hi = mesh->occupied_count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (mesh->items[mesh->ranked[mid]].count < min_count) lo = mid + 1;
+        else                                                  hi = mid;
+    }
+    *cells = mesh->ranked + lo;
+    return mesh->occupied_count - lo;
+}
+
+/* Разреженная сетка: воксели заводятся при первом попадании вершины */
+static void ind_finder_sparse(vxlist *mesh, const vx_src *src, float voxel_w,
+                              const vx_bin_opts *opts)
+{
+    int   nx = mesh->nx, ny = mesh->ny, nz = mesh->nz;
+    float inv_w = 1.0f / voxel_w;
+
+    mesh->count = 0;
+    vxhash_free(&mesh->cells);
+    vxhash_init(&mesh->cells, 1024);
+    int items_cap = mesh->capacity;
+    int cells_cap = mesh->cells.capacity;
+    VX_STATS_ALLOC(opts->stats, (size_t)cells_cap * sizeof(uint64_t));
+    VX_STATS_ALLOC(opts->stats, (size_t)cells_cap * sizeof(int));
+
+    /* Проход 1: поиск/вставка ячейки и гистограмма */
+    for (int i = 0; i < src->count; i++) {
+        if (i % VX_BIN_POLL == 0) {
+            if (bin_cancelled(opts)) return;
+            bin_progress(opts, i, 2 * (int64_t)src->count);
+        }
+        int64_t key  = vx_cell_of(src_point(src, i), inv_w, nx, ny, nz);
+        int     slot = vxhash_insert(&mesh->cells, (uint64_t)key, mesh->count);
+        if (slot == mesh->count) {
+            int64_t xi = key % nx;
+            int64_t yi = key / nx % ny;
+            int64_t zi = key / ((int64_t)nx * ny);
+            Voxel vx = make_voxel(0, voxel_w);
+            vx.vx_center = (Vector3){mesh->origin.x + ((float)xi + 0.5f) * voxel_w,
+                                     mesh->origin.y + ((float)yi + 0.5f) * voxel_w,
+                                     mesh->origin.z + ((float)zi + 0.5f) * voxel_w};
+            da_append(mesh, vx);
+        }
+        mesh->items[slot].count++;
+    }
+
+    bin_stats_growth(opts, items_cap, mesh->capacity, sizeof(Voxel));
+    bin_stats_growth(opts, cells_cap, mesh->cells.capacity, sizeof(uint64_t));
+    bin_stats_growth(opts, cells_cap, mesh->cells.capacity, sizeof(int));
+    vx_prefix_offsets(mesh, src->count, opts);
+
+    /* Проход 2: раскладка вершин в общий буфер */
+    for (int i = 0; i < src->count; i++) {
+        if (i % VX_BIN_POLL == 0) {
+            if (bin_cancelled(opts)) return;
+            bin_progress(opts, (int64_t)src->count + i, 2 * (int64_t)src->count);
+        }
+        Vector3 p   = src_point(src, i);
+        int64_t key = vx_cell_of(p, inv_w, nx, ny, nz);
+        Voxel  *vx  = &mesh->items[vxhash_find(&mesh->cells, (uint64_t)key)];
+        mesh->points[vx->offset + vx->count++] = p;
+    }
+    vx_index_occupied(mesh, opts);
+    bin_progress(opts, 1, 1);
+}
+
+/* =========================================================
+ *  Параллельная раскладка плотной сетки
+ *
+ *  Вершины делятся на непрерывные диапазоны по задачам.
+ *  Режим гистограмм (пока tasks·cells укладывается в бюджет):
+ *  у каждой задачи своя гистограмма, курсор записи задачи t в
+ *  ячейку c = offset(c) + сумма счётчиков задач t' < t, поэтому
+ *  порядок вершин внутри вокселя совпадает с последовательным.
+ *  Иначе — атомарные счётчики и атомарные курсоры; порядок при
+ *  deterministic восстанавливается сортировкой номеров вершин
+ *  внутри каждого вокселя.
+ * ========================================================= */
+#ifndef VX_BIN_HIST_BUDGET
+#define VX_BIN_HIST_BUDGET (1 << 24) /* ячеек·задач в режиме гистограмм (64 МБ) */
+#endif
+
+typedef struct {
+    vxlist        *mesh;
+    const vx_src  *src;
+    vx_quant       q;
+    int            tasks;
+    int           *hist;       /* режим гистограмм: tasks × cells          */
+    int           *order;      /* атомарный deterministic: номер вершины   */
+    int           *range_sum;  /* сумма счётчиков по диапазону ячеек задачи */
+    const vx_bin_opts *opts;   /* отмена и прогресс                        */
+    int64_t        done;       /* обработано вершин (оба прохода)          */
+} vx_bin_job;
+
+/* После блока из n вершин: прогресс; true — задачу пора бросить */
+static bool bin_block_done(vx_bin_job *job, int n)
+{
+    int64_t done = __atomic_add_fetch(&job->done, n, __ATOMIC_RELAXED);
+    bin_progress(job->opts, done, 2 * (int64_t)job->src->count);
+    return bin_cancelled(job->opts);
+}
+
+static void task_range(int total, int task, int tasks, int *begin, int *end)
+{
+    *begin = (int)((int64_t)total * task / tasks);
+    *end   = (int)((int64_t)total * (task + 1) / tasks);
+}
+
+static void bin_hist_count(void *ctx, int task, int tasks)
+{
+    vx_bin_job *job   = ctx;
+    int         cells = job->mesh->count;
+    int        *h     = job->hist + (size_t)task * cells;
+    memset(h, 0, (size_t)cells * sizeof(int));
+
+    int32_t cell[VX_BIN_BLOCK];
+    int b, e;
+    task_range(job->src->count, task, tasks, &b, &e);
+    for (int i = b; i < e; i += VX_BIN_BLOCK) {
+        int n = e - i < VX_BIN_BLOCK ? e - i : VX_BIN_BLOCK;
+        src_cells(job->src, i, n, &job->q, job->mesh->morton, cell);
+        for (int k = 0; k < n; k++) h[cell[k]]++;
+        if (bin_block_done(job, n)) return;
+    }
+}
+
+static void bin_atomic_count(void *ctx, int task, int tasks)
+{
+    vx_bin_job *job = ctx;
+    int32_t cell[VX_BIN_BLOCK];
+    int b, e;
+    task_range(job->src->count, task, tasks, &b, &e);
+    for (int i = b; i < e; i += VX_BIN_BLOCK) {
+        int n = e - i < VX_BIN_BLOCK ? e - i : VX_BIN_BLOCK;
+        src_cells(job->src, i, n, &job->q, job->mesh->morton, cell);
+        for (int k = 0; k < n; k++) {
+            __atomic_fetch_add(&job->mesh->items[cell[k]].count, 1, __ATOMIC_RELAXED);
+        }
+        if (bin_block_done(job, n)) return;
+    }
+}
+
+/* Итог по диапазону ячеек задачи (для префиксной суммы по задачам) */
+static void bin_range_sum(void *ctx, int task, int tasks)
+{
+    vx_bin_job *job   = ctx;
+    int         cells = job->mesh->count;
+    int b, e, sum = 0;
+    task_range(cells, task, tasks, &b, &e);
+    for (int c = b; c < e; c++) {
+        if (job->hist) {
+            for (int t = 0; t < job->tasks; t++) sum += job->hist[(size_t)t * cells + c];
+        } else {
+            sum += job->mesh->items[c].count;
+        }
+    }
+    job->range_sum[task] = sum;
+}
+
+/* Offset вокселей диапазона; гистограммы превращаются в курсоры задач,
+ * в атомарном режиме count обнуляется и служит курсором */
+static void bin_offsets(void *ctx, int task, int tasks)
+{
+    vx_bin_job *job   = ctx;
+    int         cells = job->mesh->count;
+    int         off   = job->range_sum[task];
+    int b, e;
+    task_range(cells, task, tasks, &b, &e);
+    for (int c = b; c < e; c++) {
+        Voxel *vx = &job->mesh->items[c];
+        vx->offset = off;
+        if (job->hist) {
+            int total = 0;
+            for (int t = 0; t < job->tasks; t++) {
+                int *h = &job->hist[(size_t)t * cells + c];
+                int  k = *h;
+                *h     = off + total;
+                total += k;
+            }
+            vx->count = total;
+            off += total;
+        } else {
+            off += vx->count;
+            vx->count = 0;
+        }
+    }
+}
+
+static void bin_hist_scatter(void *ctx, int task, int tasks)
+{
+    vx_bin_job *job = ctx;
+    int        *h   = job->hist + (size_t)task * job->mesh->count;
+    int32_t cell[VX_BIN_BLOCK];
+    int b, e;
+    task_range(job->src->count, task, tasks, &b, &e);
+    for (int i = b; i < e; i += VX_BIN_BLOCK) {
+        int n = e - i < VX_BIN_BLOCK ? e - i : VX_BIN_BLOCK;
+        src_cells(job->src, i, n, &job->q, job->mesh->morton, cell);
+        for (int k = 0; k < n; k++) {
+            job->mesh->points[h[cell[k]]++] = src_point(job->src, i + k);
+        }
+        if (bin_block_done(job, n)) return;
+    }
+}
+
+static void bin_atomic_scatter(void *ctx, int task, int tasks)
+{
+    vx_bin_job *job = ctx;
+    int32_t cell[VX_BIN_BLOCK];
+    int b, e;
+    task_range(job->src->count, task, tasks, &b, &e);
+    for (int i = b; i < e; i += VX_BIN_BLOCK) {
+        int n = e - i < VX_BIN_BLOCK ? e - i : VX_BIN_BLOCK;
+        src_cells(job->src, i, n, &job->q, job->mesh->morton, cell);
+        for (int k = 0; k < n; k++) {
+            Voxel *vx  = &job->mesh->items[cell[k]];
+            int    pos = vx->offset + __atomic_fetch_add(&vx->count, 1, __ATOMIC_RELAXED);
+            if (job->order) job->order[pos]       = i + k;
+            else            job->mesh->points[pos] = src_point(job->src, i + k);
+        }
+        if (bin_block_done(job, n)) return;
+    }
+}
+
+static int int_compare(const void *a, const void *b)
+{
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+/* deterministic: номера вершин вокселя по возрастанию, затем сбор вершин */
+static void bin_atomic_order(void *ctx, int task, int tasks)
+{
+    vx_bin_job *job = ctx;
+    int b, e;
+    task_range(job->mesh->count, task, tasks, &b, &e);
+    for (int c = b; c < e; c++) {
+        Voxel *vx = &job->mesh->items[c];
+        int   *s  = job->order + vx->offset;
+        if (vx->count <= 32) {
+            for (int i = 1; i < vx->count; i++) {
+                int k = s[i], j = i - 1;
+                while (j >= 0 && s[j] > k) { s[j + 1] = s[j]; j--; }
+                s[j + 1] = k;
+            }
+        } else {
+            qsort(s, vx->count, sizeof(int), int_compare);
+        }
+        for (int i = 0; i < vx->count; i++) {
+            job->mesh->points[vx->offset + i] = src_point(job->src, s[i]);
+        }
+    }
+}
+
+static void ind_finder_parallel(vxlist *mesh, const vx_src *src, const vx_quant *q,
+                                int tasks, const vx_bin_opts *opts)
+{
+    vx_bin_job job = {.mesh = mesh, .src = src, .q = *q, .tasks = tasks, .opts = opts};
+    job.range_sum = malloc(tasks * sizeof(int));
+    assert(job.range_sum != NULL);
+    VX_STATS_ALLOC(opts->stats, tasks * sizeof(int));
+
+    int n = src->count;
+    free(mesh->points);
+    mesh->points      = malloc((n ? n : 1) * sizeof(Vector3));
+    assert(mesh->points != NULL);
+    mesh->point_count = n;
+    VX_STATS_ALLOC(opts->stats, (n ? n : 1) * sizeof(Vector3));
+
+    bool use_hist = (int64_t)tasks * mesh->count <= VX_BIN_HIST_BUDGET;
+    if (use_hist) {
+        job.hist = malloc((size_t)tasks * mesh->count * sizeof(int));
+        assert(job.hist != NULL);
+        VX_STATS_ALLOC(opts->stats, (size_t)tasks * mesh->count * sizeof(int));
+        vx_parallel_run(tasks, bin_hist_count, &job);
+    } else {
+        for (int j = 0; j < mesh->count; j++) mesh->items[j].count = 0;
+        vx_parallel_run(tasks, bin_atomic_count, &job);
+    }
+    if (bin_cancelled(opts)) {
+        free(job.hist);
+        free(job.range_sum);
+        return;
+    }
+
+    /* Префиксная сумма: сначала по задачам-диапазонам ячеек, затем внутри */
+    vx_parallel_run(tasks, bin_range_sum, &job);
+    int run = 0;
+    for (int t = 0; t < tasks; t++) {
+        int k = job.range_sum[t];
+        job.range_sum[t] = run;
+        run += k;
+    }
+    vx_parallel_run(tasks, bin_offsets, &job);
+
+    if (use_hist) {
+        vx_parallel_run(tasks, bin_hist_scatter, &job);
+        free(job.hist);
+    } else {
+        if (opts->deterministic) {
+            job.order = malloc((n ? n : 1) * sizeof(int));
+            assert(job.order != NULL);
+            VX_STATS_ALLOC(opts->stats, (n ? n : 1) * sizeof(int));
+        }
+        vx_parallel_run(tasks, bin_atomic_scatter, &job);
+        if (opts->deterministic) {
+            if (!bin_cancelled(opts)) vx_parallel_run(tasks, bin_atomic_order, &job);
+            free(job.order);
+        }
+    }
+    free(job.range_sum);
+}
+
+/* Общая часть ind_finder_ex / ind_finder_soa */
+static void ind_finder_src(vxlist *mesh, const vx_src *src, float voxel_w,
+                           const vx_bin_opts *opts)
+{
+    if (mesh->sparse) {
+        ind_finder_sparse(mesh, src, voxel_w, opts);
+        return;
+    }
+
+    /* Сетка без геометрии (make_vxlist): n = кубический корень числа вокселей */
+    if (mesh->nx == 0) {
+        int n = (int)round(cbrt((double)mesh->count));
+        mesh->nx = mesh->ny = mesh->nz = n;
+    }
+    vx_quant q = {.inv_w = 1.0f / voxel_w, .nx = mesh->nx, .ny = mesh->ny, .nz = mesh->nz};
+
+    /* Мелкие задачи не стоят запуска потоков */
+    int tasks = opts->threads > 0 ? opts->threads : vx_thread_count();
+    if (tasks > src->count / 65536 + 1) tasks = src->count / 65536 + 1;
+    if (tasks > 1) {
+        ind_finder_parallel(mesh, src, &q, tasks, opts);
+        if (bin_cancelled(opts)) return;
+        vx_index_occupied(mesh, opts);
+        bin_progress(opts, 1, 1);
+        return;
+    }
+
+    int32_t cell[VX_BIN_BLOCK];
+
+    /* Проход 1: гистограмма вершин по вокселям */
+    for (int j = 0; j < mesh->count; j++) mesh->items[j].count = 0;
+    for (int i = 0; i < src->count; i += VX_BIN_BLOCK) {
+        if (i % VX_BIN_POLL == 0) {
+            if (bin_cancelled(opts)) return;
+            bin_progress(opts, i, 2 * (int64_t)src->count);
+        }
+        int n = src->count - i < VX_BIN_BLOCK ? src->count - i : VX_BIN_BLOCK;
+        src_cells(src, i, n, &q, mesh->morton, cell);
+        for (int k = 0; k < n; k++) mesh->items[cell[k]].count++;
+    }
+
+    vx_prefix_offsets(mesh, src->count, opts);
+
+    /* Проход 2: раскладка вершин в общий буфер */
+    for (int i = 0; i < src->count; i += VX_BIN_BLOCK) {
+        if (i % VX_BIN_POLL == 0) {
+            if (bin_cancelled(opts)) return;
+            bin_progress(opts, (int64_t)src->count + i, 2 * (int64_t)src->count);
+        }
+        int n = src->count - i < VX_BIN_BLOCK ? src->count - i : VX_BIN_BLOCK;
+        src_cells(src, i, n, &q, mesh->morton, cell);
+        for (int k = 0; k < n; k++) {
+            Voxel *vx = &mesh->items[cell[k]];
+            mesh->points[vx->offset + vx->count++] = src_point(src, i + k);
+        }
+    }
+    vx_index_occupied(mesh, opts);
+    bin_progress(opts, 1, 1);
+}
+
+void ind_finder(vxlist *mesh, Vector3 *vert,
+                float voxel_w, float parallel_x, float parallel_y, float parallel_z)
+{
+    (void)parallel_x; (void)parallel_y; (void)parallel_z; /* не нужны при целом n */
+
+    vx_bin_opts opts = {.threads = 0, .deterministic = true, .cancel = NULL, .progress = NULL};
+    ind_finder_ex(mesh, vert, voxel_w, &opts);
+}
+
+void ind_finder_ex(vxlist *mesh, Vector3 *vert, float voxel_w, const vx_bin_opts *opts)
+{
+    vx_src src = {.aos = vert, .soa = NULL, .count = vert_count};
+    ind_finder_src(mesh, &src, voxel_w, opts);
+}
+
+void ind_finder_soa(vxlist *mesh, const vx_soa *vert, float voxel_w, const vx_bin_opts *opts)
+{
+    vx_src src = {.aos = NULL, .soa = vert, .count = vert->count};
+    ind_finder_src(mesh, &src, voxel_w, opts);
+}
+
+/* =========================================================
+ *  vx_lookup
+ *  Плотная сетка — прямой индекс, разреженная — через таблицу.
+ * ========================================================= */
+Voxel *vx_lookup(const vxlist *mesh, int xi, int yi, int zi)
+{
+    if (xi < 0 || yi < 0 || zi < 0 ||
+        xi >= mesh->nx || yi >= mesh->ny || zi >= mesh->nz) return NULL;
+
+    if (mesh->morton) return &mesh->items[vx_morton_encode((uint32_t)xi, (uint32_t)yi, (uint32_t)zi)];
+
+    int64_t key = (int64_t)zi * mesh->nx * mesh->ny + (int64_t)yi * mesh->nx + xi;
+    if (!mesh->sparse) return &mesh->items[key];
+
+    int slot = vxhash_find(&mesh->cells, (uint64_t)key);
+    return slot < 0 ? NULL : &mesh->items[slot];
+}
+
+/* =========================================================
+ *  vxCompare
+ *  Порядок по count для qsort и threeWayQuickSort.
+ * ========================================================= */
+int vxCompare(const void *a, const void *b)
+{
+    const Voxel *v1 = (const Voxel *)a;
+    const Voxel *v2 = (const Voxel *)b;
+    if (v1->count > v2->count) return  1;
+    if (v1->count < v2->count) return -1;
+    return 0;
+}
+
+/* =========================================================
+ *  vx_swap
+ * ========================================================= */
+void vx_swap(Voxel *a, Voxel *b)
+{
+    Voxel tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+/* =========================================================
+ *  threeWayPartition
+ *  Разбиение Дейкстры: [low..lt) < опорного, [lt..gt] равны,
+ *  (gt..high] больше. Опорный — средний элемент.
+ * ========================================================= */
+void threeWayPartition(vxlist *arr, int low, int high, int *lt, int *gt)
+{
+    Voxel *v     = arr->items;
+    Voxel  pivot = v[low + (high - low) / 2];
+    int    l = low, i = low, g = high;
+
+    while (i <= g) {
+        int cmp = vxCompare(&v[i], &pivot);
+        if      (cmp < 0) vx_swap(&v[l++], &v[i++]);
+        else if (cmp > 0) vx_swap(&v[i], &v[g--]);
+        else              i++;
+    }
+    *lt = l;
+    *gt = g;
+}
+
+/* =========================================================
+ *  threeWayQuickSort
+ *  Рекурсия по меньшей части, цикл по большей — глубина
+ *  стека O(log n) при любых данных.
+ * ========================================================= */
+void threeWayQuickSort(vxlist *arr, int low, int high)
+{
+    while (low < high) {
+        int lt, gt;
+        threeWayPartition(arr, low, high, &lt, &gt);
+        if (lt - low < high - gt) {
+            threeWayQuickSort(arr, low, lt - 1);
+            low = gt + 1;
+        } else {
+            threeWayQuickSort(arr, gt + 1, high);
+            high = lt - 1;
+        }
+    }
+}
+
+/* =========================================================
+ *  create_mesh
+ *  Пересоздаёт сетку с новым разрешением; угол сетки — lo.
+ *  freeContainer вызывается снаружи перед этой функцией.
+ * ========================================================= */
+static void dense_mesh(vxlist *mesh_vox, Vector3 lo, float cube_volume, int voxel_num,
+                       float parallel_x, float parallel_y, float parallel_z,
+                       float *voxel_w)
+{
+    float voxel_volume = cube_volume / voxel_num;
+    *voxel_w = cbrtf(voxel_volume);
+    Vector3 start_mesh = {
+        lo.x + (*voxel_w) * 0.5f,
+        lo.y + (*voxel_w) * 0.5f,
+        lo.z + (*voxel_w) * 0.5f
+    };
+    /* make_vxlist не нужен — parallel_mesh сам выделяет буфер нужного размера */
+    *mesh_vox = (vxlist){0};
+    parallel_mesh(voxel_num, mesh_vox,
+                  parallel_x, parallel_y, parallel_z,
+                  *voxel_w, start_mesh);
+}
+
+void create_mesh(vxlist *mesh_vox, float cube_volume, int voxel_num,
+                 float parallel_x, float parallel_y, float parallel_z,
+                 float *voxel_w)
+{
+    dense_mesh(mesh_vox, (Vector3){x_min, y_min, z_min}, cube_volume, voxel_num,
+               parallel_x, parallel_y, parallel_z, voxel_w);
+}
+
+/* =========================================================
+ *  create_sparse_mesh
+ *  Разреженная сетка n×n×n: только геометрия, без ячеек.
+ *  freeContainer вызывается снаружи перед этой функцией.
+ * ========================================================= */
+static void sparse_mesh(vxlist *mesh_vox, Vector3 lo, float cube_volume, int n, float *voxel_w)
+{
+    *voxel_w = cbrtf(cube_volume / ((float)n * (float)n * (float)n));
+
+    *mesh_vox = (vxlist){0};
+    mesh_vox->nx      = n;
+    mesh_vox->ny      = n;
+    mesh_vox->nz      = n;
+    mesh_vox->voxel_w = *voxel_w;
+    mesh_vox->origin  = lo;
+    mesh_vox->sparse  = true;
+}
+
+void create_sparse_mesh(vxlist *mesh_vox, float cube_volume, int n, float *voxel_w)
+{
+    sparse_mesh(mesh_vox, (Vector3){x_min, y_min, z_min}, cube_volume, n, voxel_w);
+}
+
+/* =========================================================
+ *  create_morton_mesh
+ *  Плотная сетка n×n×n, воксель ячейки — по её коду Мортона.
+ *  freeContainer вызывается снаружи перед этой функцией.
+ * ========================================================= */
+static void morton_mesh(vxlist *mesh_vox, Vector3 lo, float cube_volume, int n, float *voxel_w)
+{
+    assert(n >= 1 && n <= 1024);
+    *voxel_w = cbrtf(cube_volume / ((float)n * (float)n * (float)n));
+
+    /* Наибольший код — у дальнего угла сетки */
+    int span = (int)vx_morton_encode(n - 1, n - 1, n - 1) + 1;
+
+    *mesh_vox = (vxlist){0};
+    mesh_vox->items    = calloc(span, sizeof(Voxel));
+    assert(mesh_vox->items != NULL);
+    mesh_vox->count    = span;
+    mesh_vox->capacity = span;
+    mesh_vox->nx       = n;
+    mesh_vox->ny       = n;
+    mesh_vox->nz       = n;
+    mesh_vox->voxel_w  = *voxel_w;
+    mesh_vox->origin   = lo;
+    mesh_vox->morton   = true;
+
+    float w = *voxel_w;
+    for (int i = 0; i < span; i++) {
+        uint32_t xi, yi, zi;
+        vx_morton_decode((uint64_t)i, &xi, &yi, &zi);
+        mesh_vox->items[i].size      = w;
+        mesh_vox->items[i].vx_center = (Vector3){lo.x + w * 0.5f + (float)xi * w,
+                                                 lo.y + w * 0.5f + (float)yi * w,
+                                                 lo.z + w * 0.5f + (float)zi * w};
+    }
+}
+
+void create_morton_mesh(vxlist *mesh_vox, float cube_volume, int n, float *voxel_w)
+{
+    morton_mesh(mesh_vox, (Vector3){x_min, y_min, z_min}, cube_volume, n, voxel_w);
+}
+
+/* =========================================================
+ *  vx_fail
+ *  Библиотека не печатает и не выходит: текст ошибки пишется
+ *  в err (если задан), код возвращается наверх.
+ * ========================================================= */
+vx_status vx_fail(vx_error *err, vx_status status, const char *fmt, ...)
+{
+    if (err != NULL) {
+        va_list ap;
+        va_start(ap, fmt);
+        err->status = status;
+        vsnprintf(err->message, sizeof(err->message), fmt, ap);
+        va_end(ap);
+    }
+    return status;
+}
+
+/* =========================================================
+ *  Контекст вокселизации
+ *  Те же шаги, что выше, но границы и число вершин берутся
+ *  из контекста, а не из глобальных переменных.
+ * ========================================================= */
+void vx_ctx_init(vx_ctx *ctx)
+{
+    *ctx = (vx_ctx){0};
+}
+
+void vx_ctx_free(vx_ctx *ctx)
+{
+    if (ctx->owns_vertices) free(ctx->vertices);
+    freeContainer(&ctx->mesh);
+    *ctx = (vx_ctx){0};
+}
+
+/* Освобождает данные контекста, сохраняя накопленные замеры */
+static void ctx_clear(vx_ctx *ctx)
+{
+    vx_stats stats = ctx->stats;
+    vx_ctx_free(ctx);
+    ctx->stats = stats;
+}
+
+void vx_ctx_set_vertices(vx_ctx *ctx, const Vector3 *vertices, int count)
+{
+    ctx_clear(ctx);
+    ctx->vertices = malloc((size_t)(count > 0 ? count : 1) * sizeof(Vector3));
+    assert(ctx->vertices != NULL);
+    if (count > 0) memcpy(ctx->vertices, vertices, (size_t)count * sizeof(Vector3));
+    ctx->vert_count    = count;
+    ctx->owns_vertices = true;
+
+    if (count == 0) return;
+    float mn[3] = { FLT_MAX,  FLT_MAX,  FLT_MAX};
+    float mx[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    vx_minmax_aos(vertices, count, mn, mx);
+    ctx->bounds = (vx_bounds){mn[0], mx[0], mn[1], mx[1], mn[2], mx[2]};
+}
+
+void vx_ctx_share(vx_ctx *ctx, const vx_ctx *model)
+{
+    ctx_clear(ctx);
+    ctx->bounds     = model->bounds;
+    ctx->vertices   = model->vertices;
+    ctx->vert_count = model->vert_count;
+}
+
+void vx_ctx_normalize(vx_ctx *ctx, float norm_factor)
+{
+    assert(ctx->owns_vertices || ctx->vertices == NULL);
+    VX_STATS_SCOPE(&ctx->stats, VX_STAGE_NORMALIZE) {
+        normalize_aos(ctx->vertices, ctx->vert_count, &ctx->bounds, norm_factor);
+    }
+}
+
+float vx_ctx_volume(const vx_ctx *ctx)
+{
+    const vx_bounds *b = &ctx->bounds;
+    return (b->x_max - b->x_min) * (b->y_max - b->y_min) * (b->z_max - b->z_min);
+}
+
+void vx_ctx_mesh(vx_ctx *ctx, int n, vx_grid_kind kind)
+{
+    const vx_bounds *b  = &ctx->bounds;
+    Vector3          lo = {b->x_min, b->y_min, b->z_min};
+    float            cube_volume = vx_ctx_volume(ctx);
+    double           t0 = VX_STATS_BEGIN();
+
+    freeContainer(&ctx->mesh);
+    switch (kind) {
+    case VX_GRID_SPARSE:
+        sparse_mesh(&ctx->mesh, lo, cube_volume, n, &ctx->voxel_w);
+        break;
+    case VX_GRID_MORTON:
+        morton_mesh(&ctx->mesh, lo, cube_volume, n, &ctx->voxel_w);
+        break;
+    default:
+        dense_mesh(&ctx->mesh, lo, cube_volume, n * n * n,
+                   b->x_max - b->x_min, b->y_max - b->y_min, b->z_max - b->z_min, &ctx->voxel_w);
+        break;
+    }
+    VX_STATS_END(&ctx->stats, VX_STAGE_MESH, t0);
+}
+
+void vx_ctx_bin(vx_ctx *ctx, const vx_bin_opts *opts)
+{
+    vx_bin_opts o   = {.threads = 0, .deterministic = true, .cancel = NULL, .progress = NULL};
+    vx_src      src = {.aos = ctx->vertices, .soa = NULL, .count = ctx->vert_count};
+    if (opts != NULL) o = *opts;
+    if (o.stats == NULL) o.stats = &ctx->stats;
+
+    VX_STATS_SCOPE(o.stats, VX_STAGE_BIN) {
+        ind_finder_src(&ctx->mesh, &src, ctx->voxel_w, &o);
+    }
+}
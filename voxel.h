@@ -1,10 +1,27 @@
 #ifndef VOXEL_H
 #define VOXEL_H
 
-#include "raylib.h"
+/*
+ * Ядро не зависит от raylib: если raylib.h подключён раньше voxel.h,
+ * используется его Vector3, иначе — совместимое по раскладке определение.
+ */
+#ifndef RAYLIB_H
+#ifndef RL_VECTOR3_TYPE
+typedef struct Vector3 {
+    float x;
+    float y;
+    float z;
+} Vector3;
+#define RL_VECTOR3_TYPE
+#endif
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <stdbool.h>
+#include "vxhash.h"
+#include "vxstats.h"
 
 /* =========================================================
  *  Структуры данных
@@ -13,26 +30,171 @@
 /**
  * @brief Воксель — кубическая ячейка сетки вокселизации.
  *
- * Хранит динамический список вершин 3D-модели, попавших
- * в данную ячейку, координаты центра и размер ребра куба.
+ * Вершины, попавшие в ячейку, хранятся не в самом вокселе, а подряд
+ * в общем буфере vxlist.points (CSR-раскладка): вершины вокселя —
+ * это points[offset .. offset + count).
  */
 typedef struct Voxel {
-    Vector3 *items;     /**< Динамический массив вершин внутри вокселя. */
-    int      count;     /**< Текущее количество вершин в массиве.        */
-    int      capacity;  /**< Вместимость массива (до следующего realloc). */
-    Vector3  vx_center; /**< Координаты геометрического центра вокселя.  */
-    float    size;      /**< Длина ребра куба (все рёбра равны).          */
+    int      offset;    /**< Индекс первой вершины вокселя в vxlist.points. */
+    int      count;     /**< Количество вершин внутри вокселя.              */
+    Vector3  vx_center; /**< Координаты геометрического центра вокселя.     */
+    float    size;      /**< Длина ребра куба (все рёбра равны).             */
 } Voxel;
 
 /**
  * @brief Динамический список вокселей — представляет сетку вокселизации.
+ *
+ * Плотная сетка (sparse == false) хранит в items все nx·ny·nz ячеек,
+ * индекс ячейки совпадает с её линейным индексом. Разреженная сетка
+ * (sparse == true) хранит в items только занятые ячейки в порядке
+ * их появления, а таблица cells отображает линейный индекс ячейки
+ * в индекс items — память растёт с числом занятых ячеек, а не с
+ * объёмом сетки.
+ *
+ * Плотная сетка в порядке Мортона (morton == true, create_morton_mesh)
+ * хранит ячейку (xi, yi, zi) в items[vx_morton_encode(xi, yi, zi)]:
+ * соседние ячейки лежат рядом в памяти. Коды занимают диапазон до
+ * угла (nx-1, ny-1, nz-1), поэтому при n, не равном степени двойки,
+ * часть items — пустые ячейки вне сетки (не более 8× от n³).
+ *
+ * ind_finder дополнительно строит компактный список занятых вокселей
+ * occupied и его упорядочение по числу вершин ranked: обход занятых
+ * ячеек стоит O(занятых), а не O(nx·ny·nz), а запрос «не меньше N
+ * вершин» (vx_cells_at_least) — двоичный поиск по ranked.
  */
 typedef struct vxlist {
-    Voxel *items;    /**< Динамический массив вокселей. */
-    int    count;    /**< Текущее количество вокселей.  */
-    int    capacity; /**< Вместимость массива.           */
+    Voxel   *items;       /**< Динамический массив вокселей.                    */
+    int      count;       /**< Текущее количество вокселей.                     */
+    int      capacity;    /**< Вместимость массива.                              */
+    Vector3 *points;      /**< Вершины всех вокселей подряд, по порядку вокселей. */
+    int      point_count; /**< Количество вершин в points.                       */
+    int      nx;          /**< Количество ячеек вдоль оси X.                     */
+    int      ny;          /**< Количество ячеек вдоль оси Y.                     */
+    int      nz;          /**< Количество ячеек вдоль оси Z.                     */
+    float    voxel_w;     /**< Длина ребра вокселя.                              */
+    Vector3  origin;      /**< Нижний-левый-передний угол сетки.                */
+    bool     sparse;      /**< true — разреженная сетка (см. выше).             */
+    bool     morton;      /**< true — плотная сетка в порядке Мортона.          */
+    vxhash   cells;       /**< Разреженная сетка: линейный индекс -> индекс items. */
+    int     *occupied;    /**< Индексы занятых вокселей (count > 0) по возрастанию.   */
+    int     *ranked;      /**< Те же индексы по возрастанию count, при равенстве — по индексу. */
+    int      occupied_count; /**< Длина occupied и ranked.                          */
 } vxlist;
 
+/**
+ * @brief Треугольник поверхности: индексы трёх вершин.
+ */
+typedef struct vx_tri {
+    int v[3];
+} vx_tri;
+
+/**
+ * @brief Динамический список треугольников (грани PLY после триангуляции).
+ */
+typedef struct vx_trilist {
+    vx_tri *items;    /**< Треугольники.          */
+    int     count;    /**< Количество.            */
+    int     capacity; /**< Вместимость массива.   */
+} vx_trilist;
+
+/**
+ * @brief Вершины в раскладке «структура массивов» (SoA).
+ *
+ * Координаты лежат в трёх отдельных массивах, что позволяет векторным
+ * ядрам (vxsimd.h) загружать по 8 значений одной оси за инструкцию.
+ */
+typedef struct vx_soa {
+    float *x;     /**< Координаты X. */
+    float *y;     /**< Координаты Y. */
+    float *z;     /**< Координаты Z. */
+    int    count; /**< Количество вершин. */
+} vx_soa;
+
+/**
+ * @brief Охватывающий параллелепипед модели.
+ */
+typedef struct vx_bounds {
+    float x_min; /**< Минимальная координата X. */
+    float x_max; /**< Максимальная координата X. */
+    float y_min; /**< Минимальная координата Y. */
+    float y_max; /**< Максимальная координата Y. */
+    float z_min; /**< Минимальная координата Z. */
+    float z_max; /**< Максимальная координата Z. */
+} vx_bounds;
+
+/**
+ * @brief Вид сетки, которую строит vx_ctx_mesh.
+ */
+typedef enum {
+    VX_GRID_DENSE,  /**< Плотная, построчно (create_mesh).          */
+    VX_GRID_SPARSE, /**< Разреженная (create_sparse_mesh).          */
+    VX_GRID_MORTON, /**< Плотная в порядке Мортона (create_morton_mesh). */
+} vx_grid_kind;
+
+/** Длина текста ошибки vx_error, включая '\0'. */
+#define VX_ERROR_LEN 256
+
+/**
+ * @brief Результат загрузки или записи файла.
+ */
+typedef enum {
+    VX_OK = 0,        /**< Успех.                                                  */
+    VX_ERR_OPEN,      /**< Файл не открыт, не читается или не создан.              */
+    VX_ERR_HEADER,    /**< Заголовок PLY повреждён или не поддерживается.          */
+    VX_ERR_FORMAT,    /**< Нет нужного элемента или свойства, раскладка не поддерживается. */
+    VX_ERR_TRUNCATED, /**< Данных меньше, чем объявлено в заголовке.               */
+    VX_ERR_DATA,      /**< Некорректная запись: строка грани, индекс вершины.      */
+    VX_ERR_WRITE,     /**< Запись в файл не удалась (диск полон, ошибка вывода).   */
+} vx_status;
+
+/**
+ * @brief Ошибка чтения или записи: код и текст для вывода вызывающей стороной.
+ *
+ * Загрузчики (vx_ctx_load_ply, faces_from_ply, ply_stream_*) и писатели
+ * файлов библиотеки ничего не печатают и не завершают процесс —
+ * повреждённый файл или полный диск одного задания не останавливает
+ * остальные. Печатают и выходят только прежний verts_from_ply,
+ * консольный вокселизатор и просмотрщик.
+ */
+typedef struct vx_error {
+    vx_status status;                /**< VX_OK или код ошибки. */
+    char      message[VX_ERROR_LEN]; /**< Текст ошибки.         */
+} vx_error;
+
+/**
+ * @brief Заполняет @p err (если не NULL) кодом и текстом по формату printf.
+ *
+ * @return @p status — чтобы писать return vx_fail(err, ...).
+ */
+vx_status vx_fail(vx_error *err, vx_status status, const char *fmt, ...);
+
+/**
+ * @brief Контекст вокселизации одной модели.
+ *
+ * Держит всё, что конвейер раньше хранил в глобальных переменных:
+ * границы, вершины и сетку. Функции vx_ctx_* меняют только свой
+ * контекст, поэтому разные контексты можно обрабатывать одновременно
+ * из разных потоков. Несколько сеток одной модели — несколько
+ * контекстов, разделяющих вершины (vx_ctx_share).
+ */
+typedef struct vx_ctx {
+    vx_bounds bounds;        /**< Границы вершин (после нормализации — нормализованные). */
+    Vector3  *vertices;      /**< Вершины модели.                                 */
+    int       vert_count;    /**< Количество вершин.                              */
+    bool      owns_vertices; /**< false — вершины принадлежат другому контексту. */
+    vxlist    mesh;          /**< Сетка после vx_ctx_mesh / vx_ctx_bin.           */
+    float     voxel_w;       /**< Длина ребра вокселя сетки.                      */
+    vx_stats  stats;         /**< Замеры стадий vx_ctx_* (vxstats.h).             */
+    vx_error  error;         /**< Ошибка последней vx_ctx_load_ply.               */
+} vx_ctx;
+
+/**
+ * @brief Возвращает указатель на первую вершину вокселя @p i.
+ *
+ * Вершины вокселя лежат подряд: vx_points(l, i)[0 .. l->items[i].count).
+ */
+#define vx_points(list, i) ((list)->points + (list)->items[(i)].offset)
+
 /* =========================================================
  *  Перечисления
  * ========================================================= */
@@ -52,6 +214,14 @@ typedef enum {
  *  Макросы
  * ========================================================= */
 
+/**
+ * @brief Наибольшее число ячеек по оси, при котором сетка строится плотной.
+ *
+ * Выше — create_sparse_mesh: плотная сетка 256³ уже занимает ~400 МБ
+ * под Voxel, а поверхностные сканы заполняют её меньше чем на 1 %.
+ */
+#define VX_DENSE_MAX 256
+
 /**
  * @brief Добавляет элемент @p item в конец динамического массива @p arr.
  *
@@ -88,6 +258,10 @@ typedef enum {
 
 /* =========================================================
  *  Глобальные переменные (границы модели после парсинга)
+ *
+ *  Их читают и пишут только verts_from_ply, normalize_verties,
+ *  create_*_mesh и ind_finder — прежний однопоточный интерфейс
+ *  просмотрщика. Реентерабельный конвейер — vx_ctx_*.
  * ========================================================= */
 
 /** Максимальная координата X всех вершин модели. */
@@ -106,6 +280,16 @@ extern float z_min;
 /** Общее количество вершин, считанных из PLY-файла. */
 extern int vert_count;
 
+/**
+ * @brief Глобальные границы одной структурой.
+ */
+vx_bounds vx_global_bounds(void);
+
+/**
+ * @brief Записывает @p b в глобальные границы.
+ */
+void vx_set_global_bounds(const vx_bounds *b);
+
 /* =========================================================
  *  Функции создания / удаления контейнеров
  * ========================================================= */
@@ -113,7 +297,7 @@ extern int vert_count;
 /**
  * @brief Создаёт и инициализирует воксель.
  *
- * @param cap  Начальная вместимость массива вершин.
+ * @param cap  Не используется (оставлен для совместимости сигнатуры).
  * @param size Длина ребра вокселя.
  * @return Инициализированная структура Voxel.
  */
@@ -127,16 +311,39 @@ Voxel make_voxel(int cap, float size);
  */
 vxlist make_vxlist(int cap);
 
+/**
+ * @brief Выделяет SoA-буфер на @p count вершин (содержимое не инициализировано).
+ */
+vx_soa make_soa(int count);
+
+/**
+ * @brief Копирует массив Vector3 в новый SoA-буфер.
+ */
+vx_soa soa_from_aos(const Vector3 *verties, int count);
+
+/**
+ * @brief Освобождает SoA-буфер и обнуляет его поля.
+ */
+void free_soa(vx_soa *s);
+
 /**
  * @brief Освобождает всю память, занятую списком вокселей.
  *
- * Освобождает внутренние массивы каждого вокселя,
- * затем сам массив вокселей. Обнуляет счётчики.
+ * Освобождает общий буфер вершин и массив вокселей.
+ * Обнуляет счётчики.
  *
  * @param c Указатель на список вокселей.
  */
 void freeContainer(vxlist *c);
 
+/**
+ * @brief Объём памяти, занятой списком вокселей, в байтах.
+ *
+ * Учитывает массив вокселей (по ёмкости), общий буфер вершин и
+ * таблицу ячеек разреженной сетки.
+ */
+size_t vxlist_bytes(const vxlist *c);
+
 /* =========================================================
  *  Парсинг PLY-файла
  * ========================================================= */
@@ -144,6 +351,13 @@ void freeContainer(vxlist *c);
 /**
  * @brief Считывает вершины из PLY-файла и возвращает массив Vector3.
  *
+ * Формат определяется по заголовку. Файл отображается в память (mmap).
+ * Для binary_little_endian / binary_big_endian X/Y/Z читаются прямо из
+ * блока вершин согласно раскладке свойств из заголовка — прочие свойства
+ * (нормали, цвет, confidence) пропускаются. Текстовый формат (ascii)
+ * режется на куски по границам строк и разбирается в vx_thread_count()
+ * потоков; min/max кусков сливаются в глобальные границы.
+ *
  * Попутно заполняет глобальные переменные x_min/x_max, y_min/y_max,
  * z_min/z_max и vert_count.
  *
@@ -153,6 +367,108 @@ void freeContainer(vxlist *c);
  */
 Vector3 *verts_from_ply(char *filename, Vector3 *verties);
 
+/**
+ * @brief Эталонный однопоточный загрузчик текстового PLY (fgets + atof).
+ *
+ * Сохранён для сравнения в бенчмарке ply-bench. Результат и побочные
+ * эффекты те же, что у verts_from_ply, но глобальные min/max
+ * сливаются с текущими значениями, а vert_count накапливается.
+ *
+ * @param filename Путь к PLY-файлу в формате ascii.
+ * @param verties  Указатель на массив (выделяется внутри функции).
+ * @return Указатель на массив вершин (необходимо освободить вызывающей стороной).
+ */
+Vector3 *verts_from_ply_stdio(char *filename, Vector3 *verties);
+
+/**
+ * @brief Считывает грани (element face) PLY-файла как треугольники.
+ *
+ * Индексы берутся из list-свойства vertex_indices (или vertex_index);
+ * многоугольники разбиваются веером. Поддерживаются ascii и binary,
+ * прочие свойства граней пропускаются. Индексы ссылаются на массив
+ * verts_from_ply того же файла; индекс вне диапазона — ошибка.
+ *
+ * @param filename Путь к PLY-файлу.
+ * @param t        [out] Треугольники (пустой список, если граней нет или
+ *                 при ошибке); освобождать free_trilist.
+ * @param err      [out] Текст ошибки или NULL.
+ * @return VX_OK или код ошибки.
+ */
+vx_status faces_from_ply(const char *filename, vx_trilist *t, vx_error *err);
+
+/**
+ * @brief Освобождает список треугольников и обнуляет его поля.
+ */
+void free_trilist(vx_trilist *t);
+
+/**
+ * @brief Потоковое чтение вершин PLY (см. ply_stream_open).
+ */
+typedef struct ply_stream ply_stream;
+
+/** Необязательные свойства вершин, которые читает ply_stream. */
+#define PLY_ATTR_COLOR  1 /**< red, green, blue.  */
+#define PLY_ATTR_NORMAL 2 /**< nx, ny, nz.        */
+
+/**
+ * @brief Открывает PLY-файл для чтения вершин кусками.
+ *
+ * В отличие от verts_from_ply, файл не загружается и не отображается
+ * целиком: читается только заголовок, дальше — через буфер постоянного
+ * размера (4 МБ). Глобальные границы и vert_count не меняются.
+ *
+ * @param filename     Путь к PLY-файлу (ascii или binary).
+ * @param vertex_count [out] Число вершин из заголовка или NULL.
+ * @param err          [out] Текст ошибки или NULL.
+ * @return Поток (закрывать ply_stream_close) или NULL при ошибке — код в err->status.
+ */
+ply_stream *ply_stream_open(const char *filename, long *vertex_count, vx_error *err);
+
+/**
+ * @brief Читает следующие вершины прохода (исходные, не нормализованные).
+ *
+ * @param out Буфер на @p max вершин.
+ * @return Прочитано вершин; 0 — проход окончен; -1 — ошибка (обрезанный
+ *         файл, слишком длинная строка), текст — ply_stream_error.
+ */
+long ply_stream_read(ply_stream *s, Vector3 *out, long max);
+
+/**
+ * @brief Ошибка потока: status == VX_OK, пока ошибок не было.
+ */
+const vx_error *ply_stream_error(const ply_stream *s);
+
+/**
+ * @brief Свойства вершин файла: PLY_ATTR_COLOR | PLY_ATTR_NORMAL.
+ *
+ * Свойство считается, только если все три его компоненты скалярные.
+ */
+int ply_stream_attrs(const ply_stream *s);
+
+/**
+ * @brief То же с цветом и нормалью вершин.
+ *
+ * Цвет — в шкале 0..255 (свойства float/double считаются заданными
+ * в 0..1 и умножаются на 255). Отсутствующее в файле свойство
+ * читается нулями.
+ *
+ * @param color  [out] Цвета (r, g, b) или NULL.
+ * @param normal [out] Нормали или NULL.
+ */
+long ply_stream_read_attrs(ply_stream *s, Vector3 *out, Vector3 *color, Vector3 *normal, long max);
+
+/**
+ * @brief Возвращает поток к первой вершине (для следующего прохода).
+ *
+ * @return VX_OK или VX_ERR_OPEN, если перейти к вершинам не удалось.
+ */
+vx_status ply_stream_rewind(ply_stream *s);
+
+/**
+ * @brief Закрывает поток и освобождает буфер.
+ */
+void ply_stream_close(ply_stream *s);
+
 /* =========================================================
  *  Нормализация
  * ========================================================= */
@@ -161,12 +477,22 @@ Vector3 *verts_from_ply(char *filename, Vector3 *verties);
  * @brief Нормализует координаты вершин в диапазон [0, norm_factor].
  *
  * После нормализации обновляет глобальные переменные min/max.
+ * Работает через векторное ядро vx_normalize_aos (AVX2 / SSE4.1 /
+ * скалярно) — того же устройства, что и ядро SoA-варианта.
  *
  * @param verties     Массив вершин для изменения (in-place).
  * @param norm_factor Масштаб нормализации (например, 5.0f).
  */
 void normalize_verties(Vector3 *verties, float norm_factor);
 
+/**
+ * @brief Нормализует SoA-вершины в диапазон [0, norm_factor].
+ *
+ * Результат побитно совпадает с normalize_verties; использует
+ * verties->count вместо vert_count.
+ */
+void normalize_verties_soa(vx_soa *verties, float norm_factor);
+
 /* =========================================================
  *  Построение сетки вокселей
  * ========================================================= */
@@ -206,10 +532,59 @@ void create_mesh(vxlist *mesh_vox, float cube_volume, int voxel_num,
                  float parallel_x, float parallel_y, float parallel_z,
                  float *voxel_w);
 
+/**
+ * @brief Готовит пустую разреженную сетку n×n×n над охватывающим параллелепипедом.
+ *
+ * Ребро вокселя вычисляется так же, как в create_mesh:
+ * cbrt(cube_volume / n³). Память под ячейки не выделяется —
+ * воксели появляются в ind_finder по мере попадания в них вершин.
+ * Допустимы n до 2 097 151 по оси (линейный индекс — 64 бита).
+ *
+ * @param mesh_vox    Указатель на список вокселей (перезаписывается).
+ * @param cube_volume Объём охватывающего параллелепипеда.
+ * @param n           Количество ячеек вдоль каждой оси.
+ * @param voxel_w     [out] Рассчитанный размер ребра вокселя.
+ */
+void create_sparse_mesh(vxlist *mesh_vox, float cube_volume, int n, float *voxel_w);
+
+/**
+ * @brief Создаёт плотную сетку n×n×n с вокселями в порядке Мортона.
+ *
+ * Ребро вокселя — как в create_mesh. ind_finder раскладывает вершины
+ * по кодам Мортона ячеек, vx_lookup находит ячейку по коду; вершины,
+ * заранее упорядоченные vx_morton_sort, ложатся в буфер points
+ * почти без скачков. Допустимы n до 1024 по оси.
+ *
+ * @param mesh_vox    Указатель на список вокселей (перезаписывается).
+ * @param cube_volume Объём охватывающего параллелепипеда.
+ * @param n           Количество ячеек вдоль каждой оси.
+ * @param voxel_w     [out] Рассчитанный размер ребра вокселя.
+ */
+void create_morton_mesh(vxlist *mesh_vox, float cube_volume, int n, float *voxel_w);
+
+/**
+ * @brief Возвращает воксель ячейки (xi, yi, zi) для плотной и разреженной сетки.
+ *
+ * @return Указатель на воксель или NULL, если ячейка вне сетки либо
+ *         (для разреженной сетки) не содержит вершин.
+ */
+Voxel *vx_lookup(const vxlist *mesh, int xi, int yi, int zi);
+
 /* =========================================================
  *  Вокселизация (определение принадлежности вершин вокселям)
  * ========================================================= */
 
+/**
+ * @brief Параметры раскладки вершин по вокселям (ind_finder_ex).
+ */
+typedef struct vx_bin_opts {
+    int        threads;       /**< Число потоков; 0 — vx_thread_count(), 1 — последовательно. */
+    bool       deterministic; /**< Сохранять порядок вершин внутри вокселя как во входном массиве. */
+    const int *cancel;        /**< Флаг отмены (читается атомарно) или NULL.            */
+    int       *progress;      /**< [out] Готовность 0..1000 (пишется атомарно) или NULL. */
+    vx_stats  *stats;         /**< [out] Выделения, вершины и занятые ячейки или NULL.  */
+} vx_bin_opts;
+
 /**
  * @brief Проверяет, находится ли вершина @p vert внутри вокселя @p vx.
  *
@@ -223,7 +598,18 @@ bool point_in_voxel(Voxel vx, Vector3 vert);
  * @brief Распределяет вершины модели по вокселям сетки.
  *
  * Для каждой вершины вычисляет индекс в одномерном массиве вокселей
- * по формуле i·(nx·ny) + j·ny + k и добавляет вершину в соответствующий воксель.
+ * по формуле zi·(nx·ny) + yi·nx + xi, где xi = trunc(clamp(x · (1/voxel_w),
+ * 0, nx − 1)); для плотной сетки индексы считает векторное ядро
+ * vx_quantize блоками вершин. Раскладка строится сортировкой
+ * подсчётом в два прохода: проход 1 считает гистограмму count по
+ * вокселям, префиксная сумма даёт offset, проход 2 раскладывает
+ * вершины в общий буфер mesh->points. Итого два выделения памяти
+ * на всю сетку. Порядок вершин внутри вокселя совпадает с порядком
+ * во входном массиве. Повторный вызов перестраивает раскладку заново.
+ *
+ * Для разреженной сетки проход 1 заводит воксель при первом попадании
+ * вершины в ячейку (поиск/вставка в mesh->cells), проход 2 находит
+ * его по той же таблице.
  *
  * @param mesh       Указатель на сетку вокселей.
  * @param vert       Массив вершин модели.
@@ -235,6 +621,130 @@ bool point_in_voxel(Voxel vx, Vector3 vert);
 void ind_finder(vxlist *mesh, Vector3 *vert,
                 float voxel_w, float parallel_x, float parallel_y, float parallel_z);
 
+/**
+ * @brief Раскладка вершин по вокселям с явными параметрами.
+ *
+ * ind_finder эквивалентен вызову с threads = 0 и deterministic = true.
+ * Для плотной сетки вершины делятся между потоками пула vx_parallel_run:
+ * при умеренном числе ячеек у каждого потока своя гистограмма, и
+ * результат побайтно совпадает с последовательным; для очень больших
+ * сеток используются атомарные счётчики — набор вершин каждого вокселя
+ * тот же, а порядок внутри вокселя восстанавливается, только если
+ * задан deterministic. Разреженная сетка раскладывается последовательно.
+ *
+ * Если opts->cancel задан и стал ненулевым, функция возвращается
+ * досрочно; раскладка сетки тогда не определена, но сетку можно
+ * освободить через freeContainer. opts->progress обновляется по мере
+ * обработки вершин (оба прохода — 0..1000) и может читаться из
+ * другого потока. В opts->stats (если задан) добавляются выделения
+ * памяти раскладки — буферы, рост items и таблицы ячеек разреженной
+ * сетки — и записываются число вершин и занятых ячеек.
+ *
+ * @param mesh    Указатель на сетку вокселей.
+ * @param vert    Массив вершин модели (vert_count штук).
+ * @param voxel_w Размер ребра вокселя.
+ * @param opts    Параметры раскладки.
+ */
+void ind_finder_ex(vxlist *mesh, Vector3 *vert, float voxel_w, const vx_bin_opts *opts);
+
+/**
+ * @brief Раскладка SoA-вершин по вокселям (как ind_finder_ex).
+ *
+ * Векторное ядро читает координаты прямо из массивов x/y/z без
+ * перестановки; количество вершин берётся из vert->count.
+ */
+void ind_finder_soa(vxlist *mesh, const vx_soa *vert, float voxel_w, const vx_bin_opts *opts);
+
+/**
+ * @brief Воксели, в которых не меньше @p min_count вершин, без обхода всей сетки.
+ *
+ * Возвращает хвост mesh->ranked: индексы вокселей по возрастанию count.
+ * Стоимость — двоичный поиск, O(log занятых).
+ *
+ * @param mesh      Сетка после ind_finder.
+ * @param min_count Порог (значения < 1 трактуются как 1).
+ * @param cells     [out] Указатель на первый подходящий индекс в mesh->ranked.
+ * @return Количество подходящих вокселей.
+ */
+int vx_cells_at_least(const vxlist *mesh, int min_count, const int **cells);
+
+/* =========================================================
+ *  Контекст вокселизации
+ *  Тот же конвейер, что verts_from_ply → normalize_verties →
+ *  create_mesh → ind_finder, но без глобального состояния.
+ * ========================================================= */
+
+/**
+ * @brief Создаёт пустой контекст.
+ */
+void vx_ctx_init(vx_ctx *ctx);
+
+/**
+ * @brief Освобождает вершины (если контекст ими владеет) и сетку, обнуляет поля.
+ *
+ * Обнуляются и замеры ctx->stats; остальные vx_ctx_* их только копят:
+ * загрузка — parse, нормализация — normalize, vx_ctx_mesh — mesh,
+ * vx_ctx_bin — bin вместе со счётчиками раскладки.
+ */
+void vx_ctx_free(vx_ctx *ctx);
+
+/**
+ * @brief Загружает вершины PLY-файла (как verts_from_ply) и их границы.
+ *
+ * Прежние вершины и сетка контекста освобождаются. При ошибке файла
+ * контекст остаётся пустым, а код и текст ошибки — в ctx->error.
+ *
+ * @return VX_OK или код ошибки.
+ */
+vx_status vx_ctx_load_ply(vx_ctx *ctx, const char *filename);
+
+/**
+ * @brief Копирует @p count вершин в контекст и находит их границы.
+ *
+ * Для вершин, полученных не из файла. Прежние вершины и сетка
+ * освобождаются.
+ */
+void vx_ctx_set_vertices(vx_ctx *ctx, const Vector3 *vertices, int count);
+
+/**
+ * @brief Готовит @p ctx к построению своей сетки над вершинами @p model.
+ *
+ * Вершины и границы не копируются: @p ctx только читает их, поэтому
+ * @p model должен жить дольше и не меняться, пока им пользуются.
+ * Так одна нормализованная модель раскладывается в сетки разных
+ * разрешений одновременно в нескольких потоках.
+ */
+void vx_ctx_share(vx_ctx *ctx, const vx_ctx *model);
+
+/**
+ * @brief Нормализует вершины контекста в [0, norm_factor] (как normalize_verties).
+ *
+ * Контекст должен владеть вершинами (не vx_ctx_share).
+ */
+void vx_ctx_normalize(vx_ctx *ctx, float norm_factor);
+
+/**
+ * @brief Объём охватывающего параллелепипеда ctx->bounds.
+ */
+float vx_ctx_volume(const vx_ctx *ctx);
+
+/**
+ * @brief Строит пустую сетку n×n×n над границами контекста.
+ *
+ * Ребро вокселя — cbrt(объём / n³), как у create_mesh; прежняя
+ * сетка освобождается. Ограничения n — как у create_*_mesh.
+ */
+void vx_ctx_mesh(vx_ctx *ctx, int n, vx_grid_kind kind);
+
+/**
+ * @brief Раскладывает вершины контекста по его сетке (ind_finder_ex).
+ *
+ * Замеры идут в opts->stats, если он задан, иначе в ctx->stats.
+ *
+ * @param opts Параметры раскладки или NULL (все ядра, детерминированно).
+ */
+void vx_ctx_bin(vx_ctx *ctx, const vx_bin_opts *opts);
+
 /* =========================================================
  *  Сортировка вокселей
  * ========================================================= */
@@ -278,7 +788,9 @@ void threeWayPartition(vxlist *arr, int low, int high, int *lt, int *gt);
  * @brief Трёхсторонняя быстрая сортировка вокселей по количеству вершин.
  *
  * После сортировки воксели с наибольшим количеством вершин
- * находятся в конце массива.
+ * находятся в конце массива. Порядок ячеек сетки при этом теряется:
+ * vx_lookup, occupied и ranked после сортировки недействительны —
+ * для запросов по порогу служит vx_cells_at_least.
  *
  * @param arr  Указатель на список вокселей.
  * @param low  Левая граница сортируемого подмассива.
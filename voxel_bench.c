@@ -0,0 +1,745 @@
+/* =========================================================
+ *  voxel_bench — замеры конвейера по стадиям
+ *
+ *  Для каждого синтетического облака (равномерное, сфера,
+ *  гауссовы кластеры, «всё в одном вокселе») и каждого
+ *  размера пишет бинарный PLY во временный файл и замеряет
+ *  verts_from_ply, normalize_verties, затем для каждого
+ *  разрешения сетки — create_mesh / create_sparse_mesh,
+ *  ind_finder_ex, битовую сетку vxbits_fill и заливку её
+ *  внутренности (vx_fill_interior), а для плотных сеток — обход
+ *  ячеек и запросы соседей в построчном порядке и в порядке
+ *  Мортона (vx_morton_sort + create_morton_mesh), а также
+ *  накопитель прореживания vx_accum (только счётчики и вместе с
+ *  суммами координат) и кадр программной трассировки лучей по
+ *  битовой сетке (vx_raycast, в колонке points — число лучей)
+ *  и экспорт её поверхности слитыми гранями (vx_greedy_mesh, в
+ *  колонке points — число треугольников) и поле расстояний до
+ *  занятых ячеек (vx_edt, до BENCH_EDT_MAX³ ячеек), а также
+ *  разметку её связных компонент (vx_label_components), и
+ *  поток кадров в инкрементную сетку vx_live (облако делится на
+ *  BENCH_LIVE_FRAMES кадров, окно — BENCH_LIVE_WINDOW последних).
+ *  По каждой стадии печатает время, точек/с, пик RSS и число
+ *  выделений памяти (CSV или JSON).
+ *
+ *  Запуск:  ./voxel-bench [опции]   (см. usage)
+ * ========================================================= */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include "voxel.h"
+#include "vxsys.h"
+#include "vxsimd.h"
+#include "vxbits.h"
+#include "vxmorton.h"
+#include "vxfill.h"
+#include "vxstream.h"
+#include "vxraycast.h"
+#include "vxgreedy.h"
+#include "vxedt.h"
+#include "vxlabel.h"
+#include "vxlive.h"
+
+#define BENCH_TMP    "voxel_bench_tmp.ply"
+#define BENCH_NORM   5.0f
+#define BENCH_MAX_LIST 16
+#define BENCH_IMAGE  512   /* сторона кадра vx_raycast, пикселей */
+#define BENCH_EDT_MAX 512  /* vx_edt — 4 байта на ячейку: на 1024³ это 4 ГБ */
+#define BENCH_LIVE_FRAMES 16
+#define BENCH_LIVE_WINDOW 4
+
+/* =========================================================
+ *  Подсчёт выделений памяти
+ *  Сборка с -DBENCH_COUNT_ALLOCS и -Wl,--wrap=malloc,... (GNU
+ *  ld) перехватывает malloc/calloc/realloc ядра; без неё
+ *  счётчики выводятся как -1.
+ * ========================================================= */
+static long long alloc_calls = 0;
+static long long alloc_bytes = 0;
+
+#ifdef BENCH_COUNT_ALLOCS
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *p, size_t size);
+
+static void count_alloc(size_t size)
+{
+    __atomic_fetch_add(&alloc_calls, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&alloc_bytes, (long long)size, __ATOMIC_RELAXED);
+}
+
+void *__wrap_malloc(size_t size)
+{
+    count_alloc(size);
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    count_alloc(n * size);
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *p, size_t size)
+{
+    count_alloc(size);
+    return __real_realloc(p, size);
+}
+#define ALLOCS_KNOWN 1
+#else
+#define ALLOCS_KNOWN 0
+#endif
+
+static void alloc_reset(void)
+{
+    __atomic_store_n(&alloc_calls, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&alloc_bytes, 0, __ATOMIC_RELAXED);
+}
+
+/* =========================================================
+ *  Генераторы облаков (воспроизводимые: splitmix64)
+ * ========================================================= */
+typedef enum { DIST_UNIFORM, DIST_SPHERE, DIST_GAUSS, DIST_SINGLE, DIST_COUNT } bench_dist;
+
+static const char *dist_names[DIST_COUNT] = {"uniform", "sphere", "gauss", "single"};
+
+/* Кластеров в DIST_GAUSS */
+#define GAUSS_CLUSTERS 16
+
+static uint64_t rng_next(uint64_t *s)
+{
+    uint64_t z = (*s += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/* Равномерно в [0, 1) */
+static float rng_float(uint64_t *s)
+{
+    return (float)(rng_next(s) >> 40) / 16777216.0f;
+}
+
+/* Стандартное нормальное (Бокс — Мюллер) */
+static float rng_gauss(uint64_t *s)
+{
+    float u = rng_float(s), v = rng_float(s);
+    return sqrtf(-2.0f * logf(u + 1e-12f)) * cosf(6.2831853f * v);
+}
+
+static void generate(bench_dist dist, Vector3 *v, long n)
+{
+    uint64_t seed = 0x5eed0000ULL + (uint64_t)dist;
+    Vector3  centers[GAUSS_CLUSTERS];
+    for (int c = 0; c < GAUSS_CLUSTERS; c++) {
+        centers[c] = (Vector3){rng_float(&seed), rng_float(&seed), rng_float(&seed)};
+    }
+
+    for (long i = 0; i < n; i++) {
+        switch (dist) {
+        case DIST_UNIFORM:
+            v[i] = (Vector3){rng_float(&seed), rng_float(&seed), rng_float(&seed)};
+            break;
+        case DIST_SPHERE: {
+            Vector3 g   = {rng_gauss(&seed), rng_gauss(&seed), rng_gauss(&seed)};
+            float   len = sqrtf(g.x * g.x + g.y * g.y + g.z * g.z) + 1e-12f;
+            v[i] = (Vector3){g.x / len, g.y / len, g.z / len};
+            break;
+        }
+        case DIST_GAUSS: {
+            Vector3 c = centers[rng_next(&seed) % GAUSS_CLUSTERS];
+            v[i] = (Vector3){c.x + 0.02f * rng_gauss(&seed),
+                             c.y + 0.02f * rng_gauss(&seed),
+                             c.z + 0.02f * rng_gauss(&seed)};
+            break;
+        }
+        default:
+            /* Две вершины задают габарит [0, 1]³, остальные — в кубике
+             * 1e-5: после нормализации это меньше ячейки даже при 1024³ */
+            if (i < 2) {
+                float a = (float)i;
+                v[i] = (Vector3){a, a, a};
+            } else {
+                v[i] = (Vector3){0.5f + 1e-5f * rng_float(&seed),
+                                 0.5f + 1e-5f * rng_float(&seed),
+                                 0.5f + 1e-5f * rng_float(&seed)};
+            }
+            break;
+        }
+    }
+}
+
+/* Бинарный PLY в порядке байт машины */
+static void write_binary_ply(const char *path, const Vector3 *v, long n)
+{
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        printf("Не удалось создать %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+    const uint16_t probe = 1;
+    bool little = *(const uint8_t *)&probe == 1;
+    fprintf(f, "ply\nformat %s 1.0\nelement vertex %ld\n"
+               "property float x\nproperty float y\nproperty float z\nend_header\n",
+            little ? "binary_little_endian" : "binary_big_endian", n);
+    if (fwrite(v, sizeof(Vector3), (size_t)n, f) != (size_t)n) {
+        printf("Ошибка записи %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+    fclose(f);
+}
+
+/* =========================================================
+ *  Опции и вывод
+ * ========================================================= */
+typedef struct {
+    long  sizes[BENCH_MAX_LIST];
+    int   size_count;
+    int   res[BENCH_MAX_LIST];
+    int   res_count;
+    bool  dists[DIST_COUNT];
+    int   threads;
+    int   reps;
+    bool  json;
+    FILE *out;
+} bench_opts;
+
+typedef struct {
+    bench_dist  dist;
+    long        points;
+    int         grid;      /* ячеек по оси; 0 — стадия без сетки */
+    bool        sparse;
+    const char *stage;
+    double      seconds;   /* минимум по повторам               */
+    long long   allocs;
+    long long   bytes;
+    size_t      peak_rss;
+    int         occupied;  /* занятых вокселей (bin, bits)      */
+} bench_row;
+
+static int rows_written = 0;
+
+static void emit(const bench_opts *o, const bench_row *r)
+{
+    double mpts = r->seconds > 0.0 ? (double)r->points / r->seconds * 1e-6 : 0.0;
+    double rss  = (double)r->peak_rss / (1024.0 * 1024.0);
+    long long allocs = ALLOCS_KNOWN ? r->allocs : -1;
+    long long bytes  = ALLOCS_KNOWN ? r->bytes : -1;
+
+    if (o->json) {
+        fprintf(o->out,
+                "%s  {\"dist\": \"%s\", \"points\": %ld, \"grid\": %d, \"sparse\": %s, "
+                "\"stage\": \"%s\", \"ms\": %.3f, \"mpts_per_s\": %.3f, \"allocs\": %lld, "
+                "\"alloc_bytes\": %lld, \"peak_rss_mb\": %.1f, \"occupied\": %d}",
+                rows_written ? ",\n" : "", dist_names[r->dist], r->points, r->grid,
+                r->sparse ? "true" : "false", r->stage, r->seconds * 1e3, mpts,
+                allocs, bytes, rss, r->occupied);
+    } else {
+        fprintf(o->out, "%s,%ld,%d,%d,%s,%.3f,%.3f,%lld,%lld,%.1f,%d\n",
+                dist_names[r->dist], r->points, r->grid, r->sparse ? 1 : 0, r->stage,
+                r->seconds * 1e3, mpts, allocs, bytes, rss, r->occupied);
+    }
+    fflush(o->out);
+    rows_written++;
+}
+
+/* Замер стадии: сброс счётчиков и пика RSS до, снятие после */
+typedef struct {
+    double t0;
+} bench_clock;
+
+static bench_clock stage_begin(void)
+{
+    alloc_reset();
+    vx_reset_peak_rss();
+    return (bench_clock){vx_now()};
+}
+
+static void stage_end(bench_clock c, bench_row *r, int rep)
+{
+    double s = vx_now() - c.t0;
+    if (rep == 0 || s < r->seconds) r->seconds = s;
+    r->allocs   = alloc_calls;
+    r->bytes    = alloc_bytes;
+    r->peak_rss = vx_peak_rss();
+}
+
+static void reset_bounds(void)
+{
+    x_max = 0; x_min = 10;
+    y_max = 0; y_min = 10;
+    z_max = 0; z_min = 10;
+    vert_count = 0;
+}
+
+/* =========================================================
+ *  Обход сетки: стадии iter / neigh
+ * ========================================================= */
+
+/* Все вершины по порядку вокселей: сумма координат */
+static double iterate_cells(const vxlist *mesh)
+{
+    double sum = 0.0;
+    for (int j = 0; j < mesh->count; j++) {
+        const Vector3 *p = vx_points(mesh, j);
+        for (int k = 0; k < mesh->items[j].count; k++) sum += p[k].x + p[k].y + p[k].z;
+    }
+    return sum;
+}
+
+/* Для каждого занятого вокселя — 26 соседей и первая вершина
+ * каждого непустого соседа (как при оценке нормалей). В сетке
+ * Мортона индекс соседа получается шагом vx_morton_step от кода
+ * вокселя, в построчной — сдвигом линейного индекса. */
+static double neighbour_queries(const vxlist *mesh)
+{
+    double  sum = 0.0;
+    float   w   = mesh->voxel_w;
+    int64_t nx  = mesh->nx, nxy = (int64_t)mesh->nx * mesh->ny;
+    for (int k = 0; k < mesh->occupied_count; k++) {
+        int          j  = mesh->occupied[k];
+        const Voxel *vx = &mesh->items[j];
+        int xi = (int)floorf((vx->vx_center.x - mesh->origin.x) / w);
+        int yi = (int)floorf((vx->vx_center.y - mesh->origin.y) / w);
+        int zi = (int)floorf((vx->vx_center.z - mesh->origin.z) / w);
+        for (int dz = -1; dz <= 1; dz++) {
+            if (zi + dz < 0 || zi + dz >= mesh->nz) continue;
+            uint64_t cz = mesh->morton && dz ? vx_morton_step((uint64_t)j, 2, dz) : (uint64_t)j;
+            for (int dy = -1; dy <= 1; dy++) {
+                if (yi + dy < 0 || yi + dy >= mesh->ny) continue;
+                uint64_t cy = mesh->morton && dy ? vx_morton_step(cz, 1, dy) : cz;
+                for (int dx = -1; dx <= 1; dx++) {
+                    if (xi + dx < 0 || xi + dx >= mesh->nx || (dx | dy | dz) == 0) continue;
+                    int64_t nb = mesh->morton ? (int64_t)(dx ? vx_morton_step(cy, 0, dx) : cy)
+                                              : j + dz * nxy + dy * nx + dx;
+                    if (mesh->items[nb].count == 0) continue;
+                    sum += mesh->points[mesh->items[nb].offset].x;
+                }
+            }
+        }
+    }
+    return sum;
+}
+
+/* Замер iter и neigh на готовой сетке; суффикс — имя раскладки */
+static void run_traversal(const bench_opts *o, bench_row row, const vxlist *mesh,
+                          const char *iter_stage, const char *neigh_stage)
+{
+    volatile double sink = 0.0;
+    row.occupied = mesh->occupied_count;
+
+    row.stage = iter_stage;
+    for (int rep = 0; rep < o->reps; rep++) {
+        bench_clock c = stage_begin();
+        sink += iterate_cells(mesh);
+        stage_end(c, &row, rep);
+    }
+    emit(o, &row);
+
+    row.stage = neigh_stage;
+    for (int rep = 0; rep < o->reps; rep++) {
+        bench_clock c = stage_begin();
+        sink += neighbour_queries(mesh);
+        stage_end(c, &row, rep);
+    }
+    emit(o, &row);
+    (void)sink;
+}
+
+/* =========================================================
+ *  run_case — одно облако, все разрешения
+ * ========================================================= */
+static void run_case(const bench_opts *o, bench_dist dist, long n)
+{
+    Vector3 *cloud = malloc((size_t)n * sizeof(Vector3));
+    assert(cloud != NULL);
+    generate(dist, cloud, n);
+    write_binary_ply(BENCH_TMP, cloud, n);
+    free(cloud);
+
+    bench_row row = {.dist = dist, .points = n};
+
+    /* --- verts_from_ply --- */
+    Vector3 *parsed = NULL;
+    row.stage = "parse";
+    for (int rep = 0; rep < o->reps; rep++) {
+        free(parsed);
+        reset_bounds();
+        bench_clock c = stage_begin();
+        parsed = verts_from_ply(BENCH_TMP, NULL);
+        stage_end(c, &row, rep);
+    }
+    emit(o, &row);
+    remove(BENCH_TMP);
+
+    /* --- normalize_verties: каждый повтор на свежей копии --- */
+    float    bounds[6] = {x_min, x_max, y_min, y_max, z_min, z_max};
+    Vector3 *vertices  = malloc((size_t)n * sizeof(Vector3));
+    assert(vertices != NULL);
+    row.stage = "normalize";
+    for (int rep = 0; rep < o->reps; rep++) {
+        memcpy(vertices, parsed, (size_t)n * sizeof(Vector3));
+        x_min = bounds[0]; x_max = bounds[1];
+        y_min = bounds[2]; y_max = bounds[3];
+        z_min = bounds[4]; z_max = bounds[5];
+        bench_clock c = stage_begin();
+        normalize_verties(vertices, BENCH_NORM);
+        stage_end(c, &row, rep);
+    }
+    emit(o, &row);
+
+    /* --- normalize_verties_soa: те же вершины в раскладке SoA --- */
+    vx_soa raw = soa_from_aos(parsed, (int)n);
+    vx_soa soa = make_soa((int)n);
+    row.stage  = "normalize_soa";
+    for (int rep = 0; rep < o->reps; rep++) {
+        memcpy(soa.x, raw.x, (size_t)n * sizeof(float));
+        memcpy(soa.y, raw.y, (size_t)n * sizeof(float));
+        memcpy(soa.z, raw.z, (size_t)n * sizeof(float));
+        x_min = bounds[0]; x_max = bounds[1];
+        y_min = bounds[2]; y_max = bounds[3];
+        z_min = bounds[4]; z_max = bounds[5];
+        bench_clock c = stage_begin();
+        normalize_verties_soa(&soa, BENCH_NORM);
+        stage_end(c, &row, rep);
+    }
+    emit(o, &row);
+    free_soa(&raw);
+    free(parsed);
+
+    float parallel_x  = x_max - x_min;
+    float parallel_y  = y_max - y_min;
+    float parallel_z  = z_max - z_min;
+    float cube_volume = parallel_x * parallel_y * parallel_z;
+
+    /* --- create_mesh / ind_finder по разрешениям --- */
+    vx_bin_opts bin = {.threads = o->threads, .deterministic = true};
+    for (int r = 0; r < o->res_count; r++) {
+        int       g = o->res[r];
+        bench_row mesh_row = row, bin_row = row;
+        mesh_row.grid   = bin_row.grid   = g;
+        mesh_row.sparse = bin_row.sparse = g > VX_DENSE_MAX;
+        mesh_row.stage  = "mesh";
+        bin_row.stage   = "bin";
+
+        vxlist mesh = {0};
+        float  voxel_w;
+        for (int rep = 0; rep < o->reps; rep++) {
+            freeContainer(&mesh);
+            bench_clock c = stage_begin();
+            if (mesh_row.sparse) create_sparse_mesh(&mesh, cube_volume, g, &voxel_w);
+            else                 create_mesh(&mesh, cube_volume, g * g * g,
+                                             parallel_x, parallel_y, parallel_z, &voxel_w);
+            stage_end(c, &mesh_row, rep);
+
+            c = stage_begin();
+            ind_finder_ex(&mesh, vertices, voxel_w, &bin);
+            stage_end(c, &bin_row, rep);
+        }
+
+        bin_row.occupied  = mesh.occupied_count;
+        mesh_row.occupied = bin_row.occupied;
+        emit(o, &mesh_row);
+        emit(o, &bin_row);
+
+        /* --- ind_finder_soa: раскладка SoA-вершин в такую же сетку --- */
+        bench_row soa_row = bin_row;
+        soa_row.stage = "bin_soa";
+        for (int rep = 0; rep < o->reps; rep++) {
+            freeContainer(&mesh);
+            if (soa_row.sparse) create_sparse_mesh(&mesh, cube_volume, g, &voxel_w);
+            else                create_mesh(&mesh, cube_volume, g * g * g,
+                                            parallel_x, parallel_y, parallel_z, &voxel_w);
+            bench_clock c = stage_begin();
+            ind_finder_soa(&mesh, &soa, voxel_w, &bin);
+            stage_end(c, &soa_row, rep);
+        }
+        soa_row.occupied = mesh.occupied_count;
+        emit(o, &soa_row);
+        if (!bin_row.sparse) {
+            run_traversal(o, bin_row, &mesh, "iter", "neigh");
+        }
+        freeContainer(&mesh);
+
+        /* --- порядок Мортона: вершины, затем плотная сетка --- */
+        if (!bin_row.sparse) {
+            bench_row sort_row = bin_row, morton_row = bin_row;
+            sort_row.stage   = "morton_sort";
+            morton_row.stage = "bin_morton";
+            Vector3 *sorted  = malloc((size_t)n * sizeof(Vector3));
+            assert(sorted != NULL);
+            vx_quant q = {.inv_w = 1.0f / voxel_w, .nx = g, .ny = g, .nz = g};
+            for (int rep = 0; rep < o->reps; rep++) {
+                memcpy(sorted, vertices, (size_t)n * sizeof(Vector3));
+                bench_clock c = stage_begin();
+                vx_morton_sort(sorted, (int)n, &q);
+                stage_end(c, &sort_row, rep);
+            }
+            emit(o, &sort_row);
+
+            for (int rep = 0; rep < o->reps; rep++) {
+                freeContainer(&mesh);
+                create_morton_mesh(&mesh, cube_volume, g, &voxel_w);
+                bench_clock c = stage_begin();
+                ind_finder_ex(&mesh, sorted, voxel_w, &bin);
+                stage_end(c, &morton_row, rep);
+            }
+            emit(o, &morton_row);
+            run_traversal(o, morton_row, &mesh, "iter_morton", "neigh_morton");
+            freeContainer(&mesh);
+            free(sorted);
+        }
+
+        /* --- vxbits_fill: только занятость, 1 бит на ячейку --- */
+        bench_row bits_row = row;
+        bits_row.grid  = g;
+        bits_row.stage = "bits";
+        vxbits bits = {0};
+        for (int rep = 0; rep < o->reps; rep++) {
+            vxbits_free(&bits);
+            bench_clock c = stage_begin();
+            vxbits_init(&bits, g, g, g, false);
+            vxbits_fill(&bits, vertices, (int)n, voxel_w);
+            stage_end(c, &bits_row, rep);
+        }
+        bits_row.occupied = (int)vxbits_popcount(&bits);
+        emit(o, &bits_row);
+
+        bench_row bits_soa_row = bits_row;
+        bits_soa_row.stage = "bits_soa";
+        vxbits soa_bits = {0};
+        for (int rep = 0; rep < o->reps; rep++) {
+            vxbits_free(&soa_bits);
+            bench_clock c = stage_begin();
+            vxbits_init(&soa_bits, g, g, g, false);
+            vxbits_fill_soa(&soa_bits, &soa, voxel_w);
+            stage_end(c, &bits_soa_row, rep);
+        }
+        bits_soa_row.occupied = (int)vxbits_popcount(&soa_bits);
+        emit(o, &bits_soa_row);
+        vxbits_free(&soa_bits);
+
+        /* --- vx_fill_interior: занятые ячейки как поверхность тела, на копии bits --- */
+        bench_row fill_row = bits_row;
+        fill_row.stage = "fill";
+        vxbits solid = {0};
+        for (int rep = 0; rep < o->reps; rep++) {
+            vxbits_free(&solid);
+            vxbits_init(&solid, g, g, g, false);
+            vxbits_union(&solid, &bits);
+            bench_clock c = stage_begin();
+            vx_fill_interior(&solid, &bin);
+            stage_end(c, &fill_row, rep);
+        }
+        fill_row.occupied = (int)vxbits_popcount(&solid);
+        emit(o, &fill_row);
+        vxbits_free(&solid);
+
+        /* --- vx_raycast: кадр BENCH_IMAGE² по той же сетке, пирамида строится вне замера --- */
+        bench_row ray_row = bits_row;
+        ray_row.stage  = "raycast";
+        ray_row.points = (long)BENCH_IMAGE * BENCH_IMAGE;
+        vx_raygrid rg;
+        vx_image   img;
+        vx_raygrid_init(&rg, &bits, (Vector3){0.0f, 0.0f, 0.0f}, voxel_w);
+        vx_image_init(&img, BENCH_IMAGE, BENCH_IMAGE);
+        vx_view view = vx_raygrid_view(&rg, (Vector3){1.0f, 0.7f, 1.3f}, 45.0f);
+        for (int rep = 0; rep < o->reps; rep++) {
+            bench_clock c = stage_begin();
+            vx_raycast(&img, &rg, &view, (Vector3){255.0f, 255.0f, 255.0f}, &bin);
+            stage_end(c, &ray_row, rep);
+        }
+        emit(o, &ray_row);
+        vx_image_free(&img);
+        vx_raygrid_free(&rg);
+
+        /* --- vx_greedy_mesh: поверхность той же сетки прямоугольниками, без записи --- */
+        bench_row greedy_row = bits_row;
+        greedy_row.stage = "greedy";
+        vx_quadlist quads = {0};
+        for (int rep = 0; rep < o->reps; rep++) {
+            bench_clock c = stage_begin();
+            vx_greedy_mesh(&quads, &bits, (Vector3){0.0f, 0.0f, 0.0f}, voxel_w, &bin);
+            stage_end(c, &greedy_row, rep);
+        }
+        greedy_row.points = (long)(quads.count * 2);
+        emit(o, &greedy_row);
+        vx_quads_free(&quads);
+
+        /* --- vx_edt: расстояния от всех ячеек до занятых --- */
+        if (g <= BENCH_EDT_MAX) {
+            bench_row edt_row = bits_row;
+            edt_row.stage = "edt";
+            vx_distfield field = {0};
+            for (int rep = 0; rep < o->reps; rep++) {
+                bench_clock c = stage_begin();
+                vx_edt(&field, &bits, voxel_w, &bin);
+                stage_end(c, &edt_row, rep);
+            }
+            emit(o, &edt_row);
+            vx_distfield_free(&field);
+        }
+
+        /* --- vx_label_components: 26-связные компоненты занятых ячеек --- */
+        bench_row label_row = bits_row;
+        label_row.stage = "label";
+        vx_labels labels = {0};
+        for (int rep = 0; rep < o->reps; rep++) {
+            bench_clock c = stage_begin();
+            vx_label_components(&labels, &bits, VX_CONN_26, &bin);
+            stage_end(c, &label_row, rep);
+        }
+        emit(o, &label_row);
+        vx_labels_free(&labels);
+        vxbits_free(&bits);
+
+        /* --- vx_accum: счётчики по занятым ячейкам, затем с суммами --- */
+        for (int fields = 0; fields <= VX_ACCUM_CENTROID; fields += VX_ACCUM_CENTROID) {
+            bench_row accum_row = row;
+            accum_row.grid   = g;
+            accum_row.sparse = true;
+            accum_row.stage  = fields ? "accum_centroid" : "accum";
+            vx_accum acc = {0};
+            for (int rep = 0; rep < o->reps; rep++) {
+                vx_accum_free(&acc);
+                bench_clock c = stage_begin();
+                vx_accum_init(&acc, g, g, g, voxel_w, (Vector3){x_min, y_min, z_min}, fields);
+                vx_accum_add(&acc, vertices, (int)n);
+                stage_end(c, &accum_row, rep);
+            }
+            accum_row.occupied = acc.count;
+            emit(o, &accum_row);
+            vx_accum_free(&acc);
+        }
+
+        /* --- vx_live: кадры по очереди, старые уходят из окна --- */
+        bench_row live_row = row;
+        live_row.grid   = g;
+        live_row.sparse = true;
+        live_row.stage  = "live";
+        vx_live live = {0};
+        long    step = (n + BENCH_LIVE_FRAMES - 1) / BENCH_LIVE_FRAMES;
+        for (int rep = 0; rep < o->reps; rep++) {
+            vx_live_free(&live);
+            bench_clock c = stage_begin();
+            vx_live_init(&live, g, g, g, voxel_w, (Vector3){x_min, y_min, z_min},
+                         BENCH_LIVE_WINDOW);
+            for (long i = 0; i < n; i += step) {
+                vx_live_push(&live, vertices + i, (int)(n - i < step ? n - i : step));
+            }
+            stage_end(c, &live_row, rep);
+        }
+        live_row.occupied = live.occupied;
+        emit(o, &live_row);
+        vx_live_free(&live);
+    }
+    free_soa(&soa);
+    free(vertices);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Использование: %s [опции]\n"
+            "  --sizes N,N,...   числа точек (по умолчанию 1000,10000,100000,1000000)\n"
+            "  --res N,N,...     ячеек по оси (по умолчанию 5,25,50,128,512,1024)\n"
+            "  --dist A,B,...    uniform,sphere,gauss,single (по умолчанию все)\n"
+            "  --full            10^3 .. 10^8 точек, 5³ .. 1024³ ячеек\n"
+            "  -t N              потоков (0 — все ядра)\n"
+            "  --reps N          повторов, берётся минимум (по умолчанию 1)\n"
+            "  --json            JSON вместо CSV\n"
+            "  -o FILE           файл результата (по умолчанию stdout)\n",
+            prog);
+    exit(EXIT_FAILURE);
+}
+
+/* Список чисел через запятую */
+static int parse_list(const char *s, long *out)
+{
+    int n = 0;
+    while (*s && n < BENCH_MAX_LIST) {
+        char *end;
+        out[n++] = strtol(s, &end, 10);
+        if (end == s || out[n - 1] <= 0) return -1;
+        s = *end == ',' ? end + 1 : end;
+    }
+    return n;
+}
+
+static bench_opts parse_args(int argc, char **argv)
+{
+    bench_opts o = {.sizes = {1000, 10000, 100000, 1000000}, .size_count = 4,
+                    .res = {5, 25, 50, 128, 512, 1024}, .res_count = 6,
+                    .dists = {true, true, true, true}, .threads = 0, .reps = 1,
+                    .json = false, .out = stdout};
+    long tmp[BENCH_MAX_LIST];
+
+    for (int i = 1; i < argc; i++) {
+        const char *a   = argv[i];
+        const char *val = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(a, "--sizes") == 0 && val) {
+            if ((o.size_count = parse_list(val, o.sizes)) <= 0) usage(argv[0]);
+            i++;
+        } else if (strcmp(a, "--res") == 0 && val) {
+            if ((o.res_count = parse_list(val, tmp)) <= 0) usage(argv[0]);
+            for (int k = 0; k < o.res_count; k++) o.res[k] = (int)tmp[k];
+            i++;
+        } else if (strcmp(a, "--dist") == 0 && val) {
+            for (int d = 0; d < DIST_COUNT; d++) o.dists[d] = strstr(val, dist_names[d]) != NULL;
+            i++;
+        } else if (strcmp(a, "--full") == 0) {
+            long sizes[] = {1000, 10000, 100000, 1000000, 10000000, 100000000};
+            int  res[]   = {5, 25, 50, 128, 256, 512, 1024};
+            o.size_count = 6;
+            o.res_count  = 7;
+            memcpy(o.sizes, sizes, sizeof(sizes));
+            memcpy(o.res, res, sizeof(res));
+        } else if (strcmp(a, "-t") == 0 && val) {
+            o.threads = atoi(val);
+            i++;
+        } else if (strcmp(a, "--reps") == 0 && val) {
+            o.reps = atoi(val) > 0 ? atoi(val) : 1;
+            i++;
+        } else if (strcmp(a, "--json") == 0) {
+            o.json = true;
+        } else if (strcmp(a, "-o") == 0 && val) {
+            o.out = fopen(val, "w");
+            if (o.out == NULL) {
+                printf("Не удалось создать %s\n", val);
+                exit(EXIT_FAILURE);
+            }
+            i++;
+        } else {
+            usage(argv[0]);
+        }
+    }
+    return o;
+}
+
+/* =========================================================
+ *  main
+ * ========================================================= */
+int main(int argc, char **argv)
+{
+    bench_opts o = parse_args(argc, argv);
+    if (o.threads > 0) vx_set_thread_count(o.threads);
+
+    fprintf(stderr, "voxel-bench: потоков %d, simd %s, morton %s, подсчёт выделений %s, сброс пика RSS %s\n",
+            vx_thread_count(), vx_simd_name(vx_simd_level()), vx_morton_name(vx_morton_level()),
+            ALLOCS_KNOWN ? "есть" : "нет", vx_reset_peak_rss() ? "есть" : "нет");
+
+    if (o.json) fprintf(o.out, "[\n");
+    else        fprintf(o.out, "dist,points,grid,sparse,stage,ms,mpts_per_s,allocs,alloc_bytes,peak_rss_mb,occupied\n");
+
+    for (int d = 0; d < DIST_COUNT; d++) {
+        if (!o.dists[d]) continue;
+        for (int s = 0; s < o.size_count; s++) run_case(&o, (bench_dist)d, o.sizes[s]);
+    }
+
+    if (o.json) fprintf(o.out, "\n]\n");
+    if (o.out != stdout) fclose(o.out);
+    return 0;
+}
@@ -0,0 +1,671 @@
+/* =========================================================
+ *  voxelize_cli — пакетная вокселизация без окна
+ *
+ *  Тот же конвейер, что и в просмотрщике (разбор PLY →
+ *  нормализация → create_mesh → ind_finder), без raylib, GL
+ *  и X11; замеры стадий печатаются в stderr. Режимы:
+ *    (по умолчанию) занятые воксели в CSV;
+ *    --surface, --solid  ячейки граней и залитое тело (vxfill.h);
+ *    --stream      файл кусками в два прохода (vxstream.h),
+ *                  --downsample — прореженное облако PLY;
+ *    --render      кадр трассировкой лучей в PPM (vxraycast.h);
+ *    --mesh        поверхность из слитых граней в PLY (vxgreedy.h);
+ *    --edt         поле расстояний до занятых ячеек (vxedt.h);
+ *    --components  связные компоненты в CSV (vxlabel.h).
+ *  Последние четыре берут ячейки вершин с порогом -m или
+ *  ячейки --surface / --solid.
+ *
+ *  Запуск:  ./voxelize-cli [опции] model.ply
+ * ========================================================= */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include "voxel.h"
+#include "vxsys.h"
+#include "vxmorton.h"
+#include "vxbits.h"
+#include "vxsurface.h"
+#include "vxfill.h"
+#include "vxstream.h"
+#include "vxraycast.h"
+#include "vxgreedy.h"
+#include "vxedt.h"
+#include "vxlabel.h"
+
+/* Сцена нормализуется в [0, VX_CLI_NORM], как в просмотрщике */
+#define VX_CLI_NORM 5.0f
+
+typedef struct {
+    const char *input;
+    const char *output;    /* NULL или "-" — stdout          */
+    int         cells;     /* -r: общее число ячеек          */
+    int         n;         /* -n: ячеек по оси               */
+    float       size;      /* -s: ребро вокселя              */
+    int         threads;   /* -t: 0 — все ядра               */
+    int         min_count; /* -m: порог вершин в вокселе     */
+    bool        sparse;    /* --sparse                       */
+    bool        morton;    /* --morton                       */
+    bool        surface;   /* --surface                      */
+    bool        solid;     /* --solid                        */
+    bool        stream;    /* --stream                       */
+    bool        centroids; /* --centroids                    */
+    bool        downsample;/* --downsample: PLY по вокселям  */
+    bool        nearest;   /* --nearest                      */
+    int         chunk;     /* --chunk: вершин в куске        */
+    const char *stats;     /* --stats: JSON замеров или NULL */
+    const char *render;    /* --render: PPM-кадр или NULL    */
+    int         image;     /* --image: сторона кадра         */
+    const char *mesh;      /* --mesh: PLY-сетка или NULL     */
+    const char *edt;       /* --edt: поле расстояний или NULL */
+    float       edt_step;  /* --edt-step: шаг uint16, 0 — float */
+    const char *components;/* --components: CSV компонент или NULL */
+    int         conn;      /* --conn: связность 6, 18 или 26 */
+    int         min_comp;  /* --min-component: порог ячеек   */
+    bool        quiet;     /* -q                             */
+} cli_opts;
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Использование: %s [опции] model.ply\n"
+            "  -r N       общее число ячеек (n = round(cbrt(N)))\n"
+            "  -n N       число ячеек по оси (по умолчанию 50)\n"
+            "  -s W       ребро вокселя в единицах сцены [0, %g]\n"
+            "  -t N       число потоков (0 — все ядра)\n"
+            "  -m N       оставить воксели, где вершин не меньше N (по умолчанию 1):\n"
+            "             в CSV, --downsample, --render, --mesh, --edt и --components;\n"
+            "             с --surface и --solid не действует\n"
+            "  -o FILE    файл результата (по умолчанию stdout)\n"
+            "  --sparse   разреженная сетка (включается сама при n > %d)\n"
+            "  --morton   упорядочить вершины и плотную сетку по коду Мортона\n"
+            "  --surface  добавить ячейки, которые пересекают грани (element face)\n"
+            "  --solid    то же и залить внутренность замкнутой поверхности\n"
+            "  --stream   читать файл кусками в два прохода, не храня вершины\n"
+            "  --centroids  (с --stream) добавить центроиды вершин вокселя mx,my,mz\n"
+            "  --chunk N  вершин в куске для --stream (по умолчанию %d)\n"
+            "  --downsample  (с --stream) записать в -o PLY: центроид вершин каждого\n"
+            "             вокселя, средние цвет и нормаль, если они есть в файле\n"
+            "  --nearest  то же, но вершина облака, ближайшая к центроиду (третий проход)\n"
+            "  --render FILE  нарисовать занятые ячейки трассировкой лучей в PPM\n"
+            "  --image N  сторона кадра --render в пикселях (по умолчанию 512)\n"
+            "  --mesh FILE  записать поверхность занятых ячеек треугольниками в PLY,\n"
+            "             соседние грани слиты в прямоугольники (координаты сцены)\n"
+            "  --edt FILE  записать расстояния от центра каждой ячейки до ближайшей\n"
+            "             занятой: n³ float без заголовка, X быстрее всего\n"
+            "  --edt-step S  то же в uint16 с шагом S единиц сцены (65535 — дальше)\n"
+            "  --components FILE  записать связные компоненты занятых ячеек в CSV:\n"
+            "             число ячеек и рамка каждой (\"-\" — stdout)\n"
+            "  --conn N   связность компонент: 6, 18 или 26 (по умолчанию 26)\n"
+            "  --min-component K  убрать компоненты меньше K ячеек из --components,\n"
+            "             --render, --mesh и --edt\n"
+            "  --stats FILE  записать замеры стадий и счётчики раскладки в JSON\n"
+            "             (\"-\" — stderr; при сборке STATS=0 — нули)\n"
+            "  -q         не печатать замеры\n",
+            prog, VX_CLI_NORM, VX_DENSE_MAX, VX_STREAM_CHUNK);
+    exit(EXIT_FAILURE);
+}
+
+static const char *next_arg(int argc, char **argv, int *i)
+{
+    if (*i + 1 >= argc) usage(argv[0]);
+    return argv[++*i];
+}
+
+static cli_opts parse_args(int argc, char **argv)
+{
+    cli_opts o = {.input = NULL, .output = NULL, .cells = 0, .n = 0, .size = 0.0f,
+                  .threads = 0, .min_count = 1, .sparse = false, .morton = false,
+                  .surface = false, .solid = false, .stream = false, .centroids = false,
+                  .downsample = false, .nearest = false, .chunk = VX_STREAM_CHUNK, .stats = NULL,
+                  .render = NULL, .image = 512, .mesh = NULL, .edt = NULL, .edt_step = 0.0f,
+                  .components = NULL, .conn = VX_CONN_26, .min_comp = 1, .quiet = false};
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        if      (strcmp(a, "-r") == 0)       o.cells     = atoi(next_arg(argc, argv, &i));
+        else if (strcmp(a, "-n") == 0)       o.n         = atoi(next_arg(argc, argv, &i));
+        else if (strcmp(a, "-s") == 0)       o.size      = (float)atof(next_arg(argc, argv, &i));
+        else if (strcmp(a, "-t") == 0)       o.threads   = atoi(next_arg(argc, argv, &i));
+        else if (strcmp(a, "-m") == 0)       o.min_count = atoi(next_arg(argc, argv, &i));
+        else if (strcmp(a, "-o") == 0)       o.output    = next_arg(argc, argv, &i);
+        else if (strcmp(a, "--sparse") == 0) o.sparse    = true;
+        else if (strcmp(a, "--morton") == 0) o.morton    = true;
+        else if (strcmp(a, "--surface") == 0) o.surface  = true;
+        else if (strcmp(a, "--solid") == 0)   o.solid = o.surface = true;
+        else if (strcmp(a, "--stream") == 0)  o.stream   = true;
+        else if (strcmp(a, "--centroids") == 0) o.centroids = o.stream = true;
+        else if (strcmp(a, "--downsample") == 0) o.downsample = o.stream = true;
+        else if (strcmp(a, "--nearest") == 0) o.nearest = o.downsample = o.stream = true;
+        else if (strcmp(a, "--chunk") == 0)   o.chunk    = atoi(next_arg(argc, argv, &i));
+        else if (strcmp(a, "--stats") == 0)   o.stats    = next_arg(argc, argv, &i);
+        else if (strcmp(a, "--render") == 0)  o.render   = next_arg(argc, argv, &i);
+        else if (strcmp(a, "--image") == 0)   o.image    = atoi(next_arg(argc, argv, &i));
+        else if (strcmp(a, "--mesh") == 0)    o.mesh     = next_arg(argc, argv, &i);
+        else if (strcmp(a, "--edt") == 0)     o.edt      = next_arg(argc, argv, &i);
+        else if (strcmp(a, "--edt-step") == 0) o.edt_step = (float)atof(next_arg(argc, argv, &i));
+        else if (strcmp(a, "--components") == 0) o.components = next_arg(argc, argv, &i);
+        else if (strcmp(a, "--conn") == 0)    o.conn     = atoi(next_arg(argc, argv, &i));
+        else if (strcmp(a, "--min-component") == 0) o.min_comp = atoi(next_arg(argc, argv, &i));
+        else if (strcmp(a, "-q") == 0)       o.quiet     = true;
+        else if (a[0] == '-' && a[1] != '\0') usage(argv[0]);
+        else if (o.input == NULL)            o.input     = a;
+        else usage(argv[0]);
+    }
+    if (o.input == NULL) usage(argv[0]);
+    if (o.cells < 0 || o.n < 0 || o.size < 0.0f || o.threads < 0 || o.chunk < 1 || o.image < 1 ||
+        o.edt_step < 0.0f || o.min_comp < 1 ||
+        (o.conn != VX_CONN_6 && o.conn != VX_CONN_18 && o.conn != VX_CONN_26)) usage(argv[0]);
+    if (o.morton && o.surface) {
+        /* сортировка переставляет вершины, и индексы граней теряют смысл */
+        fprintf(stderr, "--morton несовместим с --surface и --solid\n");
+        exit(EXIT_FAILURE);
+    }
+    if (o.stream && (o.morton || o.surface || o.render || o.mesh || o.edt || o.components ||
+                     o.min_comp > 1)) {
+        /* без массива вершин нет ни сортировки, ни граней по индексам */
+        fprintf(stderr, "--stream несовместим с --morton, --surface, --solid, --render, --mesh, "
+                        "--edt, --components и --min-component\n");
+        exit(EXIT_FAILURE);
+    }
+    if (o.downsample && (o.output == NULL || strcmp(o.output, "-") == 0)) {
+        /* binary PLY в терминал не пишется */
+        fprintf(stderr, "--downsample требует -o FILE\n");
+        exit(EXIT_FAILURE);
+    }
+    return o;
+}
+
+/* Координата ячейки по центру вокселя */
+static int64_t cell_axis(float center, float origin, float w)
+{
+    return (int64_t)floorf((center - origin) / w);
+}
+
+/* Ошибка записи файла результата: сообщение и выход */
+static void check_write(vx_status st, const vx_error *err)
+{
+    if (st == VX_OK) return;
+    fprintf(stderr, "%s\n", err->message);
+    exit(EXIT_FAILURE);
+}
+
+/* Ячейки вершин в битовую сетку; с -m N — только воксели, где
+ * вершин не меньше N (по сетке после раскладки) */
+static void fill_vertex_bits(vxbits *bits, const cli_opts *o, const vx_ctx *ctx)
+{
+    if (o->min_count <= 1) {
+        vxbits_fill(bits, ctx->vertices, ctx->vert_count, ctx->voxel_w);
+        return;
+    }
+    const vxlist *mesh = &ctx->mesh;
+    const int    *hits;
+    int           occupied = vx_cells_at_least(mesh, o->min_count, &hits);
+    for (int k = 0; k < occupied; k++) {
+        const Voxel *vx = &mesh->items[hits[k]];
+        int xi = (int)cell_axis(vx->vx_center.x, mesh->origin.x, mesh->voxel_w);
+        int yi = (int)cell_axis(vx->vx_center.y, mesh->origin.y, mesh->voxel_w);
+        int zi = (int)cell_axis(vx->vx_center.z, mesh->origin.z, mesh->voxel_w);
+        vxbits_set(bits, vxbits_cell(bits, xi, yi, zi));
+    }
+}
+
+/* =========================================================
+ *  write_voxels
+ *  CSV: xi,yi,zi,cx,cy,cz,count по возрастанию линейного
+ *  индекса ячейки; строки '#' — описание сетки.
+ *  Возвращает число записанных вокселей.
+ * ========================================================= */
+static int write_voxels(FILE *f, const cli_opts *o, const vxlist *mesh)
+{
+    const int *hits;
+    int        occupied = vx_cells_at_least(mesh, o->min_count, &hits);
+    vx_keyed  *cells    = malloc(((size_t)occupied + 1) * sizeof(vx_keyed));
+    assert(cells != NULL);
+
+    float w = mesh->voxel_w;
+    for (int k = 0; k < occupied; k++) {
+        const Voxel *vx = &mesh->items[hits[k]];
+        int64_t xi = cell_axis(vx->vx_center.x, mesh->origin.x, w);
+        int64_t yi = cell_axis(vx->vx_center.y, mesh->origin.y, w);
+        int64_t zi = cell_axis(vx->vx_center.z, mesh->origin.z, w);
+        cells[k].key  = zi * mesh->nx * mesh->ny + yi * mesh->nx + xi;
+        cells[k].item = hits[k];
+    }
+    qsort(cells, occupied, sizeof(vx_keyed), vx_keyed_compare);
+
+    fprintf(f, "# input %s\n", o->input);
+    fprintf(f, "# points %d\n", mesh->point_count);
+    fprintf(f, "# grid %d %d %d %s\n", mesh->nx, mesh->ny, mesh->nz,
+            mesh->sparse ? "sparse" : "dense");
+    fprintf(f, "# voxel_w %.9g\n", w);
+    fprintf(f, "# origin %.9g %.9g %.9g\n", mesh->origin.x, mesh->origin.y, mesh->origin.z);
+    fprintf(f, "# occupied %d\n", occupied);
+    fprintf(f, "xi,yi,zi,cx,cy,cz,count\n");
+
+    int64_t nxy = (int64_t)mesh->nx * mesh->ny;
+    for (int k = 0; k < occupied; k++) {
+        const Voxel *vx = &mesh->items[cells[k].item];
+        int64_t key = cells[k].key;
+        fprintf(f, "%lld,%lld,%lld,%.6g,%.6g,%.6g,%d\n",
+                (long long)(key % mesh->nx), (long long)(key / mesh->nx % mesh->ny),
+                (long long)(key / nxy),
+                vx->vx_center.x, vx->vx_center.y, vx->vx_center.z, vx->count);
+    }
+
+    free(cells);
+    return occupied;
+}
+
+/* =========================================================
+ *  write_surface
+ *  То же для --surface: занятые биты по возрастанию линейного
+ *  индекса (vxbits_next), count — вершины ячейки (0 там, где
+ *  поверхность прошла между вершинами, и во внутренности
+ *  --solid). Порог -m не действует.
+ * ========================================================= */
+static int write_surface(FILE *f, const cli_opts *o, const vxlist *mesh,
+                         const vxbits *bits, int tri_count, int64_t interior)
+{
+    float w = mesh->voxel_w;
+    fprintf(f, "# input %s\n", o->input);
+    fprintf(f, "# points %d\n", mesh->point_count);
+    fprintf(f, "# triangles %d\n", tri_count);
+    fprintf(f, "# grid %d %d %d %s\n", mesh->nx, mesh->ny, mesh->nz,
+            mesh->sparse ? "sparse" : "dense");
+    fprintf(f, "# voxel_w %.9g\n", w);
+    fprintf(f, "# origin %.9g %.9g %.9g\n", mesh->origin.x, mesh->origin.y, mesh->origin.z);
+    fprintf(f, "# occupied %lld\n", (long long)vxbits_popcount(bits));
+    if (o->solid) fprintf(f, "# interior %lld\n", (long long)interior);
+    fprintf(f, "xi,yi,zi,cx,cy,cz,count\n");
+
+    int     occupied = 0;
+    int64_t nxy      = (int64_t)mesh->nx * mesh->ny;
+    for (int64_t c = vxbits_next(bits, 0); c >= 0; c = vxbits_next(bits, c + 1)) {
+        int xi = (int)(c % mesh->nx), yi = (int)(c / mesh->nx % mesh->ny), zi = (int)(c / nxy);
+        const Voxel *vx = vx_lookup(mesh, xi, yi, zi);
+        fprintf(f, "%d,%d,%d,%.6g,%.6g,%.6g,%d\n", xi, yi, zi,
+                mesh->origin.x + ((float)xi + 0.5f) * w,
+                mesh->origin.y + ((float)yi + 0.5f) * w,
+                mesh->origin.z + ((float)zi + 0.5f) * w, vx ? vx->count : 0);
+        occupied++;
+    }
+    return occupied;
+}
+
+/* Разрешение: -n, затем -r, затем -s; по умолчанию 50³ */
+static int grid_size(const cli_opts *o, float cube_volume)
+{
+    int n = 50;
+    if (o->n > 0)              n = o->n;
+    else if (o->cells > 0)     n = (int)round(cbrt((double)o->cells));
+    else if (o->size > 0.0f)   n = (int)lroundf(cbrtf(cube_volume) / o->size);
+    return n < 1 ? 1 : n;
+}
+
+/* =========================================================
+ *  write_accum
+ *  То же для --stream: ячейки накопителя по возрастанию
+ *  линейного индекса; с --centroids — ещё центроид вершин.
+ * ========================================================= */
+static int write_accum(FILE *f, const cli_opts *o, const vx_accum *acc)
+{
+    int *order;
+    int  occupied = vx_accum_sorted(acc, o->min_count, &order);
+
+    float w = acc->voxel_w;
+    fprintf(f, "# input %s\n", o->input);
+    fprintf(f, "# points %lld\n", (long long)acc->point_count);
+    fprintf(f, "# grid %d %d %d stream\n", acc->nx, acc->ny, acc->nz);
+    fprintf(f, "# voxel_w %.9g\n", w);
+    fprintf(f, "# origin %.9g %.9g %.9g\n", acc->origin.x, acc->origin.y, acc->origin.z);
+    fprintf(f, "# occupied %d\n", occupied);
+    fprintf(f, o->centroids ? "xi,yi,zi,cx,cy,cz,count,mx,my,mz\n" : "xi,yi,zi,cx,cy,cz,count\n");
+
+    int64_t nxy = (int64_t)acc->nx * acc->ny;
+    for (int k = 0; k < occupied; k++) {
+        int     i   = order[k];
+        int64_t key = acc->keys[i];
+        int     xi  = (int)(key % acc->nx), yi = (int)(key / acc->nx % acc->ny), zi = (int)(key / nxy);
+        fprintf(f, "%d,%d,%d,%.6g,%.6g,%.6g,%lld", xi, yi, zi,
+                acc->origin.x + ((float)xi + 0.5f) * w,
+                acc->origin.y + ((float)yi + 0.5f) * w,
+                acc->origin.z + ((float)zi + 0.5f) * w, (long long)acc->counts[i]);
+        if (o->centroids) {
+            Vector3 m = vx_accum_centroid(acc, i);
+            fprintf(f, ",%.6g,%.6g,%.6g", m.x, m.y, m.z);
+        }
+        fputc('\n', f);
+    }
+    free(order);
+    return occupied;
+}
+
+/* =========================================================
+ *  write_components
+ *  --components: компоненты не меньше --min-component ячеек
+ *  по возрастанию индекса первой ячейки; рамка — индексы
+ *  крайних ячеек включительно.
+ * ========================================================= */
+static void write_components(const char *path, const cli_opts *o, const vx_labels *l)
+{
+    FILE *f = stdout;
+    if (strcmp(path, "-") != 0) {
+        f = fopen(path, "w");
+        if (f == NULL) {
+            fprintf(stderr, "Не удалось создать %s\n", path);
+            exit(EXIT_FAILURE);
+        }
+    }
+    fprintf(f, "# input %s\n", o->input);
+    fprintf(f, "# connectivity %d\n", l->conn);
+    fprintf(f, "# components %d\n", l->count);
+    fprintf(f, "# min_cells %d\n", o->min_comp);
+    fprintf(f, "id,cells,x0,y0,z0,x1,y1,z1\n");
+    for (int i = 0; i < l->count; i++) {
+        const vx_component *c = &l->items[i];
+        if (c->cells < o->min_comp) continue;
+        fprintf(f, "%d,%lld,%d,%d,%d,%d,%d,%d\n", i + 1, (long long)c->cells,
+                c->lo[0], c->lo[1], c->lo[2], c->hi[0], c->hi[1], c->hi[2]);
+    }
+    if (f != stdout) fclose(f);
+}
+
+/* --stats: замеры одним JSON-объектом */
+static void write_stats(const char *path, const vx_stats *st)
+{
+    FILE *f = stderr;
+    if (strcmp(path, "-") != 0) {
+        f = fopen(path, "w");
+        if (f == NULL) {
+            fprintf(stderr, "Не удалось создать %s\n", path);
+            exit(EXIT_FAILURE);
+        }
+    }
+    vx_stats_write_json(f, st);
+    if (f != stderr) fclose(f);
+}
+
+/* =========================================================
+ *  run_stream
+ *  --stream: границы первым проходом, затем куски сразу в
+ *  накопитель. В памяти — кусок, буфер чтения и занятые ячейки.
+ *  --downsample копит ещё суммы координат, цвета и нормалей,
+ *  --nearest добавляет третий проход.
+ * ========================================================= */
+static int run_stream(const cli_opts *o)
+{
+    double         t0 = vx_now();
+    vx_stream_norm norm;
+    vx_error       err = {0};
+    if (vx_stream_bounds(&norm, o->input, VX_CLI_NORM, o->chunk, &err) != VX_OK) {
+        fprintf(stderr, "%s\n", err.message);
+        return EXIT_FAILURE;
+    }
+    double         t1 = vx_now();
+
+    const vx_bounds *b           = &norm.bounds;
+    float            cube_volume = (b->x_max - b->x_min) * (b->y_max - b->y_min) * (b->z_max - b->z_min);
+    if (norm.points == 0 || !(cube_volume > 0.0f)) {
+        fprintf(stderr, "%s: модель вырождена (пустая или плоская)\n", o->input);
+        return EXIT_FAILURE;
+    }
+
+    int      n       = grid_size(o, cube_volume);
+    float    voxel_w = cbrtf(cube_volume / ((float)n * (float)n * (float)n));
+    int      fields  = o->centroids || o->downsample ? VX_ACCUM_CENTROID : 0;
+    if (o->downsample && (norm.attrs & PLY_ATTR_COLOR))  fields |= VX_ACCUM_COLOR;
+    if (o->downsample && (norm.attrs & PLY_ATTR_NORMAL)) fields |= VX_ACCUM_NORMAL;
+
+    vx_accum acc;
+    vx_accum_init(&acc, n, n, n, voxel_w, (Vector3){b->x_min, b->y_min, b->z_min}, fields);
+    if (vx_stream_bin(&acc, o->input, &norm, o->chunk, &err) != VX_OK ||
+        (o->nearest && vx_stream_nearest(&acc, o->input, &norm, o->chunk, &err) != VX_OK)) {
+        fprintf(stderr, "%s\n", err.message);
+        vx_accum_free(&acc);
+        return EXIT_FAILURE;
+    }
+    double t2 = vx_now();
+
+    int occupied;
+    if (o->downsample) {
+        if (vx_accum_write_ply(&acc, o->output, &norm, o->min_count, o->nearest, &occupied,
+                               &err) != VX_OK) {
+            fprintf(stderr, "%s\n", err.message);
+            vx_accum_free(&acc);
+            return EXIT_FAILURE;
+        }
+    } else {
+        FILE *f = stdout;
+        if (o->output != NULL && strcmp(o->output, "-") != 0) {
+            f = fopen(o->output, "w");
+            if (f == NULL) {
+                fprintf(stderr, "Не удалось создать %s\n", o->output);
+                exit(EXIT_FAILURE);
+            }
+        }
+        occupied = write_accum(f, o, &acc);
+        if (f != stdout) fclose(f);
+    }
+    double t3 = vx_now();
+
+    if (o->stats != NULL) {
+        /* Проходы потока: границы — parse, накопление — bin */
+        vx_stats st = {0};
+        VX_STATS_ADD(&st, VX_STAGE_PARSE, (t1 - t0) * 1e3);
+        VX_STATS_ADD(&st, VX_STAGE_BIN,   (t2 - t1) * 1e3);
+        VX_STATS_ADD(&st, VX_STAGE_WRITE, (t3 - t2) * 1e3);
+        VX_STATS_SET(&st, points, norm.points);
+        VX_STATS_SET(&st, occupied, acc.count);
+        write_stats(o->stats, &st);
+    }
+
+    if (!o->quiet) {
+        fprintf(stderr,
+                "%s: %lld вершин, сетка %d³ (поток, кусок %d), voxel_w %.6g, занято %d\n"
+                "  bounds %.1f ms  bin %.1f ms  write %.1f ms\n"
+                "  накопитель %.1f МБ, пик RSS %.1f МБ\n",
+                o->input, (long long)norm.points, n, o->chunk, voxel_w, occupied,
+                (t1 - t0) * 1e3, (t2 - t1) * 1e3, (t3 - t2) * 1e3,
+                vx_accum_bytes(&acc) / 1048576.0, vx_peak_rss() / 1048576.0);
+    }
+    vx_accum_free(&acc);
+    return EXIT_SUCCESS;
+}
+
+/* =========================================================
+ *  main
+ * ========================================================= */
+int main(int argc, char **argv)
+{
+    cli_opts o = parse_args(argc, argv);
+    if (o.threads > 0) vx_set_thread_count(o.threads);
+    if (o.stream) return run_stream(&o);
+
+    /* --- Разбор и нормализация --- */
+    vx_ctx ctx;
+    vx_ctx_init(&ctx);
+    double t0 = vx_now();
+    if (vx_ctx_load_ply(&ctx, o.input) != VX_OK) {
+        fprintf(stderr, "%s\n", ctx.error.message);
+        return EXIT_FAILURE;
+    }
+    double t1 = vx_now();
+    vx_ctx_normalize(&ctx, VX_CLI_NORM);
+    double t2 = vx_now();
+
+    float cube_volume = vx_ctx_volume(&ctx);
+    if (ctx.vert_count == 0 || !(cube_volume > 0.0f)) {
+        fprintf(stderr, "%s: модель вырождена (пустая или плоская)\n", o.input);
+        vx_ctx_free(&ctx);
+        return EXIT_FAILURE;
+    }
+
+    int  n      = grid_size(&o, cube_volume);
+    bool sparse = o.sparse || n > VX_DENSE_MAX;
+
+    /* --- Сетка и раскладка вершин --- */
+    vx_ctx_mesh(&ctx, n, sparse ? VX_GRID_SPARSE : o.morton ? VX_GRID_MORTON : VX_GRID_DENSE);
+    float voxel_w = ctx.voxel_w;
+    if (o.morton) {
+        vx_quant q = {.inv_w = 1.0f / voxel_w, .nx = n, .ny = n, .nz = n};
+        vx_morton_sort(ctx.vertices, ctx.vert_count, &q);
+    }
+    double t3 = vx_now();
+
+    vx_bin_opts bin = {.threads = o.threads, .deterministic = true};
+    vx_ctx_bin(&ctx, &bin);
+    double t4 = vx_now();
+
+    /* --- Поверхность: ячейки вершин плюс ячейки, которые пересекают грани --- */
+    vxbits     bits = {0};
+    vx_trilist tris = {0};
+    double     tf   = t4, ts = t4, tv = t4;
+    int64_t    interior = 0;
+    if (o.surface) {
+        vx_error err = {0};
+        if (faces_from_ply(o.input, &tris, &err) != VX_OK) {
+            fprintf(stderr, "%s\n", err.message);
+            vx_ctx_free(&ctx);
+            return EXIT_FAILURE;
+        }
+        tf   = vx_now();
+        vxbits_init(&bits, n, n, n, false);
+        vxbits_fill(&bits, ctx.vertices, ctx.vert_count, voxel_w);
+        vx_voxelize_surface(&bits, ctx.vertices, &tris, voxel_w, &bin);
+        ts   = tv = vx_now();
+        VX_STATS_ADD(&ctx.stats, VX_STAGE_PARSE,   (tf - t4) * 1e3);
+        VX_STATS_ADD(&ctx.stats, VX_STAGE_SURFACE, (ts - tf) * 1e3);
+    }
+    if (o.solid) {
+        interior = vx_fill_interior(&bits, &bin);
+        tv       = vx_now();
+        VX_STATS_ADD(&ctx.stats, VX_STAGE_FILL, (tv - ts) * 1e3);
+    }
+
+    /* --- Вывод --- */
+    FILE *f = stdout;
+    if (o.output != NULL && strcmp(o.output, "-") != 0) {
+        f = fopen(o.output, "w");
+        if (f == NULL) {
+            fprintf(stderr, "Не удалось создать %s\n", o.output);
+            exit(EXIT_FAILURE);
+        }
+    }
+    int occupied = o.surface ? write_surface(f, &o, &ctx.mesh, &bits, tris.count, interior)
+                             : write_voxels(f, &o, &ctx.mesh);
+    if (f != stdout) fclose(f);
+    double t5 = vx_now();
+    VX_STATS_ADD(&ctx.stats, VX_STAGE_WRITE, (t5 - tv) * 1e3);
+
+    /* --- Компоненты, кадр, сетка и расстояния: ячейки поверхности/тела или ячейки вершин --- */
+    bool labels_on = o.components != NULL || o.min_comp > 1;
+    if ((labels_on || o.render != NULL || o.mesh != NULL || o.edt != NULL) && !o.surface) {
+        vxbits_init(&bits, n, n, n, false);
+        fill_vertex_bits(&bits, &o, &ctx);
+    }
+    double    tl = vx_now(), tk = tl;
+    vx_labels labels  = {0};
+    int64_t   dropped = 0;
+    int       kept    = 0;
+    if (labels_on) {
+        vx_label_components(&labels, &bits, (vx_connectivity)o.conn, &bin);
+        tk = vx_now();
+        for (int i = 0; i < labels.count; i++) kept += labels.items[i].cells >= o.min_comp;
+        if (o.components != NULL) write_components(o.components, &o, &labels);
+        if (o.min_comp > 1) dropped = vx_labels_filter(&labels, &bits, o.min_comp, &bin);
+        VX_STATS_ADD(&ctx.stats, VX_STAGE_LABEL, (tk - tl) * 1e3);
+    }
+    double  tr        = vx_now();
+    double  t6        = tr;
+    int64_t ray_steps = 0;
+    if (o.render != NULL) {
+        vx_raygrid rg;
+        vx_image   img;
+        vx_raygrid_init(&rg, &bits, (Vector3){0.0f, 0.0f, 0.0f}, voxel_w);
+        vx_image_init(&img, o.image, o.image);
+        vx_view view = vx_raygrid_view(&rg, (Vector3){1.0f, 0.7f, 1.3f}, 45.0f);
+        ray_steps    = vx_raycast(&img, &rg, &view, (Vector3){230.0f, 230.0f, 230.0f}, &bin);
+        vx_error err = {0};
+        check_write(vx_image_write_ppm(&img, o.render, &err), &err);
+        vx_image_free(&img);
+        vx_raygrid_free(&rg);
+        t6 = vx_now();
+        VX_STATS_ADD(&ctx.stats, VX_STAGE_RENDER, (t6 - tr) * 1e3);
+    }
+    double      tq = t6, tm = t6;
+    int64_t     triangles = 0;
+    vx_quadlist quads     = {0};
+    if (o.mesh != NULL) {
+        vx_greedy_mesh(&quads, &bits, (Vector3){0.0f, 0.0f, 0.0f}, voxel_w, &bin);
+        tq        = vx_now();
+        vx_error err = {0};
+        check_write(vx_quads_write_ply(&quads, o.mesh, &triangles, &err), &err);
+        tm        = vx_now();
+        VX_STATS_ADD(&ctx.stats, VX_STAGE_EXPORT, (tm - t6) * 1e3);
+    }
+    double te = tm, tw = tm;
+    float  max_dist = 0.0f;
+    if (o.edt != NULL) {
+        vx_distfield field = {0};
+        vx_edt(&field, &bits, voxel_w, &bin);
+        te = vx_now();
+        for (int64_t c = 0; c < field.cells; c++) {
+            if (isfinite(field.dist[c]) && field.dist[c] > max_dist) max_dist = field.dist[c];
+        }
+        vx_error err = {0};
+        check_write(vx_distfield_write_raw(&field, o.edt, o.edt_step, NULL, &err), &err);
+        vx_distfield_free(&field);
+        tw = vx_now();
+        VX_STATS_ADD(&ctx.stats, VX_STAGE_EDT, (te - tm) * 1e3);
+    }
+    if (o.stats != NULL) write_stats(o.stats, &ctx.stats);
+
+    if (!o.quiet) {
+        fprintf(stderr,
+                "%s: %d вершин, сетка %d³ (%s), voxel_w %.6g, занято %d, потоков %d\n"
+                "  parse %.1f ms  normalize %.1f ms  mesh %.1f ms  bin %.1f ms  write %.1f ms\n",
+                o.input, ctx.vert_count, n, sparse ? "разреженная" : "плотная", voxel_w, occupied,
+                o.threads > 0 ? o.threads : vx_thread_count(),
+                (t1 - t0) * 1e3, (t2 - t1) * 1e3, (t3 - t2) * 1e3, (t4 - t3) * 1e3,
+                (t5 - tv) * 1e3);
+        if (o.surface) {
+            fprintf(stderr, "  %d треугольников: faces %.1f ms  surface %.1f ms\n",
+                    tris.count, (tf - t4) * 1e3, (ts - tf) * 1e3);
+        }
+        if (o.solid) {
+            fprintf(stderr, "  внутренних ячеек %lld: fill %.1f ms\n",
+                    (long long)interior, (tv - ts) * 1e3);
+        }
+        if (o.render != NULL) {
+            fprintf(stderr, "  кадр %d²: render %.1f ms, шагов DDA на луч %.1f\n",
+                    o.image, (t6 - tr) * 1e3, (double)ray_steps / ((double)o.image * o.image));
+        }
+        if (o.mesh != NULL) {
+            int64_t naive = 12 * vxbits_popcount(&bits);
+            fprintf(stderr, "  сетка %lld треугольников (кубами %lld, в %.1f раз больше; граней "
+                            "до слияния %lld): greedy %.1f ms  write %.1f ms\n",
+                    (long long)triangles, (long long)naive,
+                    triangles > 0 ? (double)naive / (double)triangles : 0.0,
+                    (long long)quads.faces, (tq - t6) * 1e3, (tm - tq) * 1e3);
+        }
+        if (labels_on) {
+            fprintf(stderr, "  компонент %d (связность %d), не меньше %d ячеек — %d, убрано ячеек "
+                            "%lld: label %.1f ms\n",
+                    labels.count, o.conn, o.min_comp, kept, (long long)dropped, (tk - tl) * 1e3);
+        }
+        if (o.edt != NULL) {
+            fprintf(stderr, "  расстояния %d³ (%s), наибольшее %.6g: edt %.1f ms  write %.1f ms\n",
+                    n, o.edt_step > 0.0f ? "uint16" : "float", max_dist, (te - tm) * 1e3,
+                    (tw - te) * 1e3);
+        }
+    }
+
+    vx_labels_free(&labels);
+    vx_quads_free(&quads);
+    vxbits_free(&bits);
+    free_trilist(&tris);
+    vx_ctx_free(&ctx);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,206 @@
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "vxbits.h"
+#include "vxsimd.h"
+
+/* Вершин на один вызов ядра квантования */
+#define VXBITS_BLOCK 512
+
+void vxbits_init(vxbits *b, int nx, int ny, int nz, bool with_counts)
+{
+    *b = (vxbits){0};
+    b->nx         = nx;
+    b->ny         = ny;
+    b->nz         = nz;
+    b->cells      = (int64_t)nx * ny * nz;
+    b->word_count = (b->cells + 63) / 64;
+    b->words      = calloc((size_t)(b->word_count ? b->word_count : 1), sizeof(uint64_t));
+    assert(b->words != NULL);
+    if (with_counts) {
+        b->counts = calloc((size_t)(b->cells / 2 + 1), 1);
+        assert(b->counts != NULL);
+    }
+}
+
+void vxbits_free(vxbits *b)
+{
+    free(b->words);
+    free(b->counts);
+    *b = (vxbits){0};
+}
+
+void vxbits_clear(vxbits *b)
+{
+    memset(b->words, 0, (size_t)b->word_count * sizeof(uint64_t));
+    if (b->counts) memset(b->counts, 0, (size_t)(b->cells / 2 + 1));
+}
+
+size_t vxbits_bytes(const vxbits *b)
+{
+    return (size_t)b->word_count * sizeof(uint64_t) +
+           (b->counts ? (size_t)(b->cells / 2 + 1) : 0);
+}
+
+/* =========================================================
+ *  Счётчики: два 4-битных значения в байте, младший полубайт —
+ *  чётная ячейка.
+ * ========================================================= */
+int vxbits_count(const vxbits *b, int64_t cell)
+{
+    if (b->counts == NULL) return 0;
+    return (b->counts[cell >> 1] >> ((cell & 1) * 4)) & 0xf;
+}
+
+static void count_store(vxbits *b, int64_t cell, int n)
+{
+    int      shift = (int)(cell & 1) * 4;
+    uint8_t *p     = &b->counts[cell >> 1];
+    *p = (uint8_t)((*p & ~(0xf << shift)) | (n << shift));
+}
+
+/* Отметка ячейки с увеличением счётчика на n (с насыщением) */
+static void mark(vxbits *b, int64_t cell, int n)
+{
+    vxbits_set(b, cell);
+    if (b->counts == NULL) return;
+    int c = vxbits_count(b, cell) + n;
+    count_store(b, cell, c < VXBITS_COUNT_MAX ? c : VXBITS_COUNT_MAX);
+}
+
+/* =========================================================
+ *  vxbits_fill
+ *  Индексы ячеек — те же, что у ind_finder (vx_quantize_keys).
+ * ========================================================= */
+static void fill_src(vxbits *b, const Vector3 *aos, const vx_soa *soa, int count,
+                     float voxel_w)
+{
+    vx_quant q = {.inv_w = 1.0f / voxel_w, .nx = b->nx, .ny = b->ny, .nz = b->nz};
+
+    int64_t cell[VXBITS_BLOCK];
+    for (int i = 0; i < count; i += VXBITS_BLOCK) {
+        int n = count - i < VXBITS_BLOCK ? count - i : VXBITS_BLOCK;
+        if (aos) vx_quantize_keys_aos(aos + i, n, &q, cell);
+        else     vx_quantize_keys(soa->x + i, soa->y + i, soa->z + i, n, &q, cell);
+        if (b->counts) {
+            for (int k = 0; k < n; k++) mark(b, cell[k], 1);
+        } else {
+            for (int k = 0; k < n; k++) vxbits_set(b, cell[k]);
+        }
+    }
+}
+
+void vxbits_fill(vxbits *b, const Vector3 *vert, int count, float voxel_w)
+{
+    fill_src(b, vert, NULL, count, voxel_w);
+}
+
+void vxbits_fill_soa(vxbits *b, const vx_soa *vert, float voxel_w)
+{
+    fill_src(b, NULL, vert, vert->count, voxel_w);
+}
+
+void vxbits_from_mesh(vxbits *b, const vxlist *mesh, int min_count)
+{
+    assert(!mesh->sparse && !mesh->morton && b->cells == mesh->count);
+
+    const int *cells;
+    int        n = vx_cells_at_least(mesh, min_count, &cells);
+    for (int k = 0; k < n; k++) mark(b, cells[k], mesh->items[cells[k]].count);
+}
+
+/* =========================================================
+ *  Статистика
+ * ========================================================= */
+int64_t vxbits_popcount(const vxbits *b)
+{
+    int64_t n = 0;
+    for (int64_t w = 0; w < b->word_count; w++) n += __builtin_popcountll(b->words[w]);
+    return n;
+}
+
+void vxbits_popcount_z(const vxbits *b, int64_t *per_z)
+{
+    int64_t slice = (int64_t)b->nx * b->ny;
+    for (int z = 0; z < b->nz; z++) {
+        /* Слой [lo, hi) может начинаться и кончаться посреди слова */
+        int64_t lo = z * slice, hi = lo + slice, n = 0;
+        for (int64_t w = lo >> 6; w <= (hi - 1) >> 6; w++) {
+            uint64_t bits = b->words[w];
+            if (w == lo >> 6)       bits &= ~(uint64_t)0 << (lo & 63);
+            if (w == (hi - 1) >> 6) bits &= ~(uint64_t)0 >> (63 - ((hi - 1) & 63));
+            n += __builtin_popcountll(bits);
+        }
+        per_z[z] = n;
+    }
+}
+
+int64_t vxbits_popcount_and(const vxbits *a, const vxbits *b)
+{
+    assert(a->cells == b->cells);
+    int64_t n = 0;
+    for (int64_t w = 0; w < a->word_count; w++) n += __builtin_popcountll(a->words[w] & b->words[w]);
+    return n;
+}
+
+/* =========================================================
+ *  Объединение и пересечение: по словам; счётчики — только
+ *  для затронутых ячеек. Сетка без счётчиков считается
+ *  сеткой со счётчиком 1 в каждой занятой ячейке.
+ * ========================================================= */
+static int src_count(const vxbits *b, int64_t cell)
+{
+    return b->counts ? vxbits_count(b, cell) : 1;
+}
+
+void vxbits_union(vxbits *dst, const vxbits *src)
+{
+    assert(dst->nx == src->nx && dst->ny == src->ny && dst->nz == src->nz);
+
+    if (dst->counts == NULL) {
+        for (int64_t w = 0; w < dst->word_count; w++) dst->words[w] |= src->words[w];
+        return;
+    }
+    for (int64_t w = 0; w < dst->word_count; w++) {
+        for (uint64_t bits = src->words[w]; bits; bits &= bits - 1) {
+            int64_t cell = w * 64 + __builtin_ctzll(bits);
+            mark(dst, cell, src_count(src, cell));
+        }
+    }
+}
+
+void vxbits_intersect(vxbits *dst, const vxbits *src)
+{
+    assert(dst->nx == src->nx && dst->ny == src->ny && dst->nz == src->nz);
+
+    for (int64_t w = 0; w < dst->word_count; w++) {
+        uint64_t old = dst->words[w];
+        dst->words[w] = old & src->words[w];
+        if (dst->counts == NULL) continue;
+        for (uint64_t bits = old; bits; bits &= bits - 1) {
+            int     bit  = __builtin_ctzll(bits);
+            int64_t cell = w * 64 + bit;
+            if ((dst->words[w] >> bit) & 1u) {
+                int s = src_count(src, cell);
+                if (s < vxbits_count(dst, cell)) count_store(dst, cell, s);
+            } else {
+                count_store(dst, cell, 0);
+            }
+        }
+    }
+}
+
+/* =========================================================
+ *  vxbits_next
+ * ========================================================= */
+int64_t vxbits_next(const vxbits *b, int64_t from)
+{
+    if (from >= b->cells) return -1;
+    int64_t  w    = from >> 6;
+    uint64_t bits = b->words[w] & (~(uint64_t)0 << (from & 63));
+    while (bits == 0) {
+        if (++w >= b->word_count) return -1;
+        bits = b->words[w];
+    }
+    return w * 64 + __builtin_ctzll(bits);
+}
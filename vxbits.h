@@ -0,0 +1,179 @@
+#ifndef VXBITS_H
+#define VXBITS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "voxel.h"
+
+/* =========================================================
+ *  Битовая сетка занятости: 1 бит на ячейку
+ *
+ *  Для задач, где нужна только занятость ячейки, а не её
+ *  вершины. Бит ячейки — линейный индекс zi·(nx·ny) + yi·nx + xi,
+ *  тот же, что выдаёт квантование ind_finder, поэтому заполнение
+ *  не требует перевода координат. Биты лежат в 64-битных словах:
+ *  сетка 1024³ занимает 128 МиБ.
+ * ========================================================= */
+
+/** Предел счётчика ячейки (4 бита, насыщение). */
+#define VXBITS_COUNT_MAX 15
+
+/**
+ * @brief Битовая сетка занятости nx × ny × nz.
+ */
+typedef struct vxbits {
+    uint64_t *words;      /**< Биты занятости, ячейка c — бит c % 64 слова c / 64. */
+    uint8_t  *counts;     /**< Счётчики по 4 бита на ячейку или NULL.              */
+    int64_t   cells;      /**< nx · ny · nz.                                      */
+    int64_t   word_count; /**< Слов в words: ceil(cells / 64).                    */
+    int       nx;         /**< Ячеек вдоль X.                                     */
+    int       ny;         /**< Ячеек вдоль Y.                                     */
+    int       nz;         /**< Ячеек вдоль Z.                                     */
+} vxbits;
+
+/**
+ * @brief Создаёт пустую сетку.
+ *
+ * @param with_counts Хранить ли насыщающийся счётчик вершин (4 бита на ячейку).
+ */
+void vxbits_init(vxbits *b, int nx, int ny, int nz, bool with_counts);
+
+/**
+ * @brief Освобождает память сетки и обнуляет её поля.
+ */
+void vxbits_free(vxbits *b);
+
+/**
+ * @brief Сбрасывает все биты и счётчики.
+ */
+void vxbits_clear(vxbits *b);
+
+/**
+ * @brief Байт памяти, занятых сеткой.
+ */
+size_t vxbits_bytes(const vxbits *b);
+
+/**
+ * @brief Линейный индекс ячейки (xi, yi, zi).
+ */
+static inline int64_t vxbits_cell(const vxbits *b, int xi, int yi, int zi)
+{
+    return ((int64_t)zi * b->ny + yi) * b->nx + xi;
+}
+
+/**
+ * @brief Занята ли ячейка @p cell.
+ */
+static inline bool vxbits_test(const vxbits *b, int64_t cell)
+{
+    return (b->words[cell >> 6] >> (cell & 63)) & 1u;
+}
+
+/**
+ * @brief Отмечает ячейку @p cell занятой (счётчик не меняется).
+ */
+static inline void vxbits_set(vxbits *b, int64_t cell)
+{
+    b->words[cell >> 6] |= (uint64_t)1 << (cell & 63);
+}
+
+/**
+ * @brief Отмечает ячейку @p cell пустой (счётчик не меняется).
+ */
+static inline void vxbits_reset(vxbits *b, int64_t cell)
+{
+    b->words[cell >> 6] &= ~((uint64_t)1 << (cell & 63));
+}
+
+/**
+ * @brief @p len ≤ 64 бит сетки начиная с бита @p pos, младший — бит pos.
+ *
+ * Отрезок может пересекать границу слова; биты за ним равны нулю.
+ * Так строки и их куски берутся из сетки целыми словами.
+ */
+static inline uint64_t vxbits_load(const vxbits *b, int64_t pos, int len)
+{
+    int64_t  w  = pos >> 6;
+    int      sh = (int)(pos & 63);
+    uint64_t v  = b->words[w] >> sh;
+    if (sh != 0 && sh + len > 64) v |= b->words[w + 1] << (64 - sh);
+    return len < 64 ? v & (((uint64_t)1 << len) - 1) : v;
+}
+
+/**
+ * @brief Счётчик вершин ячейки (0, если сетка без счётчиков).
+ */
+int vxbits_count(const vxbits *b, int64_t cell);
+
+/**
+ * @brief Отмечает ячейки, в которые попадают вершины.
+ *
+ * Квантование то же, что в ind_finder (vx_quantize, ребро voxel_w от
+ * нуля нормализованных координат), поэтому занятые биты совпадают с
+ * непустыми вокселями сетки того же размера. Биты добавляются к уже
+ * установленным; счётчики (если есть) растут до VXBITS_COUNT_MAX.
+ *
+ * @param vert    Нормализованные вершины.
+ * @param count   Их количество.
+ * @param voxel_w Длина ребра ячейки.
+ */
+void vxbits_fill(vxbits *b, const Vector3 *vert, int count, float voxel_w);
+
+/**
+ * @brief То же для SoA-вершин.
+ */
+void vxbits_fill_soa(vxbits *b, const vx_soa *vert, float voxel_w);
+
+/**
+ * @brief Отмечает воксели плотной сетки с не меньше чем @p min_count вершинами.
+ *
+ * @param b    Сетка размеров mesh->nx × ny × nz.
+ * @param mesh Плотная сетка (не Мортона) после ind_finder.
+ */
+void vxbits_from_mesh(vxbits *b, const vxlist *mesh, int min_count);
+
+/**
+ * @brief Число занятых ячеек (popcount по словам).
+ */
+int64_t vxbits_popcount(const vxbits *b);
+
+/**
+ * @brief Занятые ячейки по слоям Z.
+ *
+ * @param per_z [out] nz значений.
+ */
+void vxbits_popcount_z(const vxbits *b, int64_t *per_z);
+
+/**
+ * @brief Число ячеек, занятых в обеих сетках, без построения пересечения.
+ */
+int64_t vxbits_popcount_and(const vxbits *a, const vxbits *b);
+
+/**
+ * @brief dst |= src. Счётчики складываются с насыщением.
+ *
+ * Размеры сеток должны совпадать.
+ */
+void vxbits_union(vxbits *dst, const vxbits *src);
+
+/**
+ * @brief dst &= src. Счётчик ячейки — меньший из двух, вне пересечения 0.
+ *
+ * Размеры сеток должны совпадать.
+ */
+void vxbits_intersect(vxbits *dst, const vxbits *src);
+
+/**
+ * @brief Первая занятая ячейка с индексом не меньше @p from.
+ *
+ * Пустые слова пропускаются целиком, внутри слова — поиск младшего
+ * бита, поэтому обход всех занятых ячеек
+ *     for (int64_t c = vxbits_next(b, 0); c >= 0; c = vxbits_next(b, c + 1))
+ * стоит O(word_count + занятых).
+ *
+ * @return Индекс ячейки или -1, если дальше занятых нет.
+ */
+int64_t vxbits_next(const vxbits *b, int64_t from);
+
+#endif /* VXBITS_H */
@@ -0,0 +1,98 @@
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include "vxcache.h"
+
+void vxcache_init(vxcache *c, const vx_ctx *model, size_t budget)
+{
+    *c = (vxcache){0};
+    c->budget = budget ? budget : VXCACHE_DEFAULT_BUDGET;
+    vx_ctx_share(&c->model, model);
+}
+
+void vxcache_free(vxcache *c)
+{
+    for (int i = 0; i < c->count; i++) freeContainer(&c->items[i].mesh);
+    free(c->items);
+    c->items    = NULL;
+    c->count    = 0;
+    c->capacity = 0;
+    c->bytes    = 0;
+}
+
+/* =========================================================
+ *  vxcache_evict
+ *  Вытесняет самые давние записи, пока память выше бюджета.
+ *  Запись keep (только что запрошенная) не трогается.
+ * ========================================================= */
+static void vxcache_evict(vxcache *c, int keep_voxel_num)
+{
+    while (c->bytes > c->budget) {
+        int victim = -1;
+        for (int i = 0; i < c->count; i++) {
+            if (c->items[i].voxel_num == keep_voxel_num) continue;
+            if (victim < 0 || c->items[i].last_used < c->items[victim].last_used) victim = i;
+        }
+        if (victim < 0) return;
+
+        c->bytes -= c->items[victim].bytes;
+        freeContainer(&c->items[victim].mesh);
+        c->items[victim] = c->items[--c->count];
+    }
+}
+
+/* Запись по ключу или -1 */
+static int vxcache_index(const vxcache *c, int voxel_num)
+{
+    for (int i = 0; i < c->count; i++) {
+        if (c->items[i].voxel_num == voxel_num) return i;
+    }
+    return -1;
+}
+
+/* Отметка обращения и вытеснение; запись могла переехать — ищется заново */
+static const vxlist *vxcache_touch(vxcache *c, int voxel_num, float *voxel_w)
+{
+    c->items[vxcache_index(c, voxel_num)].last_used = ++c->tick;
+    vxcache_evict(c, voxel_num);
+
+    vxcache_entry *e = &c->items[vxcache_index(c, voxel_num)];
+    if (voxel_w) *voxel_w = e->voxel_w;
+    return &e->mesh;
+}
+
+const vxlist *vxcache_lookup(vxcache *c, int voxel_num, float *voxel_w)
+{
+    if (vxcache_index(c, voxel_num) < 0) return NULL;
+    return vxcache_touch(c, voxel_num, voxel_w);
+}
+
+const vxlist *vxcache_put(vxcache *c, int voxel_num, vxlist *mesh, float voxel_w)
+{
+    if (vxcache_index(c, voxel_num) >= 0) {
+        freeContainer(mesh);
+    } else {
+        vxcache_entry fresh = {.voxel_num = voxel_num, .mesh = *mesh, .voxel_w = voxel_w};
+        fresh.bytes = vxlist_bytes(&fresh.mesh);
+        da_append(c, fresh);
+        c->bytes += fresh.bytes;
+        *mesh = (vxlist){0};
+    }
+    return vxcache_touch(c, voxel_num, NULL);
+}
+
+const vxlist *vxcache_get(vxcache *c, int voxel_num, float *voxel_w)
+{
+    if (vxcache_index(c, voxel_num) < 0) {
+        vx_ctx_mesh(&c->model, (int)lround(cbrt((double)voxel_num)), VX_GRID_DENSE);
+        vx_ctx_bin(&c->model, NULL);
+        vxcache_put(c, voxel_num, &c->model.mesh, c->model.voxel_w);
+    }
+    return vxcache_touch(c, voxel_num, voxel_w);
+}
+
+void vxcache_prebuild(vxcache *c, const int *voxel_nums, int n)
+{
+    for (int i = 0; i < n; i++) vxcache_get(c, voxel_nums[i], NULL);
+}
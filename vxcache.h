@@ -0,0 +1,98 @@
+#ifndef VXCACHE_H
+#define VXCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "voxel.h"
+
+/* =========================================================
+ *  Кэш построенных сеток по разрешению
+ * ========================================================= */
+
+/** Бюджет памяти кэша по умолчанию, байт. */
+#define VXCACHE_DEFAULT_BUDGET ((size_t)256 * 1024 * 1024)
+
+/**
+ * @brief Построенная сетка одного разрешения.
+ */
+typedef struct vxcache_entry {
+    int      voxel_num; /**< Ключ: общее количество вокселей.            */
+    vxlist   mesh;      /**< Сетка с разложенными вершинами.             */
+    float    voxel_w;   /**< Длина ребра вокселя.                        */
+    size_t   bytes;     /**< Занимаемая память (vxlist_bytes).           */
+    uint64_t last_used; /**< Отметка последнего обращения (для LRU).     */
+} vxcache_entry;
+
+/**
+ * @brief Кэш сеток над одной нормализованной моделью.
+ *
+ * Сетки строятся по запросу (vx_ctx_mesh + vx_ctx_bin) и хранятся,
+ * пока суммарная память не превышает budget; при превышении
+ * вытесняются давно не использованные. Только что запрошенная
+ * сетка не вытесняется, даже если одна превышает бюджет.
+ */
+typedef struct vxcache {
+    vxcache_entry *items;      /**< Записи кэша.                          */
+    int            count;      /**< Количество записей.                   */
+    int            capacity;   /**< Ёмкость массива записей.              */
+    size_t         bytes;      /**< Суммарная память записей.             */
+    size_t         budget;     /**< Бюджет памяти, байт.                  */
+    uint64_t       tick;       /**< Счётчик обращений.                    */
+    vx_ctx         model;      /**< Модель (vx_ctx_share, вершины чужие);
+                                    model.stats копит замеры сборок.   */
+} vxcache;
+
+/**
+ * @brief Создаёт пустой кэш над нормализованной моделью.
+ *
+ * @param c      Кэш.
+ * @param model  Модель после vx_ctx_normalize; должна жить дольше кэша.
+ * @param budget Бюджет памяти в байтах (0 — VXCACHE_DEFAULT_BUDGET).
+ */
+void vxcache_init(vxcache *c, const vx_ctx *model, size_t budget);
+
+/**
+ * @brief Освобождает все сетки кэша.
+ */
+void vxcache_free(vxcache *c);
+
+/**
+ * @brief Возвращает сетку разрешения @p voxel_num, строя её при промахе.
+ *
+ * Повторный запрос уже построенного разрешения ничего не строит.
+ * Указатель действителен до следующего вызова vxcache_get /
+ * vxcache_lookup / vxcache_put / vxcache_prebuild / vxcache_free.
+ *
+ * @param voxel_num Общее количество вокселей.
+ * @param voxel_w   [out] Длина ребра вокселя (может быть NULL).
+ */
+const vxlist *vxcache_get(vxcache *c, int voxel_num, float *voxel_w);
+
+/**
+ * @brief Возвращает сетку разрешения @p voxel_num, если она уже в кэше.
+ *
+ * Ничего не строит; при попадании отмечает обращение для LRU.
+ *
+ * @return Сетка или NULL при промахе (указатель — как у vxcache_get).
+ */
+const vxlist *vxcache_lookup(vxcache *c, int voxel_num, float *voxel_w);
+
+/**
+ * @brief Добавляет в кэш сетку, построенную снаружи (например, фоновым потоком).
+ *
+ * Кэш забирает буферы @p mesh себе, *mesh обнуляется. Если такое
+ * разрешение уже есть, переданная сетка освобождается.
+ *
+ * @return Сетка в кэше (указатель — как у vxcache_get).
+ */
+const vxlist *vxcache_put(vxcache *c, int voxel_num, vxlist *mesh, float voxel_w);
+
+/**
+ * @brief Строит заранее сетки всех перечисленных разрешений.
+ *
+ * Разрешения, не помещающиеся в бюджет вместе с остальными,
+ * будут вытеснены по LRU как обычно.
+ */
+void vxcache_prebuild(vxcache *c, const int *voxel_nums, int n);
+
+#endif /* VXCACHE_H */
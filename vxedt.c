@@ -0,0 +1,216 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include "vxedt.h"
+#include "vxsys.h"
+
+typedef struct edt_job {
+    const vxbits *b;
+    float        *d;       /**< Поле: квадраты расстояний в ячейках до последнего прохода. */
+    int           axis;    /**< Ось прохода по столбцам: 1 — Y, 2 — Z.                    */
+    int64_t       units;   /**< Строк (проход X) или пачек столбцов (Y, Z).               */
+    float         voxel_w; /**< Множитель корня на последнем проходе.                     */
+} edt_job;
+
+/* =========================================================
+ *  Проход X
+ *  Два обхода строки: расстояние до последней занятой ячейки
+ *  слева, затем минимум с ближайшей справа и квадрат.
+ * ========================================================= */
+static void x_row(const vxbits *b, int64_t pos, float *d)
+{
+    int nx   = b->nx;
+    int last = -1;
+    for (int x0 = 0; x0 < nx; x0 += 64) {
+        int      len  = nx - x0 < 64 ? nx - x0 : 64;
+        uint64_t bits = vxbits_load(b, pos + x0, len);
+        if (bits == 0 && last < 0) {
+            for (int i = 0; i < len; i++) d[x0 + i] = INFINITY;
+            continue;
+        }
+        for (int i = 0; i < len; i++) {
+            if ((bits >> i) & 1) last = x0 + i;
+            d[x0 + i] = last < 0 ? INFINITY : (float)(x0 + i - last);
+        }
+    }
+    if (last < 0) return;
+
+    last = -1;
+    for (int x = nx - 1; x >= 0; x--) {
+        if (d[x] == 0.0f) last = x;
+        else if (last >= 0 && (float)(last - x) < d[x]) d[x] = (float)(last - x);
+        d[x] *= d[x];
+    }
+}
+
+static void x_task(void *ctx, int task, int task_count)
+{
+    edt_job *job = ctx;
+    int64_t  lo  = job->units * task / task_count, hi = job->units * (task + 1) / task_count;
+    int      nx  = job->b->nx;
+    for (int64_t row = lo; row < hi; row++) x_row(job->b, row * nx, job->d + row * nx);
+}
+
+/* =========================================================
+ *  Проходы Y и Z
+ *  Нижняя огибающая парабол f(p) + (q − p)² (Felzenszwalb–
+ *  Huttenlocher): v — вершины парабол огибающей, h — их
+ *  f(v) + v², z — границы их участков. Ячейки без занятых по предыдущим осям (f = ∞)
+ *  парабол не дают.
+ * ========================================================= */
+static void envelope(const float *f, float *out, int n, int *v, double *h, double *z)
+{
+    int k = -1;
+    for (int q = 0; q < n; q++) {
+        if (isinf(f[q])) continue;
+        double hq = f[q] + (double)q * q;
+        double s  = -INFINITY;
+        while (k >= 0) {
+            s = (hq - h[k]) / (2.0 * (q - v[k]));
+            if (s > z[k]) break;
+            k--;
+        }
+        k++;
+        v[k] = q;
+        h[k] = hq;
+        z[k] = k == 0 ? -INFINITY : s;
+    }
+    if (k < 0) {
+        for (int q = 0; q < n; q++) out[q] = INFINITY;
+        return;
+    }
+    z[k + 1] = INFINITY;
+
+    int j = 0;
+    for (int q = 0; q < n; q++) {
+        while (z[j + 1] < q) j++;
+        double dq = q - v[j];
+        out[q] = (float)(dq * dq + f[v[j]]);
+    }
+}
+
+/* Пачка из VX_EDT_BATCH соседних по X столбцов собирается и
+ * разбирается построчно (по VX_EDT_BATCH подряд идущих float), чтобы
+ * не ходить по памяти с шагом строки или слоя на каждую ячейку */
+static void column_task(void *ctx, int task, int task_count)
+{
+    edt_job      *job  = ctx;
+    const vxbits *b    = job->b;
+    int           nx   = b->nx;
+    int           n    = job->axis == 1 ? b->ny : b->nz;
+    int64_t       step = job->axis == 1 ? nx : (int64_t)nx * b->ny;
+    int           bpr  = (nx + VX_EDT_BATCH - 1) / VX_EDT_BATCH;
+    bool          last = job->axis == 2;
+
+    float  *col = malloc((size_t)VX_EDT_BATCH * n * sizeof(float));
+    float  *out = malloc((size_t)VX_EDT_BATCH * n * sizeof(float));
+    int    *v   = malloc((size_t)n * sizeof(int));
+    double *h   = malloc((size_t)n * sizeof(double));
+    double *z   = malloc((size_t)(n + 1) * sizeof(double));
+    assert(col != NULL && out != NULL && v != NULL && h != NULL && z != NULL);
+
+    int64_t lo = job->units * task / task_count, hi = job->units * (task + 1) / task_count;
+    for (int64_t unit = lo; unit < hi; unit++) {
+        int     outer = (int)(unit / bpr);
+        int     x0    = (int)(unit % bpr) * VX_EDT_BATCH;
+        int     cnt   = nx - x0 < VX_EDT_BATCH ? nx - x0 : VX_EDT_BATCH;
+        int64_t base  = job->axis == 1 ? vxbits_cell(b, x0, 0, outer) : vxbits_cell(b, x0, outer, 0);
+        float  *d     = job->d + base;
+
+        for (int i = 0; i < n; i++) {
+            for (int c = 0; c < cnt; c++) col[c * n + i] = d[i * step + c];
+        }
+        for (int c = 0; c < cnt; c++) envelope(col + c * n, out + c * n, n, v, h, z);
+        for (int i = 0; i < n; i++) {
+            float *row = d + i * step;
+            if (last) {
+                for (int c = 0; c < cnt; c++) row[c] = sqrtf(out[c * n + i]) * job->voxel_w;
+            } else {
+                for (int c = 0; c < cnt; c++) row[c] = out[c * n + i];
+            }
+        }
+    }
+    free(col);
+    free(out);
+    free(v);
+    free(h);
+    free(z);
+}
+
+static void run_pass(edt_job *job, vx_task_fn fn, int threads)
+{
+    int tasks = threads < job->units ? threads : (int)job->units;
+    if (tasks > 1) vx_parallel_run(tasks, fn, job);
+    else           fn(job, 0, 1);
+}
+
+void vx_edt(vx_distfield *f, const vxbits *b, float voxel_w, const vx_bin_opts *opts)
+{
+    vx_distfield_free(f);
+    f->cells   = b->cells;
+    f->nx      = b->nx;
+    f->ny      = b->ny;
+    f->nz      = b->nz;
+    f->voxel_w = voxel_w;
+    f->dist    = malloc((size_t)(b->cells > 0 ? b->cells : 1) * sizeof(float));
+    assert(f->dist != NULL);
+    if (b->cells == 0) return;
+
+    int     threads = opts != NULL && opts->threads > 0 ? opts->threads : vx_thread_count();
+    int64_t batches = (b->nx + VX_EDT_BATCH - 1) / VX_EDT_BATCH;
+    edt_job job     = {.b = b, .d = f->dist, .voxel_w = voxel_w};
+
+    job.units = (int64_t)b->ny * b->nz;
+    run_pass(&job, x_task, threads);
+
+    job.axis  = 1;
+    job.units = batches * b->nz;
+    run_pass(&job, column_task, threads);
+
+    job.axis  = 2;
+    job.units = batches * b->ny;
+    run_pass(&job, column_task, threads);
+}
+
+void vx_distfield_free(vx_distfield *f)
+{
+    free(f->dist);
+    *f = (vx_distfield){0};
+}
+
+void vx_distfield_quantize(const vx_distfield *f, uint16_t *out, float step)
+{
+    float inv = 1.0f / step;
+    for (int64_t c = 0; c < f->cells; c++) {
+        float q = f->dist[c] * inv + 0.5f;
+        out[c]  = q >= 65535.0f ? 65535 : (uint16_t)q;
+    }
+}
+
+vx_status vx_distfield_write_raw(const vx_distfield *f, const char *filename, float step,
+                                 int64_t *bytes, vx_error *err)
+{
+    if (bytes != NULL) *bytes = 0;
+    FILE *out = fopen(filename, "wb");
+    if (out == NULL) return vx_fail(err, VX_ERR_OPEN, "Не удалось создать %s", filename);
+
+    size_t elem = step > 0.0f ? sizeof(uint16_t) : sizeof(float);
+    size_t done;
+    if (step > 0.0f) {
+        uint16_t *q = malloc((size_t)(f->cells > 0 ? f->cells : 1) * sizeof(uint16_t));
+        assert(q != NULL);
+        vx_distfield_quantize(f, q, step);
+        done = fwrite(q, sizeof(uint16_t), (size_t)f->cells, out);
+        free(q);
+    } else {
+        done = fwrite(f->dist, sizeof(float), (size_t)f->cells, out);
+    }
+
+    if (fclose(out) != 0 || done != (size_t)f->cells) {
+        return vx_fail(err, VX_ERR_WRITE, "Ошибка записи %s", filename);
+    }
+    if (bytes != NULL) *bytes = f->cells * (int64_t)elem;
+    return VX_OK;
+}
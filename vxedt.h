@@ -0,0 +1,78 @@
+#ifndef VXEDT_H
+#define VXEDT_H
+
+#include <stdint.h>
+#include "voxel.h"
+#include "vxbits.h"
+
+/* =========================================================
+ *  Евклидово поле расстояний по сетке занятости
+ *
+ *  Для каждой ячейки — расстояние от её центра до центра
+ *  ближайшей занятой ячейки (для занятых — 0). Точное
+ *  преобразование раскладывается по осям (Felzenszwalb–
+ *  Huttenlocher, Meijster): проход вдоль X даёт расстояние до
+ *  ближайшей занятой ячейки строки, проходы вдоль Y и Z —
+ *  нижнюю огибающую парабол d²(q) = f(p) + (q − p)² по столбцу.
+ *  Каждый проход — O(ячеек), строки и столбцы прохода
+ *  независимы и делятся между потоками пула.
+ * ========================================================= */
+
+/** Столбцов Y и Z, которые проход собирает и разбирает за раз. */
+#define VX_EDT_BATCH 32
+
+/**
+ * @brief Поле расстояний, ячейка c — dist[c] (индекс как у vxbits_cell).
+ */
+typedef struct vx_distfield {
+    float  *dist;    /**< Расстояния в единицах сцены; INFINITY, если занятых нет. */
+    int64_t cells;   /**< nx · ny · nz.          */
+    int     nx;      /**< Ячеек вдоль X.         */
+    int     ny;      /**< Ячеек вдоль Y.         */
+    int     nz;      /**< Ячеек вдоль Z.         */
+    float   voxel_w; /**< Длина ребра ячейки.    */
+} vx_distfield;
+
+/**
+ * @brief Строит поле расстояний до занятых ячеек @p b.
+ *
+ * Квадраты расстояний считаются в ячейках во float и точны, пока
+ * nx² + ny² + nz² < 2^24 (сетки до ~2300³); в конце берётся корень
+ * и умножается на @p voxel_w. Память — одно поле float на ячейку
+ * (на 512³ — 512 МБ) и по несколько столбцов на поток.
+ *
+ * @param f       [out] Поле (прежнее содержимое освобождается).
+ * @param voxel_w Длина ребра ячейки (1 — расстояния в ячейках).
+ * @param opts    Потоки (opts->threads) или NULL — все ядра.
+ */
+void vx_edt(vx_distfield *f, const vxbits *b, float voxel_w, const vx_bin_opts *opts);
+
+/**
+ * @brief Освобождает поле и обнуляет его поля.
+ */
+void vx_distfield_free(vx_distfield *f);
+
+/**
+ * @brief Квантует поле в uint16 с шагом @p step единиц сцены.
+ *
+ * out[c] = round(dist[c] / step), насыщаясь на 65535 (туда же
+ * попадает INFINITY).
+ *
+ * @param out Массив из f->cells значений.
+ */
+void vx_distfield_quantize(const vx_distfield *f, uint16_t *out, float step);
+
+/**
+ * @brief Записывает поле в файл без заголовка, порядок ячеек — dist.
+ *
+ * @p step > 0 — uint16 (vx_distfield_quantize), иначе float; порядок
+ * байт машины.
+ *
+ * @param bytes [out] Размер записанного файла, байт, или NULL.
+ * @param err   [out] Текст ошибки или NULL.
+ * @return VX_OK, VX_ERR_OPEN (файл не создан) или VX_ERR_WRITE.
+ */
+vx_status vx_distfield_write_raw(const vx_distfield *f, const char *filename, float step,
+                                 int64_t *bytes, vx_error *err);
+
+#endif /* VXEDT_H */
@@ -0,0 +1,267 @@
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "vxfill.h"
+#include "vxsys.h"
+
+/* =========================================================
+ *  Рабочие массивы: строка сетки (nx ячеек) дополнена до
+ *  целых слов, поэтому строки и слои выровнены и заливка
+ *  вдоль Y и Z — пословные операции. open — пустые ячейки,
+ *  ext — пустые ячейки, до которых дошла заливка снаружи
+ *  (ext ⊆ open). Биты за концом строки в open нулевые.
+ * ========================================================= */
+typedef struct {
+    vxbits            *b;
+    uint64_t          *open;
+    uint64_t          *ext;
+    uint8_t           *dirty;       /* слой вырос вдоль Z и ждёт прохода в плоскости XY */
+    int                rw;          /* слов в строке                                     */
+    int64_t            slice_words; /* rw · ny                                           */
+    uint64_t           last_mask;   /* ячейки строки в её последнем слове                */
+    const vx_bin_opts *opts;
+    int64_t            done;        /* пройдено слоёв (для хода работы)                  */
+    int64_t            added;
+    int                z_grew;
+} fill_job;
+
+static bool cancelled(const vx_bin_opts *o)
+{
+    return o->cancel && __atomic_load_n(o->cancel, __ATOMIC_RELAXED);
+}
+
+static void run(int tasks, vx_task_fn fn, fill_job *job)
+{
+    if (tasks > 1) vx_parallel_run(tasks, fn, job);
+    else           fn(job, 0, 1);
+}
+
+/* Добавляет биты v (len ≤ 64) с бита pos; слово на стыке строк могут
+ * делить соседние слои, поэтому — атомарно */
+static void or_bits(vxbits *b, int64_t pos, int len, uint64_t v)
+{
+    if (v == 0) return;
+    int64_t w  = pos >> 6;
+    int     sh = (int)(pos & 63);
+    __atomic_fetch_or(&b->words[w], v << sh, __ATOMIC_RELAXED);
+    if (sh != 0 && sh + len > 64) __atomic_fetch_or(&b->words[w + 1], v >> (64 - sh), __ATOMIC_RELAXED);
+}
+
+/* =========================================================
+ *  Заливка внутри 64-битного слова
+ *  К старшим битам — сложением: перенос бежит от затравки по
+ *  непрерывному отрезку единиц open и гасит его. К младшим —
+ *  сдвигами с удвоением шага (Когге–Стоун), 6 шагов на слово.
+ * ========================================================= */
+static uint64_t spread_up(uint64_t seed, uint64_t open)
+{
+    return seed | (((open + seed) ^ open) & open);
+}
+
+static uint64_t spread_down(uint64_t seed, uint64_t open)
+{
+    seed |= open & (seed >> 1);  open &= open >> 1;
+    seed |= open & (seed >> 2);  open &= open >> 2;
+    seed |= open & (seed >> 4);  open &= open >> 4;
+    seed |= open & (seed >> 8);  open &= open >> 8;
+    seed |= open & (seed >> 16); open &= open >> 16;
+    seed |= open & (seed >> 32);
+    return seed;
+}
+
+/* Строка e: затравка из соседней строки from (или NULL), затем
+ * заливка вдоль X в обе стороны. Возвращает true, если строка выросла. */
+static bool fill_row(uint64_t *e, const uint64_t *open, const uint64_t *from, int rw)
+{
+    bool     grew  = false;
+    uint64_t carry = 0;
+    for (int i = 0; i < rw; i++) {
+        uint64_t s = (e[i] | carry | (from ? from[i] : 0)) & open[i];
+        s     = spread_up(s, open[i]);
+        carry = s >> 63;
+        grew |= s != e[i];
+        e[i]  = s;
+    }
+    carry = 0;
+    for (int i = rw - 1; i >= 0; i--) {
+        uint64_t s = (e[i] | carry << 63) & open[i];
+        s     = spread_down(s, open[i]);
+        carry = s & 1;
+        grew |= s != e[i];
+        e[i]  = s;
+    }
+    return grew;
+}
+
+/* Слой z: проходы по строкам вверх и вниз по Y до неподвижной точки */
+static void fill_slice(fill_job *job, int z)
+{
+    int       rw   = job->rw, ny = job->b->ny;
+    uint64_t *e    = job->ext + z * job->slice_words;
+    uint64_t *open = job->open + z * job->slice_words;
+    bool      grew = true;
+    while (grew) {
+        grew = false;
+        for (int y = 0; y < ny; y++) {
+            grew |= fill_row(e + y * rw, open + y * rw, y > 0 ? e + (y - 1) * rw : NULL, rw);
+        }
+        for (int y = ny - 2; y >= 0; y--) {
+            grew |= fill_row(e + y * rw, open + y * rw, e + (y + 1) * rw, rw);
+        }
+    }
+}
+
+/* =========================================================
+ *  Задачи пула
+ * ========================================================= */
+
+/* open и затравка: пустые ячейки на границе сетки */
+static void load_task(void *ctx, int task, int task_count)
+{
+    fill_job     *job = ctx;
+    const vxbits *b   = job->b;
+    int           rw  = job->rw;
+    for (int z = task; z < b->nz; z += task_count) {
+        for (int y = 0; y < b->ny; y++) {
+            int64_t   row  = (int64_t)z * job->slice_words + (int64_t)y * rw;
+            int64_t   pos  = vxbits_cell(b, 0, y, z);
+            bool      edge = y == 0 || y == b->ny - 1 || z == 0 || z == b->nz - 1;
+            uint64_t *open = job->open + row, *e = job->ext + row;
+            for (int i = 0; i < rw; i++) {
+                int len = i < rw - 1 ? 64 : b->nx - i * 64;
+                open[i] = ~vxbits_load(b, pos + i * 64, len) & (i < rw - 1 ? ~(uint64_t)0 : job->last_mask);
+                e[i]    = edge ? open[i] : 0;
+            }
+            e[0]      |= open[0] & 1;
+            e[rw - 1] |= open[rw - 1] & (uint64_t)1 << ((b->nx - 1) & 63);
+        }
+    }
+}
+
+/* Заливка в плоскости XY по слоям, затронутым с прошлого прохода.
+ * Ход работы считается по первому проходу — последующие короткие. */
+static void xy_task(void *ctx, int task, int task_count)
+{
+    fill_job *job = ctx;
+    int       nz  = job->b->nz;
+    for (int z = task; z < nz; z += task_count) {
+        if (cancelled(job->opts)) return;
+        if (!job->dirty[z]) continue;
+        job->dirty[z] = 0;
+        fill_slice(job, z);
+
+        int64_t done = __atomic_add_fetch(&job->done, 1, __ATOMIC_RELAXED);
+        if (job->opts->progress && done <= nz) {
+            __atomic_store_n(job->opts->progress, (int)(done * 900 / nz), __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/* Заливка вдоль Z: столбцы слов [lo, hi) каждого слоя, вверх и вниз */
+static void z_task(void *ctx, int task, int task_count)
+{
+    fill_job *job = ctx;
+    int64_t   sw  = job->slice_words;
+    int64_t   lo  = sw * task / task_count, hi = sw * (task + 1) / task_count;
+    int       nz  = job->b->nz;
+
+    for (int pass = 0; pass < 2; pass++) {
+        if (cancelled(job->opts)) return;
+        int step = pass == 0 ? 1 : -1;
+        for (int z = pass == 0 ? 1 : nz - 2; z >= 0 && z < nz; z += step) {
+            uint64_t       *e    = job->ext + z * sw;
+            const uint64_t *from = e - step * sw;
+            const uint64_t *open = job->open + z * sw;
+            bool            grew = false;
+            for (int64_t w = lo; w < hi; w++) {
+                uint64_t add = from[w] & open[w] & ~e[w];
+                if (add == 0) continue;
+                e[w] |= add;
+                grew  = true;
+            }
+            if (grew) {
+                __atomic_store_n(&job->dirty[z], 1, __ATOMIC_RELAXED);
+                __atomic_store_n(&job->z_grew, 1, __ATOMIC_RELAXED);
+            }
+        }
+    }
+}
+
+/* Внутренность — пустые ячейки, не достигнутые снаружи */
+static void store_task(void *ctx, int task, int task_count)
+{
+    fill_job *job   = ctx;
+    vxbits   *b     = job->b;
+    int       rw    = job->rw;
+    int64_t   added = 0;
+    for (int z = task; z < b->nz; z += task_count) {
+        for (int y = 0; y < b->ny; y++) {
+            int64_t row = (int64_t)z * job->slice_words + (int64_t)y * rw;
+            int64_t pos = vxbits_cell(b, 0, y, z);
+            for (int i = 0; i < rw; i++) {
+                uint64_t inside = job->open[row + i] & ~job->ext[row + i];
+                or_bits(b, pos + i * 64, i < rw - 1 ? 64 : b->nx - i * 64, inside);
+                added += __builtin_popcountll(inside);
+            }
+        }
+    }
+    __atomic_add_fetch(&job->added, added, __ATOMIC_RELAXED);
+}
+
+/* =========================================================
+ *  vx_fill_interior
+ *  Проход XY замыкает каждый слой в плоскости, проход Z —
+ *  каждый столбец; они чередуются, пока проход Z что-то
+ *  добавляет. Для тел без глубоких «карманов» хватает двух
+ *  раундов.
+ * ========================================================= */
+int64_t vx_fill_interior(vxbits *b, const vx_bin_opts *opts)
+{
+    vx_bin_opts defaults = {.threads = 0, .deterministic = true, .cancel = NULL, .progress = NULL};
+    if (opts == NULL) opts = &defaults;
+    if (b->cells == 0) return 0;
+
+    fill_job job = {.b = b, .opts = opts};
+    job.rw          = (b->nx + 63) / 64;
+    job.slice_words = (int64_t)job.rw * b->ny;
+    job.last_mask   = b->nx % 64 ? ((uint64_t)1 << (b->nx % 64)) - 1 : ~(uint64_t)0;
+
+    size_t words = (size_t)(job.slice_words * b->nz);
+    job.open  = malloc(words * sizeof(uint64_t));
+    job.ext   = malloc(words * sizeof(uint64_t));
+    job.dirty = malloc((size_t)b->nz);
+    assert(job.open != NULL && job.ext != NULL && job.dirty != NULL);
+    memset(job.dirty, 1, (size_t)b->nz);
+
+    int threads = opts->threads > 0 ? opts->threads : vx_thread_count();
+    int slices  = threads < b->nz ? threads : b->nz;
+    int columns = threads < job.slice_words ? threads : (int)job.slice_words;
+
+    bool stop = false;
+    run(slices, load_task, &job);
+    while (!stop) {
+        run(slices, xy_task, &job);
+        job.z_grew = 0;
+        if ((stop = cancelled(opts))) break;
+        run(columns, z_task, &job);
+        stop = cancelled(opts) || !job.z_grew;
+    }
+
+    int64_t added = -1;
+    if (!cancelled(opts)) {
+        run(slices, store_task, &job);
+        added = job.added;
+        if (opts->progress) __atomic_store_n(opts->progress, 1000, __ATOMIC_RELAXED);
+    }
+
+    free(job.open);
+    free(job.ext);
+    free(job.dirty);
+    return added;
+}
+
+int64_t vx_fill_mesh(vxbits *solid, const vxlist *mesh, int min_count, const vx_bin_opts *opts)
+{
+    vxbits_from_mesh(solid, mesh, min_count);
+    return vx_fill_interior(solid, opts);
+}
@@ -0,0 +1,52 @@
+#ifndef VXFILL_H
+#define VXFILL_H
+
+#include <stdint.h>
+#include "voxel.h"
+#include "vxbits.h"
+
+/* =========================================================
+ *  Заливка внутренности вокселизированной поверхности
+ *
+ *  Поверхность (занятые ячейки) превращается в сплошное тело:
+ *  снаружи от границ сетки заливаются пустые ячейки, всё, до
+ *  чего заливка не добралась, — внутренность. В отличие от
+ *  чётности пересечений вдоль строки, такой способ не ломается
+ *  на касаниях, самопересечениях и вложенных оболочках; если же
+ *  поверхность не замкнута, заливка уходит внутрь и тело
+ *  совпадает с поверхностью.
+ * ========================================================= */
+
+/**
+ * @brief Добавляет в @p b ячейки, отделённые поверхностью от границы сетки.
+ *
+ * Соседство — по граням (6 соседей), ячейки на границе сетки считаются
+ * наружными, если пусты. Заливка идёт по 64 ячейки за операцию: вдоль X —
+ * переносом по словам строки, вдоль Y и Z — пословным «и» соседних строк
+ * и слоёв. Проходы по слоям Z (в плоскости XY) и по столбцам слов (вдоль Z)
+ * распределяются между потоками и чередуются, пока заливка не перестанет
+ * расти. Счётчики @p b не меняются (у внутренних ячеек они нулевые).
+ * Временно нужно два массива по ⌈nx / 64⌉ · ny · nz слов.
+ *
+ * @param b    Поверхность; на выходе — поверхность с внутренностью.
+ * @param opts Потоки, отмена и ход работы (NULL — все ядра, без отмены).
+ * @return Число добавленных ячеек или -1, если заливка отменена
+ *         (тогда @p b не меняется).
+ */
+int64_t vx_fill_interior(vxbits *b, const vx_bin_opts *opts);
+
+/**
+ * @brief Сплошное тело по плотной сетке вокселей.
+ *
+ * Поверхность — воксели @p mesh, где не меньше @p min_count вершин
+ * (vxbits_from_mesh), затем vx_fill_interior.
+ *
+ * @param solid     Пустая сетка размеров mesh->nx × ny × nz.
+ * @param mesh      Плотная сетка (не Мортона) после ind_finder.
+ * @param min_count Порог вершин для ячейки поверхности.
+ * @param opts      Как у vx_fill_interior.
+ * @return Как у vx_fill_interior.
+ */
+int64_t vx_fill_mesh(vxbits *solid, const vxlist *mesh, int min_count, const vx_bin_opts *opts);
+
+#endif /* VXFILL_H */
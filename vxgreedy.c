@@ -0,0 +1,344 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "vxgreedy.h"
+#include "ply.h"
+#include "vxsys.h"
+
+/* Оси слоя (u, v) для оси нормали X, Y, Z и знак u × v относительно
+ * оси нормали: Y × Z = +X, X × Z = −Y, X × Y = +Z */
+static const int U_AXIS[3] = {1, 0, 0};
+static const int V_AXIS[3] = {2, 2, 1};
+static const int UV_SIGN[3] = {1, -1, 1};
+
+/**
+ * @brief Прямоугольники одного слоя.
+ */
+typedef struct quad_buf {
+    vx_quad *items;
+    int64_t  count;
+    int64_t  capacity;
+    int64_t  faces;
+} quad_buf;
+
+/* Единица работы — слой граней Y или Z либо пачка из 64 слоёв граней X */
+#define X_PACK 64
+
+typedef struct greedy_job {
+    const vxbits *b;
+    int           dims[3];
+    int64_t      *per_z;      /**< Занятых ячеек в слое z: пустые строки масок пропускаются. */
+    int           first[7];   /**< Номер первой единицы работы направления; first[6] — всего. */
+    int           slice0[6];  /**< Номер первого слоя направления в slices.  */
+    int64_t       mask_words; /**< Слов масок на одну единицу работы.        */
+    quad_buf     *slices;     /**< Прямоугольники каждого слоя.              */
+    int           next_unit;
+} greedy_job;
+
+static void quad_push(quad_buf *q, vx_quad r)
+{
+    if (q->count == q->capacity) {
+        q->capacity = q->capacity ? q->capacity * 2 : 64;
+        q->items    = realloc(q->items, (size_t)q->capacity * sizeof(vx_quad));
+        assert(q->items != NULL);
+    }
+    q->items[q->count++] = r;
+}
+
+/* Биты [u0, u1) строки, попадающие в слово w */
+static uint64_t span_bits(int w, int u0, int u1)
+{
+    int lo = u0 - w * 64, hi = u1 - w * 64;
+    if (lo < 0)  lo = 0;
+    if (hi > 64) hi = 64;
+    uint64_t m = hi == 64 ? ~(uint64_t)0 : ((uint64_t)1 << hi) - 1;
+    return m & (~(uint64_t)0 << lo);
+}
+
+static bool span_full(const uint64_t *row, int u0, int u1)
+{
+    for (int w = u0 >> 6; w <= (u1 - 1) >> 6; w++) {
+        uint64_t m = span_bits(w, u0, u1);
+        if ((row[w] & m) != m) return false;
+    }
+    return true;
+}
+
+static void span_clear(uint64_t *row, int u0, int u1)
+{
+    for (int w = u0 >> 6; w <= (u1 - 1) >> 6; w++) row[w] &= ~span_bits(w, u0, u1);
+}
+
+/* Первый нулевой бит строки не раньше u (биты за концом строки — нули) */
+static int run_end(const uint64_t *row, int u, int row_words)
+{
+    int      w = u >> 6;
+    uint64_t m = ~row[w] & (~(uint64_t)0 << (u & 63));
+    while (m == 0) {
+        if (++w == row_words) return row_words * 64;
+        m = ~row[w];
+    }
+    return w * 64 + __builtin_ctzll(m);
+}
+
+/* =========================================================
+ *  Маски граней
+ *  Бит (u, v) стоит, если ячейка слоя занята, а соседняя по
+ *  направлению нормали — пуста или за границей сетки. Для
+ *  граней Y и Z строка маски — строка X сетки, и она берётся
+ *  словами. Для граней X строка маски идёт поперёк слов, поэтому
+ *  маски строятся пачкой на X_PACK слоёв: одно слово строки X
+ *  даёт грани всех слоёв пачки, и по маскам раскладываются
+ *  только стоящие биты. Строки из пустых слоёв z не читаются.
+ * ========================================================= */
+static void face_mask(const greedy_job *job, int dir, int k, uint64_t *mask, int row_words)
+{
+    const vxbits *b    = job->b;
+    int           axis = dir / 2;
+    int           nk   = dir % 2 == 0 ? k + 1 : k - 1;
+    bool          open = nk < 0 || nk >= job->dims[axis];
+    int           nu   = job->dims[U_AXIS[axis]];
+    int           nv   = job->dims[V_AXIS[axis]];
+
+    memset(mask, 0, (size_t)nv * row_words * sizeof(uint64_t));
+    if (axis == 2 && job->per_z[k] == 0) return;
+    for (int v = 0; v < nv; v++) {
+        uint64_t *row = mask + (int64_t)v * row_words;
+        if (axis == 1 && job->per_z[v] == 0) continue;
+        int64_t pos = axis == 1 ? vxbits_cell(b, 0, k, v) : vxbits_cell(b, 0, v, k);
+        int64_t nb  = open ? 0 : axis == 1 ? vxbits_cell(b, 0, nk, v) : vxbits_cell(b, 0, v, nk);
+        for (int w = 0; w < row_words; w++) {
+            int len = nu - w * 64 < 64 ? nu - w * 64 : 64;
+            row[w]  = vxbits_load(b, pos + w * 64, len);
+            if (!open && row[w] != 0) row[w] &= ~vxbits_load(b, nb + w * 64, len);
+        }
+    }
+}
+
+/* Маски слоёв x0 .. x0+count-1 граней X: маска слоя t — с mask + t · mask_words */
+static void x_masks(const greedy_job *job, int dir, int x0, int count, uint64_t *mask,
+                    int64_t mask_words, int row_words)
+{
+    const vxbits *b     = job->b;
+    bool          plus  = dir == VX_FACE_XP;
+    uint64_t      valid = count < 64 ? ((uint64_t)1 << count) - 1 : ~(uint64_t)0;
+
+    memset(mask, 0, (size_t)count * mask_words * sizeof(uint64_t));
+    for (int z = 0; z < b->nz; z++) {
+        if (job->per_z[z] == 0) continue;
+        for (int y = 0; y < b->ny; y++) {
+            int64_t  pos = vxbits_cell(b, x0, y, z);
+            uint64_t occ = vxbits_load(b, pos, count);
+            if (occ == 0) continue;
+
+            /* Соседи по X: сдвиг слова, на краю пачки — бит соседней пачки */
+            uint64_t nb;
+            if (plus) {
+                nb = occ >> 1;
+                if (x0 + count < b->nx && vxbits_test(b, pos + count)) nb |= (uint64_t)1 << (count - 1);
+            } else {
+                nb = occ << 1;
+                if (x0 > 0 && vxbits_test(b, pos - 1)) nb |= 1;
+            }
+            uint64_t face = occ & ~nb & valid;
+            int64_t  word = (int64_t)z * row_words + (y >> 6);
+            uint64_t bit  = (uint64_t)1 << (y & 63);
+            while (face != 0) {
+                int t = __builtin_ctzll(face);
+                mask[t * mask_words + word] |= bit;
+                face &= face - 1;
+            }
+        }
+    }
+}
+
+/* =========================================================
+ *  Жадное слияние
+ *  Строки маски обходятся по порядку: от первого стоящего
+ *  бита берётся наибольший отрезок по u, затем он тянется по
+ *  v, пока следующая строка покрывает его целиком. Покрытые
+ *  биты снимаются, так что каждая грань попадает ровно в один
+ *  прямоугольник.
+ * ========================================================= */
+static void merge_mask(uint64_t *mask, int nv, int row_words, int dir, int k, quad_buf *out)
+{
+    int rw = row_words;
+    for (int v = 0; v < nv; v++) {
+        uint64_t *row = mask + (int64_t)v * rw;
+        for (int w = 0; w < rw; w++) {
+            while (row[w] != 0) {
+                int u0 = w * 64 + __builtin_ctzll(row[w]);
+                int u1 = run_end(row, u0, rw);
+                span_clear(row, u0, u1);
+
+                int h = 1;
+                while (v + h < nv && span_full(row + (int64_t)h * rw, u0, u1)) {
+                    span_clear(row + (int64_t)h * rw, u0, u1);
+                    h++;
+                }
+                quad_push(out, (vx_quad){dir, k, u0, v, u1 - u0, h});
+                out->faces += (int64_t)(u1 - u0) * h;
+            }
+        }
+    }
+}
+
+static void mesh_unit(const greedy_job *job, int unit, uint64_t *mask)
+{
+    int dir = 0;
+    while (unit >= job->first[dir + 1]) dir++;
+    int axis = dir / 2;
+    int nv   = job->dims[V_AXIS[axis]];
+    int rw   = (job->dims[U_AXIS[axis]] + 63) / 64;
+
+    if (axis == 0) {
+        int     x0    = (unit - job->first[dir]) * X_PACK;
+        int     count = job->dims[0] - x0 < X_PACK ? job->dims[0] - x0 : X_PACK;
+        int64_t words = (int64_t)nv * rw;
+        x_masks(job, dir, x0, count, mask, words, rw);
+        for (int t = 0; t < count; t++) {
+            merge_mask(mask + t * words, nv, rw, dir, x0 + t,
+                       &job->slices[job->slice0[dir] + x0 + t]);
+        }
+        return;
+    }
+    int k = unit - job->first[dir];
+    face_mask(job, dir, k, mask, rw);
+    merge_mask(mask, nv, rw, dir, k, &job->slices[job->slice0[dir] + k]);
+}
+
+static void greedy_task(void *ctx, int task, int tasks)
+{
+    (void)task; (void)tasks;
+    greedy_job *job  = ctx;
+    uint64_t   *mask = malloc((size_t)job->mask_words * sizeof(uint64_t));
+    assert(mask != NULL);
+    for (;;) {
+        int unit = __atomic_fetch_add(&job->next_unit, 1, __ATOMIC_RELAXED);
+        if (unit >= job->first[6]) break;
+        mesh_unit(job, unit, mask);
+    }
+    free(mask);
+}
+
+int64_t vx_greedy_mesh(vx_quadlist *q, const vxbits *b, Vector3 origin, float voxel_w,
+                       const vx_bin_opts *opts)
+{
+    vx_quads_free(q);
+    q->origin  = origin;
+    q->voxel_w = voxel_w;
+    if (b->cells == 0) return 0;
+
+    greedy_job job = {.b = b, .dims = {b->nx, b->ny, b->nz}};
+    int        slice_count = 0;
+    for (int dir = 0; dir < 6; dir++) {
+        int     axis  = dir / 2;
+        int64_t words = (int64_t)job.dims[V_AXIS[axis]] * ((job.dims[U_AXIS[axis]] + 63) / 64);
+        int     units = job.dims[axis];
+        if (axis == 0) {
+            words *= job.dims[0] < X_PACK ? job.dims[0] : X_PACK;
+            units  = (units + X_PACK - 1) / X_PACK;
+        }
+        if (words > job.mask_words) job.mask_words = words;
+        job.first[dir + 1] = job.first[dir] + units;
+        job.slice0[dir]    = slice_count;
+        slice_count       += job.dims[axis];
+    }
+    job.slices = calloc((size_t)slice_count, sizeof(quad_buf));
+    job.per_z  = malloc((size_t)b->nz * sizeof(int64_t));
+    assert(job.slices != NULL && job.per_z != NULL);
+    vxbits_popcount_z(b, job.per_z);
+
+    int tasks = opts != NULL && opts->threads > 0 ? opts->threads : vx_thread_count();
+    if (tasks > job.first[6]) tasks = job.first[6];
+    if (tasks > 1) vx_parallel_run(tasks, greedy_task, &job);
+    else           greedy_task(&job, 0, 1);
+
+    /* Склейка по порядку слоёв — результат не зависит от потоков */
+    int64_t total = 0;
+    for (int s = 0; s < slice_count; s++) total += job.slices[s].count;
+    q->items = malloc((size_t)(total > 0 ? total : 1) * sizeof(vx_quad));
+    assert(q->items != NULL);
+    q->capacity = total;
+    for (int s = 0; s < slice_count; s++) {
+        quad_buf *sb = &job.slices[s];
+        if (sb->count > 0) memcpy(q->items + q->count, sb->items, (size_t)sb->count * sizeof(vx_quad));
+        q->count += sb->count;
+        q->faces += sb->faces;
+        free(sb->items);
+    }
+    free(job.slices);
+    free(job.per_z);
+    return q->count;
+}
+
+void vx_quads_free(vx_quadlist *q)
+{
+    free(q->items);
+    *q = (vx_quadlist){0};
+}
+
+/* =========================================================
+ *  vx_quads_write_ply
+ * ========================================================= */
+vx_status vx_quads_write_ply(const vx_quadlist *q, const char *filename, int64_t *triangles,
+                             vx_error *err)
+{
+    if (triangles != NULL) *triangles = 0;
+    if (q->count > INT32_MAX / 4) {
+        return vx_fail(err, VX_ERR_FORMAT, "Слишком много прямоугольников для PLY: %lld",
+                       (long long)q->count);
+    }
+    FILE *f = fopen(filename, "wb");
+    if (f == NULL) return vx_fail(err, VX_ERR_OPEN, "Не удалось создать %s", filename);
+
+    fprintf(f, "ply\nformat %s 1.0\n", ply_host_little_endian() ? "binary_little_endian"
+                                                                : "binary_big_endian");
+    fprintf(f, "comment greedy voxel mesh, voxel_w %.9g\n", q->voxel_w);
+    fprintf(f, "element vertex %lld\n", (long long)q->count * 4);
+    fprintf(f, "property float x\nproperty float y\nproperty float z\n");
+    fprintf(f, "element face %lld\n", (long long)q->count * 2);
+    fprintf(f, "property list uchar int vertex_indices\n");
+    fprintf(f, "end_header\n");
+
+    const float o[3] = {q->origin.x, q->origin.y, q->origin.z};
+    bool        ok   = true;
+    for (int64_t i = 0; i < q->count && ok; i++) {
+        const vx_quad *r    = &q->items[i];
+        int            axis = r->dir / 2;
+        int            sign = r->dir % 2 == 0 ? 1 : -1;
+        int            ua   = U_AXIS[axis], va = V_AXIS[axis];
+
+        /* Углы (0,0) (1,0) (1,1) (0,1) идут против часовой стрелки вокруг
+         * u × v; если нормаль смотрит в другую сторону — обход обратный */
+        static const int CCW[4][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+        static const int CW[4][2]  = {{0, 0}, {0, 1}, {1, 1}, {1, 0}};
+        const int (*corner)[2] = sign == UV_SIGN[axis] ? CCW : CW;
+
+        float xyz[12];
+        for (int c = 0; c < 4; c++) {
+            int cell[3];
+            cell[axis] = r->slice + (sign > 0);
+            cell[ua]   = r->u + corner[c][0] * r->w;
+            cell[va]   = r->v + corner[c][1] * r->h;
+            for (int k = 0; k < 3; k++) xyz[3 * c + k] = o[k] + (float)cell[k] * q->voxel_w;
+        }
+        ok = fwrite(xyz, sizeof(float), 12, f) == 12;
+    }
+
+    for (int64_t i = 0; i < q->count && ok; i++) {
+        int32_t base      = (int32_t)(i * 4);
+        int32_t tri[2][3] = {{base, base + 1, base + 2}, {base, base + 2, base + 3}};
+        for (int t = 0; t < 2; t++) {
+            uint8_t face[1 + 3 * sizeof(int32_t)];
+            face[0] = 3;
+            memcpy(face + 1, tri[t], sizeof(tri[t]));
+            ok = ok && fwrite(face, 1, sizeof(face), f) == sizeof(face);
+        }
+    }
+
+    if (fclose(f) != 0 || !ok) return vx_fail(err, VX_ERR_WRITE, "Ошибка записи %s", filename);
+    if (triangles != NULL) *triangles = q->count * 2;
+    return VX_OK;
+}
@@ -0,0 +1,94 @@
+#ifndef VXGREEDY_H
+#define VXGREEDY_H
+
+#include <stdint.h>
+#include "voxel.h"
+#include "vxbits.h"
+
+/* =========================================================
+ *  Экспорт занятых ячеек треугольной сеткой (greedy meshing)
+ *
+ *  Куб на каждую ячейку — 12 треугольников, большинство из
+ *  которых спрятаны между соседними занятыми ячейками. Здесь
+ *  остаются только грани между занятой и пустой ячейкой, а
+ *  грани одного направления в одном слое сливаются жадно в
+ *  наибольшие прямоугольники: каждый прямоугольник — два
+ *  треугольника. Слои обрабатываются параллельно.
+ * ========================================================= */
+
+/**
+ * @brief Направление нормали прямоугольника.
+ */
+typedef enum {
+    VX_FACE_XP, /**< +X */
+    VX_FACE_XN, /**< −X */
+    VX_FACE_YP, /**< +Y */
+    VX_FACE_YN, /**< −Y */
+    VX_FACE_ZP, /**< +Z */
+    VX_FACE_ZN, /**< −Z */
+} vx_face_dir;
+
+/**
+ * @brief Прямоугольник из граней ячеек одного слоя.
+ *
+ * Оси слоя: для граней X — (u, v) = (Y, Z), для Y — (X, Z), для Z — (X, Y).
+ * Грань лежит на стороне ячеек слоя @p slice, куда смотрит нормаль.
+ */
+typedef struct vx_quad {
+    int32_t dir;   /**< vx_face_dir.                  */
+    int32_t slice; /**< Номер слоя вдоль оси нормали. */
+    int32_t u, v;  /**< Угловая ячейка в слое.         */
+    int32_t w, h;  /**< Размер в ячейках по u и v.     */
+} vx_quad;
+
+/**
+ * @brief Прямоугольники поверхности сетки занятости.
+ */
+typedef struct vx_quadlist {
+    vx_quad *items;    /**< Прямоугольники: по направлениям, слоям, строкам. */
+    int64_t  count;    /**< Количество.                                     */
+    int64_t  capacity; /**< Вместимость массива.                            */
+    int64_t  faces;    /**< Граней ячеек до слияния (площадь в ячейках).     */
+    Vector3  origin;   /**< Угол ячейки (0, 0, 0) в координатах сцены.      */
+    float    voxel_w;  /**< Длина ребра ячейки.                             */
+} vx_quadlist;
+
+/**
+ * @brief Строит поверхность занятых ячеек @p b из наибольших прямоугольников.
+ *
+ * Границы сетки считаются пустыми, так что поверхность замкнута.
+ * Результат не зависит от числа потоков: у каждого слоя свой список,
+ * потоки разбирают слои (грани X — пачками по 64 слоя), а списки
+ * склеиваются по порядку направлений и слоёв.
+ *
+ * @param q       [out] Прямоугольники (прежнее содержимое освобождается).
+ * @param origin  Угол ячейки (0, 0, 0) в координатах сцены.
+ * @param voxel_w Длина ребра ячейки.
+ * @param opts    Потоки (opts->threads) или NULL — все ядра.
+ * @return Число прямоугольников.
+ */
+int64_t vx_greedy_mesh(vx_quadlist *q, const vxbits *b, Vector3 origin, float voxel_w,
+                       const vx_bin_opts *opts);
+
+/**
+ * @brief Освобождает память списка и обнуляет его поля.
+ */
+void vx_quads_free(vx_quadlist *q);
+
+/**
+ * @brief Записывает прямоугольники треугольниками в binary PLY.
+ *
+ * Порядок байт машины; по 4 вершины (x, y, z — float, координаты сцены)
+ * и 2 треугольника (list uchar int vertex_indices) на прямоугольник,
+ * обход — против часовой стрелки, если смотреть снаружи. Индексы
+ * вершин — int32, поэтому больше INT32_MAX / 4 прямоугольников не
+ * записываются (VX_ERR_FORMAT).
+ *
+ * @param triangles [out] Число записанных треугольников или NULL.
+ * @param err       [out] Текст ошибки или NULL.
+ * @return VX_OK или код ошибки.
+ */
+vx_status vx_quads_write_ply(const vx_quadlist *q, const char *filename, int64_t *triangles,
+                             vx_error *err);
+
+#endif /* VXGREEDY_H */
@@ -0,0 +1,137 @@
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "vxhash.h"
+
+/* =========================================================
+ *  vxhash_mix
+ *  Финализатор splitmix64: соседние линейные индексы ячеек
+ *  разлетаются по всей таблице.
+ * ========================================================= */
+static uint64_t vxhash_mix(uint64_t k)
+{
+    k ^= k >> 30; k *= 0xbf58476d1ce4e5b9ULL;
+    k ^= k >> 27; k *= 0x94d049bb133111ebULL;
+    k ^= k >> 31;
+    return k;
+}
+
+static void vxhash_alloc(vxhash *h, int capacity)
+{
+    h->keys   = malloc((size_t)capacity * sizeof(uint64_t));
+    h->values = malloc((size_t)capacity * sizeof(int));
+    assert(h->keys != NULL && h->values != NULL);
+    memset(h->keys, 0xff, (size_t)capacity * sizeof(uint64_t)); /* VXHASH_EMPTY */
+    h->capacity = capacity;
+    h->count    = 0;
+}
+
+void vxhash_init(vxhash *h, int expected)
+{
+    int capacity = 16;
+    while (capacity < 2 * expected) capacity *= 2;
+    vxhash_alloc(h, capacity);
+}
+
+void vxhash_free(vxhash *h)
+{
+    free(h->keys);
+    free(h->values);
+    h->keys     = NULL;
+    h->values   = NULL;
+    h->capacity = 0;
+    h->count    = 0;
+}
+
+int vxhash_find(const vxhash *h, uint64_t key)
+{
+    if (h->capacity == 0) return -1;
+    uint64_t mask = (uint64_t)h->capacity - 1;
+    for (uint64_t i = vxhash_mix(key) & mask; ; i = (i + 1) & mask) {
+        if (h->keys[i] == key)          return h->values[i];
+        if (h->keys[i] == VXHASH_EMPTY) return -1;
+    }
+}
+
+/* Перестройка в таблицу вдвое большего размера */
+static void vxhash_grow(vxhash *h)
+{
+    vxhash old = *h;
+    vxhash_alloc(h, old.capacity ? old.capacity * 2 : 16);
+    for (int i = 0; i < old.capacity; i++) {
+        if (old.keys[i] != VXHASH_EMPTY) vxhash_insert(h, old.keys[i], old.values[i]);
+    }
+    free(old.keys);
+    free(old.values);
+}
+
+int vxhash_insert(vxhash *h, uint64_t key, int value)
+{
+    if (2 * (h->count + 1) > h->capacity) vxhash_grow(h);
+
+    uint64_t mask = (uint64_t)h->capacity - 1;
+    for (uint64_t i = vxhash_mix(key) & mask; ; i = (i + 1) & mask) {
+        if (h->keys[i] == key) return h->values[i];
+        if (h->keys[i] == VXHASH_EMPTY) {
+            h->keys[i]   = key;
+            h->values[i] = value;
+            h->count++;
+            return value;
+        }
+    }
+}
+
+/* =========================================================
+ *  vxhash_remove
+ *  Обратный сдвиг: ключ j после освобождённого слота i
+ *  переезжает в i, если его домашний слот не лежит между i
+ *  и j, — иначе поиск от дома дошёл бы до пустого i раньше.
+ * ========================================================= */
+int vxhash_remove(vxhash *h, uint64_t key)
+{
+    if (h->capacity == 0) return -1;
+    uint64_t mask = (uint64_t)h->capacity - 1;
+    uint64_t i    = vxhash_mix(key) & mask;
+    while (h->keys[i] != key) {
+        if (h->keys[i] == VXHASH_EMPTY) return -1;
+        i = (i + 1) & mask;
+    }
+    int value = h->values[i];
+
+    for (uint64_t j = (i + 1) & mask; h->keys[j] != VXHASH_EMPTY; j = (j + 1) & mask) {
+        uint64_t home = vxhash_mix(h->keys[j]) & mask;
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            h->keys[i]   = h->keys[j];
+            h->values[i] = h->values[j];
+            i = j;
+        }
+    }
+    h->keys[i] = VXHASH_EMPTY;
+    h->count--;
+    return value;
+}
+
+int vx_keyed_compare(const void *a, const void *b)
+{
+    int64_t ka = ((const vx_keyed *)a)->key;
+    int64_t kb = ((const vx_keyed *)b)->key;
+    return (ka > kb) - (ka < kb);
+}
+
+int vx_keyed_sorted(const int64_t *keys, const int64_t *counts, int n,
+                    int64_t min_count, int **order)
+{
+    vx_keyed *pairs = malloc(((size_t)n + 1) * sizeof(vx_keyed));
+    assert(pairs != NULL);
+    int m = 0;
+    for (int i = 0; i < n; i++) {
+        if (counts[i] >= min_count) pairs[m++] = (vx_keyed){keys[i], i};
+    }
+    qsort(pairs, m, sizeof(vx_keyed), vx_keyed_compare);
+
+    *order = malloc(((size_t)m + 1) * sizeof(int));
+    assert(*order != NULL);
+    for (int k = 0; k < m; k++) (*order)[k] = pairs[k].item;
+    free(pairs);
+    return m;
+}
@@ -0,0 +1,86 @@
+#ifndef VXHASH_H
+#define VXHASH_H
+
+#include <stdint.h>
+
+/* =========================================================
+ *  Хеш-таблица ячеек: 64-битный ключ -> индекс вокселя
+ * ========================================================= */
+
+/** Ключ свободного слота (линейный индекс ячейки никогда его не достигает). */
+#define VXHASH_EMPTY UINT64_MAX
+
+/**
+ * @brief Хеш-таблица с открытой адресацией и линейным пробированием.
+ *
+ * Используется разреженной сеткой: ключ — линейный индекс ячейки
+ * zi·(nx·ny) + yi·nx + xi в 64 битах, значение — индекс вокселя в
+ * vxlist.items. Заполненность держится не выше 1/2.
+ */
+typedef struct vxhash {
+    uint64_t *keys;     /**< Ключи; VXHASH_EMPTY — свободный слот. */
+    int      *values;   /**< Значения, параллельно keys.           */
+    int       capacity; /**< Число слотов (степень двойки).         */
+    int       count;    /**< Число занятых слотов.                  */
+} vxhash;
+
+/**
+ * @brief Ячейка и номер её записи — для выдачи ячеек по возрастанию индекса.
+ */
+typedef struct vx_keyed {
+    int64_t key;  /**< Линейный индекс ячейки.                 */
+    int     item; /**< Номер записи (слот, воксель) владельца.  */
+} vx_keyed;
+
+/**
+ * @brief Сравнение vx_keyed по key для qsort.
+ */
+int vx_keyed_compare(const void *a, const void *b);
+
+/**
+ * @brief Номера записей, где counts[i] >= @p min_count, по возрастанию keys[i].
+ *
+ * @param keys   Линейные индексы ячеек, @p n штук.
+ * @param counts Счётчики, параллельно keys.
+ * @param order  [out] Массив номеров (освобождать free).
+ * @return Длина массива.
+ */
+int vx_keyed_sorted(const int64_t *keys, const int64_t *counts, int n,
+                    int64_t min_count, int **order);
+
+/**
+ * @brief Создаёт таблицу, рассчитанную на @p expected ключей без перестройки.
+ */
+void vxhash_init(vxhash *h, int expected);
+
+/**
+ * @brief Освобождает память таблицы и обнуляет её поля.
+ */
+void vxhash_free(vxhash *h);
+
+/**
+ * @brief Ищет ключ.
+ *
+ * @return Значение, связанное с @p key, или -1, если ключа нет.
+ */
+int vxhash_find(const vxhash *h, uint64_t key);
+
+/**
+ * @brief Вставляет ключ, если его ещё нет.
+ *
+ * @param value Значение для нового ключа.
+ * @return Значение, уже связанное с @p key, либо @p value, если ключ вставлен.
+ */
+int vxhash_insert(vxhash *h, uint64_t key, int value);
+
+/**
+ * @brief Удаляет ключ.
+ *
+ * Следующие за ним ключи цепочки сдвигаются назад, поэтому
+ * поиск после удалений не замедляется.
+ *
+ * @return Значение, которое было связано с @p key, или -1, если ключа нет.
+ */
+int vxhash_remove(vxhash *h, uint64_t key);
+
+#endif /* VXHASH_H */
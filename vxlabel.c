@@ -0,0 +1,427 @@
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <assert.h>
+#include "vxlabel.h"
+#include "vxsys.h"
+
+typedef struct label_job {
+    const vxbits *b;
+    vxbits       *out;        /**< Фильтр: сетка, из которой убираются ячейки. */
+    int64_t      *rank;
+    int32_t      *parent;     /**< Лес множеств по рангам занятых ячеек.       */
+    int32_t      *label;
+    vx_component *items;
+    int64_t       occupied;
+    int64_t       min_cells;
+    int           nbr[13][3]; /**< Соседи с меньшим индексом: dx, dy, dz.      */
+    int           nbr_count;
+    int64_t      *task_sum;   /**< Счётчики задач: занятые, корни, убранные.    */
+} label_job;
+
+/* Биты слова w, попадающие в ячейки [begin, end) */
+static uint64_t range_bits(const vxbits *b, int64_t w, int64_t begin, int64_t end)
+{
+    uint64_t bits = b->words[w];
+    if (begin > w * 64)    bits &= ~(uint64_t)0 << (begin - w * 64);
+    if (end < w * 64 + 64) bits &= ((uint64_t)1 << (end - w * 64)) - 1;
+    return bits;
+}
+
+/* Ранг занятой ячейки — бита i слова w */
+static int32_t bit_rank(const vxbits *b, const int64_t *rank, int64_t w, int i)
+{
+    return (int32_t)(rank[w] + __builtin_popcountll(b->words[w] & (((uint64_t)1 << i) - 1)));
+}
+
+/* Ранг занятой ячейки c или -1, если она пуста */
+static int64_t rank_of(const vxbits *b, const int64_t *rank, int64_t c)
+{
+    uint64_t word = b->words[c >> 6];
+    uint64_t bit  = (uint64_t)1 << (c & 63);
+    if ((word & bit) == 0) return -1;
+    return rank[c >> 6] + __builtin_popcountll(word & (bit - 1));
+}
+
+/* =========================================================
+ *  Лес множеств
+ *  Корень — наименьший ранг множества: при объединении больший
+ *  корень подвешивается к меньшему сравнением с обменом, так
+ *  что сшивка границ блоков идёт из нескольких потоков без
+ *  блокировок. Сокращение путей вдвое меняет только не-корни
+ *  и только на их же предков — это безопасно при гонках.
+ * ========================================================= */
+static int32_t find_root(int32_t *parent, int32_t x)
+{
+    for (;;) {
+        int32_t px = __atomic_load_n(&parent[x], __ATOMIC_RELAXED);
+        if (px == x) return x;
+        int32_t gx = __atomic_load_n(&parent[px], __ATOMIC_RELAXED);
+        if (gx != px) __atomic_store_n(&parent[x], gx, __ATOMIC_RELAXED);
+        x = gx;
+    }
+}
+
+static void unite(int32_t *parent, int32_t a, int32_t b)
+{
+    for (;;) {
+        a = find_root(parent, a);
+        b = find_root(parent, b);
+        if (a == b) return;
+        if (a < b) {
+            int32_t t = a;
+            a = b;
+            b = t;
+        }
+        int32_t expect = a;
+        if (__atomic_compare_exchange_n(&parent[a], &expect, b, false, __ATOMIC_RELAXED,
+                                        __ATOMIC_RELAXED)) {
+            return;
+        }
+    }
+}
+
+/* Связывает ячейку c ранга r с занятыми соседями с меньшим индексом;
+ * соседи ниже слоя z_min пропускаются */
+static void link_cell(label_job *job, int64_t c, int32_t r, int z_min, bool border_only)
+{
+    const vxbits *b  = job->b;
+    int64_t       xy = (int64_t)b->nx * b->ny;
+    int           z  = (int)(c / xy);
+    int           y  = (int)(c % xy / b->nx);
+    int           x  = (int)(c % b->nx);
+
+    for (int i = 0; i < job->nbr_count; i++) {
+        const int *d = job->nbr[i];
+        if (border_only && d[2] == 0) continue;
+        if (z + d[2] < z_min || y + d[1] < 0 || y + d[1] >= b->ny || x + d[0] < 0 ||
+            x + d[0] >= b->nx) {
+            continue;
+        }
+        int64_t rn = rank_of(b, job->rank, c + (int64_t)d[2] * xy + (int64_t)d[1] * b->nx + d[0]);
+        if (rn >= 0) unite(job->parent, r, (int32_t)rn);
+    }
+}
+
+/* =========================================================
+ *  Задачи пула
+ * ========================================================= */
+
+/* Занятые ячейки в словах задачи */
+static void count_task(void *ctx, int task, int task_count)
+{
+    label_job *job = ctx;
+    int64_t    wc  = job->b->word_count;
+    int64_t    sum = 0;
+    for (int64_t w = wc * task / task_count; w < wc * (task + 1) / task_count; w++) {
+        sum += __builtin_popcountll(job->b->words[w]);
+    }
+    job->task_sum[task] = sum;
+}
+
+/* Ранги слов задачи от её смещения */
+static void rank_task(void *ctx, int task, int task_count)
+{
+    label_job *job = ctx;
+    int64_t    wc  = job->b->word_count;
+    int64_t    sum = job->task_sum[task];
+    for (int64_t w = wc * task / task_count; w < wc * (task + 1) / task_count; w++) {
+        job->rank[w] = sum;
+        sum += __builtin_popcountll(job->b->words[w]);
+    }
+}
+
+/* Блок слоёв задачи: каждое множество начинается одной ячейкой, затем
+ * ячейки связываются с соседями внутри блока */
+static void local_task(void *ctx, int task, int task_count)
+{
+    label_job    *job = ctx;
+    const vxbits *b   = job->b;
+    int64_t       xy  = (int64_t)b->nx * b->ny;
+    int           z0  = (int)((int64_t)b->nz * task / task_count);
+    int           z1  = (int)((int64_t)b->nz * (task + 1) / task_count);
+    int64_t       beg = z0 * xy, end = z1 * xy;
+    if (beg == end) return;
+
+    for (int64_t w = beg >> 6; w <= (end - 1) >> 6; w++) {
+        uint64_t bits = range_bits(b, w, beg, end);
+        while (bits != 0) {
+            int     i = __builtin_ctzll(bits);
+            int64_t c = w * 64 + i;
+            int32_t r = bit_rank(b, job->rank, w, i);
+            bits &= bits - 1;
+            job->parent[r] = r;
+            link_cell(job, c, r, z0, false);
+        }
+    }
+}
+
+/* Нижний слой блока задачи со слоем над ним в предыдущем блоке */
+static void border_task(void *ctx, int task, int task_count)
+{
+    label_job    *job = ctx;
+    const vxbits *b   = job->b;
+    int64_t       xy  = (int64_t)b->nx * b->ny;
+    int           z0  = (int)((int64_t)b->nz * task / task_count);
+    if (task == 0) return;
+
+    int64_t beg = z0 * xy, end = beg + xy;
+    for (int64_t w = beg >> 6; w <= (end - 1) >> 6; w++) {
+        uint64_t bits = range_bits(b, w, beg, end);
+        while (bits != 0) {
+            int     i = __builtin_ctzll(bits);
+            int32_t r = bit_rank(b, job->rank, w, i);
+            link_cell(job, w * 64 + i, r, 0, true);
+            bits &= bits - 1;
+        }
+    }
+}
+
+/* Ранги задачи: каждая ячейка — прямо к корню; корни считаются */
+static void flatten_task(void *ctx, int task, int task_count)
+{
+    label_job *job   = ctx;
+    int64_t    lo    = job->occupied * task / task_count, hi = job->occupied * (task + 1) / task_count;
+    int64_t    roots = 0;
+    for (int64_t r = lo; r < hi; r++) {
+        int32_t root = find_root(job->parent, (int32_t)r);
+        __atomic_store_n(&job->parent[r], root, __ATOMIC_RELAXED);
+        roots += root == r;
+    }
+    job->task_sum[task] = roots;
+}
+
+/* Номера корням по порядку рангов, от смещения задачи */
+static void number_task(void *ctx, int task, int task_count)
+{
+    label_job *job = ctx;
+    int64_t    lo  = job->occupied * task / task_count, hi = job->occupied * (task + 1) / task_count;
+    int32_t    id  = (int32_t)job->task_sum[task];
+    for (int64_t r = lo; r < hi; r++) {
+        if (job->parent[r] == r) job->label[r] = ++id;
+    }
+}
+
+static void label_task(void *ctx, int task, int task_count)
+{
+    label_job *job = ctx;
+    int64_t    lo  = job->occupied * task / task_count, hi = job->occupied * (task + 1) / task_count;
+    for (int64_t r = lo; r < hi; r++) {
+        if (job->parent[r] != r) job->label[r] = job->label[job->parent[r]];
+    }
+}
+
+static void atomic_min(int *p, int v)
+{
+    int cur = __atomic_load_n(p, __ATOMIC_RELAXED);
+    while (v < cur && !__atomic_compare_exchange_n(p, &cur, v, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {}
+}
+
+static void atomic_max(int *p, int v)
+{
+    int cur = __atomic_load_n(p, __ATOMIC_RELAXED);
+    while (v > cur && !__atomic_compare_exchange_n(p, &cur, v, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {}
+}
+
+/* Добавляет накопленное по подряд идущим ячейкам одной компоненты */
+static void flush_component(vx_component *dst, const vx_component *acc)
+{
+    if (acc->cells == 0) return;
+    __atomic_fetch_add(&dst->cells, acc->cells, __ATOMIC_RELAXED);
+    for (int k = 0; k < 3; k++) {
+        atomic_min(&dst->lo[k], acc->lo[k]);
+        atomic_max(&dst->hi[k], acc->hi[k]);
+    }
+}
+
+/* Размеры и рамки компонент по блоку слоёв задачи; подряд идущие ячейки
+ * одной компоненты копятся локально, общие счётчики трогаются на смене */
+static void extent_task(void *ctx, int task, int task_count)
+{
+    label_job    *job = ctx;
+    const vxbits *b   = job->b;
+    int64_t       xy  = (int64_t)b->nx * b->ny;
+    int64_t       beg = (int64_t)b->nz * task / task_count * xy;
+    int64_t       end = (int64_t)b->nz * (task + 1) / task_count * xy;
+    if (beg == end) return;
+
+    int32_t      cur = 0;
+    vx_component acc = {0};
+    for (int64_t w = beg >> 6; w <= (end - 1) >> 6; w++) {
+        uint64_t bits = range_bits(b, w, beg, end);
+        while (bits != 0) {
+            int     i  = __builtin_ctzll(bits);
+            int64_t c  = w * 64 + i;
+            int32_t id = job->label[bit_rank(b, job->rank, w, i)];
+            int     p[3] = {(int)(c % b->nx), (int)(c % xy / b->nx), (int)(c / xy)};
+            bits &= bits - 1;
+
+            if (id != cur) {
+                if (cur != 0) flush_component(&job->items[cur - 1], &acc);
+                cur = id;
+                acc = (vx_component){0, {p[0], p[1], p[2]}, {p[0], p[1], p[2]}};
+            }
+            acc.cells++;
+            for (int k = 0; k < 3; k++) {
+                if (p[k] < acc.lo[k]) acc.lo[k] = p[k];
+                if (p[k] > acc.hi[k]) acc.hi[k] = p[k];
+            }
+        }
+    }
+    if (cur != 0) flush_component(&job->items[cur - 1], &acc);
+}
+
+/* Слова задачи без ячеек мелких компонент */
+static void filter_task(void *ctx, int task, int task_count)
+{
+    label_job *job     = ctx;
+    vxbits    *b       = job->out;
+    int64_t    wc      = b->word_count;
+    int64_t    removed = 0;
+    for (int64_t w = wc * task / task_count; w < wc * (task + 1) / task_count; w++) {
+        uint64_t word = b->words[w], keep = word, bits = word;
+        int64_t  r    = job->rank[w];
+        while (bits != 0) {
+            int     i  = __builtin_ctzll(bits);
+            int32_t id = job->label[r++];
+            if (job->items[id - 1].cells < job->min_cells) {
+                keep &= ~((uint64_t)1 << i);
+                removed++;
+                /* Слово покрывает 32 байта счётчиков целиком, гонок между задачами нет */
+                if (b->counts) {
+                    int64_t cell = w * 64 + i;
+                    b->counts[cell >> 1] &= (uint8_t)~(0xf << ((cell & 1) * 4));
+                }
+            }
+            bits &= bits - 1;
+        }
+        b->words[w] = keep;
+    }
+    job->task_sum[task] = removed;
+}
+
+static void run_tasks(int tasks, vx_task_fn fn, label_job *job)
+{
+    if (tasks > 1) vx_parallel_run(tasks, fn, job);
+    else           fn(job, 0, 1);
+}
+
+static int task_count(const vx_bin_opts *opts)
+{
+    return opts != NULL && opts->threads > 0 ? opts->threads : vx_thread_count();
+}
+
+/* Сумма счётчиков задач; счётчики заменяются смещениями */
+static int64_t exclusive_sum(int64_t *sum, int tasks)
+{
+    int64_t total = 0;
+    for (int t = 0; t < tasks; t++) {
+        int64_t s = sum[t];
+        sum[t]    = total;
+        total    += s;
+    }
+    return total;
+}
+
+/* =========================================================
+ *  vx_label_components
+ * ========================================================= */
+int vx_label_components(vx_labels *l, const vxbits *b, vx_connectivity conn,
+                        const vx_bin_opts *opts)
+{
+    assert(conn == VX_CONN_6 || conn == VX_CONN_18 || conn == VX_CONN_26);
+    vx_labels_free(l);
+    l->conn = conn;
+
+    int       tasks = task_count(opts);
+    label_job job   = {.b = b};
+    int       limit = conn == VX_CONN_6 ? 1 : conn == VX_CONN_18 ? 2 : 3;
+    for (int dz = -1; dz <= 0; dz++) {
+        for (int dy = -1; dy <= 1; dy++) {
+            for (int dx = -1; dx <= 1; dx++) {
+                bool before = dz < 0 || (dz == 0 && (dy < 0 || (dy == 0 && dx < 0)));
+                if (before && abs(dx) + abs(dy) + abs(dz) <= limit) {
+                    int *d = job.nbr[job.nbr_count++];
+                    d[0] = dx;
+                    d[1] = dy;
+                    d[2] = dz;
+                }
+            }
+        }
+    }
+
+    job.task_sum = calloc((size_t)tasks, sizeof(int64_t));
+    l->rank      = malloc((size_t)(b->word_count > 0 ? b->word_count : 1) * sizeof(int64_t));
+    assert(job.task_sum != NULL && l->rank != NULL);
+    job.rank = l->rank;
+
+    /* Ранги: занятые по диапазонам слов, затем смещения */
+    int word_tasks = tasks < b->word_count ? tasks : (int)(b->word_count > 0 ? b->word_count : 1);
+    run_tasks(word_tasks, count_task, &job);
+    l->occupied = job.occupied = exclusive_sum(job.task_sum, word_tasks);
+    run_tasks(word_tasks, rank_task, &job);
+    assert(l->occupied <= INT32_MAX);
+
+    job.parent = malloc((size_t)(l->occupied > 0 ? l->occupied : 1) * sizeof(int32_t));
+    l->label   = job.label = malloc((size_t)(l->occupied > 0 ? l->occupied : 1) * sizeof(int32_t));
+    assert(job.parent != NULL && job.label != NULL);
+    if (l->occupied == 0) {
+        free(job.parent);
+        free(job.task_sum);
+        return 0;
+    }
+
+    /* Блоки слоёв по потокам, затем сшивка их границ */
+    int slabs = tasks < b->nz ? tasks : b->nz;
+    run_tasks(slabs, local_task, &job);
+    run_tasks(slabs, border_task, &job);
+
+    /* Номера компонент по порядку корней */
+    int rank_tasks = tasks < l->occupied ? tasks : (int)l->occupied;
+    run_tasks(rank_tasks, flatten_task, &job);
+    l->count = (int)exclusive_sum(job.task_sum, rank_tasks);
+    run_tasks(rank_tasks, number_task, &job);
+    run_tasks(rank_tasks, label_task, &job);
+    free(job.parent);
+
+    l->items = job.items = malloc((size_t)l->count * sizeof(vx_component));
+    assert(l->items != NULL);
+    for (int i = 0; i < l->count; i++) {
+        l->items[i] = (vx_component){0, {INT_MAX, INT_MAX, INT_MAX}, {-1, -1, -1}};
+    }
+    run_tasks(slabs, extent_task, &job);
+
+    free(job.task_sum);
+    return l->count;
+}
+
+int32_t vx_label_at(const vx_labels *l, const vxbits *b, int64_t cell)
+{
+    int64_t r = rank_of(b, l->rank, cell);
+    return r < 0 ? 0 : l->label[r];
+}
+
+int64_t vx_labels_filter(const vx_labels *l, vxbits *b, int64_t min_cells,
+                         const vx_bin_opts *opts)
+{
+    if (l->occupied == 0) return 0;
+    int       tasks = task_count(opts);
+    label_job job   = {.out = b, .rank = l->rank, .label = l->label, .items = l->items,
+                       .min_cells = min_cells};
+    if (tasks > b->word_count) tasks = (int)b->word_count;
+    job.task_sum = calloc((size_t)tasks, sizeof(int64_t));
+    assert(job.task_sum != NULL);
+    run_tasks(tasks, filter_task, &job);
+
+    int64_t removed = exclusive_sum(job.task_sum, tasks);
+    free(job.task_sum);
+    return removed;
+}
+
+void vx_labels_free(vx_labels *l)
+{
+    free(l->label);
+    free(l->rank);
+    free(l->items);
+    *l = (vx_labels){0};
+}
@@ -0,0 +1,91 @@
+#ifndef VXLABEL_H
+#define VXLABEL_H
+
+#include <stdint.h>
+#include "voxel.h"
+#include "vxbits.h"
+
+/* =========================================================
+ *  Связные компоненты занятых ячеек
+ *
+ *  Сцена делится на отдельные объекты, мелкие скопления шума
+ *  отбрасываются. Метки ставятся системой непересекающихся
+ *  множеств над занятыми ячейками: каждый поток связывает
+ *  ячейки своего слоя z-блока, затем границы соседних блоков
+ *  сшиваются параллельно атомарным объединением корней. Корень
+ *  компоненты — её ячейка с наименьшим индексом, поэтому
+ *  нумерация не зависит от числа потоков. Память — 8 байт на
+ *  занятую ячейку (на время разметки) и бит на ячейку сетки
+ *  под ранги, а не по метке на каждую ячейку.
+ * ========================================================= */
+
+/**
+ * @brief Связность: соседи по граням, граням и рёбрам, или все 26.
+ */
+typedef enum vx_connectivity {
+    VX_CONN_6  = 6,
+    VX_CONN_18 = 18,
+    VX_CONN_26 = 26,
+} vx_connectivity;
+
+/**
+ * @brief Компонента: число ячеек и ограничивающий параллелепипед.
+ */
+typedef struct vx_component {
+    int64_t cells; /**< Занятых ячеек.                           */
+    int     lo[3]; /**< Наименьшие xi, yi, zi ячеек компоненты.  */
+    int     hi[3]; /**< Наибольшие xi, yi, zi (включительно).    */
+} vx_component;
+
+/**
+ * @brief Метки занятых ячеек сетки.
+ *
+ * Занятая ячейка c адресуется рангом — числом занятых ячеек с меньшим
+ * индексом: rank[c / 64] + popcount(слова ниже бита c % 64). Метки
+ * действительны, пока сетка не меняется.
+ */
+typedef struct vx_labels {
+    int32_t      *label;    /**< Номер компоненты (1..count) по рангу ячейки.  */
+    int64_t      *rank;     /**< Занятых ячеек в словах до слова w.             */
+    int64_t       occupied; /**< Занятых ячеек.                                 */
+    vx_component *items;    /**< Компоненты: items[id - 1], по возрастанию
+                                 индекса первой ячейки.                         */
+    int           count;    /**< Число компонент.                               */
+    int           conn;     /**< vx_connectivity.                               */
+} vx_labels;
+
+/**
+ * @brief Размечает связные компоненты занятых ячеек @p b.
+ *
+ * @param l    [out] Метки (прежнее содержимое освобождается).
+ * @param conn VX_CONN_6, VX_CONN_18 или VX_CONN_26.
+ * @param opts Потоки (opts->threads) или NULL — все ядра.
+ * @return Число компонент.
+ */
+int vx_label_components(vx_labels *l, const vxbits *b, vx_connectivity conn,
+                        const vx_bin_opts *opts);
+
+/**
+ * @brief Номер компоненты ячейки @p cell или 0, если она пуста.
+ */
+int32_t vx_label_at(const vx_labels *l, const vxbits *b, int64_t cell);
+
+/**
+ * @brief Убирает из @p b ячейки компонент меньше @p min_cells ячеек.
+ *
+ * Если у @p b есть счётчики, у убранных ячеек они обнуляются.
+ * @p l должны быть построены по этой же @p b; после вызова они
+ * устаревают (vx_labels_free или повторная разметка).
+ *
+ * @param opts Потоки (opts->threads) или NULL — все ядра.
+ * @return Число убранных ячеек.
+ */
+int64_t vx_labels_filter(const vx_labels *l, vxbits *b, int64_t min_cells,
+                         const vx_bin_opts *opts);
+
+/**
+ * @brief Освобождает метки и обнуляет поля.
+ */
+void vx_labels_free(vx_labels *l);
+
+#endif /* VXLABEL_H */
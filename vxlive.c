@@ -0,0 +1,279 @@
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "vxlive.h"
+#include "vxsimd.h"
+
+void vx_live_init(vx_live *l, int nx, int ny, int nz, float voxel_w, Vector3 origin,
+                  int window)
+{
+    *l = (vx_live){0};
+    l->nx       = nx;
+    l->ny       = ny;
+    l->nz       = nz;
+    l->voxel_w  = voxel_w;
+    l->origin   = origin;
+    l->window   = window > 0 ? window : 0;
+    l->capacity = 1024;
+    l->keys       = malloc((size_t)l->capacity * sizeof(int64_t));
+    l->counts     = malloc((size_t)l->capacity * sizeof(int64_t));
+    l->seen       = malloc((size_t)l->capacity * sizeof(uint32_t));
+    l->mark       = malloc((size_t)l->capacity * sizeof(int));
+    l->free_slots = malloc((size_t)l->capacity * sizeof(int));
+    assert(l->keys != NULL && l->counts != NULL && l->seen != NULL && l->mark != NULL &&
+           l->free_slots != NULL);
+    vxhash_init(&l->cells, l->capacity);
+    if (l->window > 0) {
+        l->ring = calloc((size_t)l->window, sizeof(vx_live_frame));
+        assert(l->ring != NULL);
+    }
+}
+
+void vx_live_free(vx_live *l)
+{
+    free(l->keys);
+    free(l->counts);
+    free(l->seen);
+    free(l->mark);
+    free(l->free_slots);
+    free(l->changes);
+    for (int i = 0; i < l->window; i++) {
+        free(l->ring[i].keys);
+        free(l->ring[i].counts);
+    }
+    free(l->ring);
+    vxhash_free(&l->cells);
+    *l = (vx_live){0};
+}
+
+size_t vx_live_bytes(const vx_live *l)
+{
+    size_t per_slot = 2 * sizeof(int64_t) + sizeof(uint32_t) + 2 * sizeof(int);
+    size_t bytes    = (size_t)l->capacity * per_slot +
+                      (size_t)l->cells.capacity * (sizeof(uint64_t) + sizeof(int)) +
+                      (size_t)l->change_cap * sizeof(vx_live_change);
+    for (int i = 0; i < l->window; i++) {
+        bytes += (size_t)l->ring[i].capacity * (sizeof(int64_t) + sizeof(int32_t));
+    }
+    return bytes;
+}
+
+void vx_live_attach_bits(vx_live *l, vxbits *b)
+{
+    l->bits = b;
+    if (b == NULL) return;
+    assert(b->nx == l->nx && b->ny == l->ny && b->nz == l->nz);
+    vxbits_clear(b);
+    for (int s = 0; s < l->slot_count; s++) {
+        if (l->counts[s] > 0) vxbits_set(b, l->keys[s]);
+    }
+}
+
+/* =========================================================
+ *  Слоты и список изменений
+ * ========================================================= */
+
+/* Слот ячейки key; новая ячейка берёт свободный слот или новый в конце */
+static int slot_get(vx_live *l, int64_t key)
+{
+    int slot = l->free_count > 0 ? l->free_slots[l->free_count - 1] : l->slot_count;
+    int s    = vxhash_insert(&l->cells, (uint64_t)key, slot);
+    if (s != slot) return s;
+
+    if (l->free_count > 0) {
+        l->free_count--;
+    } else {
+        if (l->slot_count == l->capacity) {
+            l->capacity *= 2;
+            l->keys       = realloc(l->keys, (size_t)l->capacity * sizeof(int64_t));
+            l->counts     = realloc(l->counts, (size_t)l->capacity * sizeof(int64_t));
+            l->seen       = realloc(l->seen, (size_t)l->capacity * sizeof(uint32_t));
+            l->mark       = realloc(l->mark, (size_t)l->capacity * sizeof(int));
+            l->free_slots = realloc(l->free_slots, (size_t)l->capacity * sizeof(int));
+            assert(l->keys != NULL && l->counts != NULL && l->seen != NULL &&
+                   l->mark != NULL && l->free_slots != NULL);
+        }
+        l->slot_count++;
+    }
+    l->keys[slot]   = key;
+    l->counts[slot] = 0;
+    l->seen[slot]   = l->frame;
+    l->mark[slot]   = -1;
+    return slot;
+}
+
+/* Первое касание слота за обновление заводит запись изменения */
+static vx_live_change *touch(vx_live *l, int slot)
+{
+    if (l->mark[slot] < 0) {
+        if (l->change_count == l->change_cap) {
+            l->change_cap = l->change_cap == 0 ? 1024 : l->change_cap * 2;
+            l->changes    = realloc(l->changes, (size_t)l->change_cap * sizeof(vx_live_change));
+            assert(l->changes != NULL);
+        }
+        l->changes[l->change_count] = (vx_live_change){
+            .key = l->keys[slot], .before = l->counts[slot], .slot = slot};
+        l->mark[slot] = l->change_count++;
+    }
+    return &l->changes[l->mark[slot]];
+}
+
+static void cell_add(vx_live *l, int64_t key, int n)
+{
+    int             slot = slot_get(l, key);
+    vx_live_change *ch   = touch(l, slot);
+    if (l->counts[slot] == 0) {
+        l->occupied++;
+        if (l->bits) vxbits_set(l->bits, key);
+    }
+    l->counts[slot] += n;
+    l->seen[slot]    = l->frame;
+    l->point_count  += n;
+    ch->after        = l->counts[slot];
+}
+
+/* Убирает до n вершин ячейки; слот остаётся до следующего vx_live_begin */
+static int64_t cell_sub(vx_live *l, int64_t key, int64_t n)
+{
+    int slot = vxhash_find(&l->cells, (uint64_t)key);
+    if (slot < 0 || l->counts[slot] == 0) return 0;
+
+    vx_live_change *ch   = touch(l, slot);
+    int64_t         take = n < l->counts[slot] ? n : l->counts[slot];
+    l->counts[slot] -= take;
+    l->point_count  -= take;
+    if (l->counts[slot] == 0) {
+        l->occupied--;
+        if (l->bits) vxbits_reset(l->bits, key);
+    }
+    ch->after = l->counts[slot];
+    return take;
+}
+
+void vx_live_begin(vx_live *l)
+{
+    for (int i = 0; i < l->change_count; i++) {
+        int slot = l->changes[i].slot;
+        l->mark[slot] = -1;
+        if (l->counts[slot] == 0) {
+            vxhash_remove(&l->cells, (uint64_t)l->keys[slot]);
+            l->free_slots[l->free_count++] = slot;
+        }
+    }
+    l->change_count = 0;
+}
+
+static void frame_append(vx_live_frame *f, int64_t key, int n)
+{
+    if (f->count == f->capacity) {
+        f->capacity = f->capacity == 0 ? 1024 : f->capacity * 2;
+        f->keys     = realloc(f->keys, (size_t)f->capacity * sizeof(int64_t));
+        f->counts   = realloc(f->counts, (size_t)f->capacity * sizeof(int32_t));
+        assert(f->keys != NULL && f->counts != NULL);
+    }
+    f->keys[f->count]   = key;
+    f->counts[f->count] = n;
+    f->count++;
+}
+
+/* =========================================================
+ *  Добавление и удаление
+ *  Подряд идущие вершины кадра обычно лежат в одной ячейке,
+ *  поэтому ячейка ищется в хеше один раз на серию; серия же
+ *  становится записью кадра окна.
+ * ========================================================= */
+static void insert_points(vx_live *l, const Vector3 *v, int count, vx_live_frame *rec)
+{
+    vx_quant q    = {.inv_w = 1.0f / l->voxel_w, .nx = l->nx, .ny = l->ny, .nz = l->nz};
+    int64_t  key[VX_LIVE_BLOCK];
+    int64_t  last = -1;
+    int      run  = 0;
+
+    for (int i = 0; i < count; i += VX_LIVE_BLOCK) {
+        int n = count - i < VX_LIVE_BLOCK ? count - i : VX_LIVE_BLOCK;
+        vx_quantize_keys_aos(v + i, n, &q, key);
+
+        for (int k = 0; k < n; k++) {
+            if (key[k] != last && run > 0) {
+                cell_add(l, last, run);
+                if (rec) frame_append(rec, last, run);
+                run = 0;
+            }
+            last = key[k];
+            run++;
+        }
+    }
+    if (run > 0) {
+        cell_add(l, last, run);
+        if (rec) frame_append(rec, last, run);
+    }
+}
+
+void vx_live_insert(vx_live *l, const Vector3 *v, int count)
+{
+    insert_points(l, v, count, NULL);
+}
+
+int64_t vx_live_remove(vx_live *l, const Vector3 *v, int count)
+{
+    vx_quant q       = {.inv_w = 1.0f / l->voxel_w, .nx = l->nx, .ny = l->ny, .nz = l->nz};
+    int64_t  key[VX_LIVE_BLOCK];
+    int64_t  last    = -1;
+    int64_t  run     = 0;
+    int64_t  removed = 0;
+
+    for (int i = 0; i < count; i += VX_LIVE_BLOCK) {
+        int n = count - i < VX_LIVE_BLOCK ? count - i : VX_LIVE_BLOCK;
+        vx_quantize_keys_aos(v + i, n, &q, key);
+
+        for (int k = 0; k < n; k++) {
+            if (key[k] != last && run > 0) {
+                removed += cell_sub(l, last, run);
+                run = 0;
+            }
+            last = key[k];
+            run++;
+        }
+    }
+    if (run > 0) removed += cell_sub(l, last, run);
+    return removed;
+}
+
+void vx_live_push(vx_live *l, const Vector3 *v, int count)
+{
+    vx_live_begin(l);
+    l->frame++;
+
+    vx_live_frame *rec = NULL;
+    if (l->window > 0) {
+        rec = &l->ring[(l->frame - 1) % (uint32_t)l->window];
+        if (l->held == l->window) {
+            for (int i = 0; i < rec->count; i++) cell_sub(l, rec->keys[i], rec->counts[i]);
+        } else {
+            l->held++;
+        }
+        rec->count = 0;
+    }
+    insert_points(l, v, count, rec);
+}
+
+/* =========================================================
+ *  Запросы
+ * ========================================================= */
+int64_t vx_live_count(const vx_live *l, int64_t key)
+{
+    int slot = vxhash_find(&l->cells, (uint64_t)key);
+    return slot < 0 ? 0 : l->counts[slot];
+}
+
+int64_t vx_live_age(const vx_live *l, int64_t key)
+{
+    int slot = vxhash_find(&l->cells, (uint64_t)key);
+    if (slot < 0 || l->counts[slot] == 0) return -1;
+    return (int64_t)(l->frame - l->seen[slot]);
+}
+
+int vx_live_sorted(const vx_live *l, int **order)
+{
+    return vx_keyed_sorted(l->keys, l->counts, l->slot_count, 1, order);
+}
@@ -0,0 +1,171 @@
+#ifndef VXLIVE_H
+#define VXLIVE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "voxel.h"
+#include "vxbits.h"
+
+/* =========================================================
+ *  Инкрементная сетка для потока кадров
+ *
+ *  vxlist перестраивается целиком (freeContainer +
+ *  create_mesh + ind_finder), и кадр стоит O(всех вершин).
+ *  Здесь у занятой ячейки только счётчик вершин и номер
+ *  кадра, когда в неё последний раз попадали; вершины
+ *  добавляются и убираются пачками за O(пачки). Каждое
+ *  обновление собирает список изменившихся ячеек — по нему
+ *  потребители (отрисовка, битовая сетка) обновляют только
+ *  их. Скользящее окно хранит, сколько вершин каждый кадр
+ *  положил в каждую ячейку, и убирает их, когда кадр
+ *  выходит из окна.
+ * ========================================================= */
+
+/** Вершин на один вызов ядра квантования. */
+#define VX_LIVE_BLOCK 512
+
+/**
+ * @brief Изменение ячейки за обновление.
+ */
+typedef struct vx_live_change {
+    int64_t key;    /**< Линейный индекс zi·(nx·ny) + yi·nx + xi.          */
+    int64_t before; /**< Вершин в ячейке до обновления.                    */
+    int64_t after;  /**< Вершин после (0 — ячейка опустела).               */
+    int     slot;   /**< Номер ячейки в массивах vx_live (до vx_live_begin). */
+} vx_live_change;
+
+/**
+ * @brief Вклад одного кадра окна: сколько вершин в какие ячейки.
+ */
+typedef struct vx_live_frame {
+    int64_t *keys;     /**< Ячейки (подряд идущие вершины одной ячейки — одна запись). */
+    int32_t *counts;   /**< Вершин кадра в ячейке.                                    */
+    int      count;    /**< Записей.                                                  */
+    int      capacity; /**< Вместимость (буфер переиспользуется следующими кадрами).  */
+} vx_live_frame;
+
+/**
+ * @brief Занятые ячейки с пачечным добавлением и удалением вершин.
+ *
+ * Ячейки лежат в параллельных массивах keys / counts / seen по
+ * номерам (слотам); cells — поиск слота по линейному индексу.
+ * Слоты опустевших ячеек освобождаются в начале следующего
+ * обновления и переиспользуются, поэтому память растёт с числом
+ * ячеек, занятых одновременно, а не за всё время.
+ */
+typedef struct vx_live {
+    int64_t        *keys;         /**< Линейный индекс ячейки слота.                  */
+    int64_t        *counts;       /**< Вершин в ячейке (0 — слот свободен или пуст).  */
+    uint32_t       *seen;         /**< Кадр, в котором в ячейку последний раз попали. */
+    int            *mark;         /**< Номер записи в changes или -1.                 */
+    int            *free_slots;   /**< Стек свободных слотов.                         */
+    int             free_count;   /**< Свободных слотов.                              */
+    int             slot_count;   /**< Слотов в ходу (занятые + свободные).           */
+    int             capacity;     /**< Вместимость массивов слотов.                   */
+    int             occupied;     /**< Ячеек с counts > 0.                            */
+    vxhash          cells;        /**< Линейный индекс -> слот.                       */
+
+    vx_live_change *changes;      /**< Изменившиеся ячейки текущего обновления.       */
+    int             change_count; /**< Длина changes.                                 */
+    int             change_cap;   /**< Вместимость changes.                           */
+
+    vx_live_frame  *ring;         /**< Кадры окна, кольцом.                           */
+    int             window;       /**< Кадров в окне; 0 — вершины не стареют.         */
+    int             held;         /**< Кадров сейчас в окне.                          */
+    uint32_t        frame;        /**< Номер текущего кадра (с 1 после первого push). */
+
+    vxbits         *bits;         /**< Занятость ячеек (vx_live_attach_bits) или NULL. */
+    int             nx;           /**< Ячеек вдоль X.                                 */
+    int             ny;           /**< Ячеек вдоль Y.                                 */
+    int             nz;           /**< Ячеек вдоль Z.                                 */
+    float           voxel_w;      /**< Длина ребра ячейки.                            */
+    Vector3         origin;       /**< Угол сетки (как у create_sparse_mesh).         */
+    int64_t         point_count;  /**< Вершин в сетке сейчас.                         */
+} vx_live;
+
+/**
+ * @brief Создаёт пустую сетку.
+ *
+ * @param window Кадров в скользящем окне vx_live_push; 0 — без окна.
+ */
+void vx_live_init(vx_live *l, int nx, int ny, int nz, float voxel_w, Vector3 origin,
+                  int window);
+
+/**
+ * @brief Освобождает память сетки и обнуляет её поля (bits не освобождается).
+ */
+void vx_live_free(vx_live *l);
+
+/**
+ * @brief Байт памяти, занятых сеткой (без bits).
+ */
+size_t vx_live_bytes(const vx_live *l);
+
+/**
+ * @brief Поддерживать битовую сетку занятости @p b вместе с ячейками.
+ *
+ * @p b размеров nx × ny × nz заполняется текущими ячейками, дальше
+ * её биты меняются только при переходах ячейки между 0 и не 0.
+ * NULL — отключить.
+ */
+void vx_live_attach_bits(vx_live *l, vxbits *b);
+
+/**
+ * @brief Начинает обновление: очищает список изменений.
+ *
+ * Слоты ячеек, опустевших в прошлом обновлении, освобождаются.
+ * vx_live_insert и vx_live_remove без vx_live_begin дописывают
+ * изменения к текущему списку.
+ */
+void vx_live_begin(vx_live *l);
+
+/**
+ * @brief Добавляет нормализованные вершины.
+ *
+ * Квантование то же, что в ind_finder (vx_quantize, ребро voxel_w от
+ * нуля нормализованных координат): сетка из тех же вершин даёт те же
+ * count вокселей. Номер кадра ячейки (seen) становится текущим.
+ */
+void vx_live_insert(vx_live *l, const Vector3 *v, int count);
+
+/**
+ * @brief Убирает ранее добавленные вершины.
+ *
+ * Вершины квантуются так же, как при добавлении; вершина, чья ячейка
+ * уже пуста, пропускается.
+ *
+ * @return Число убранных вершин.
+ */
+int64_t vx_live_remove(vx_live *l, const Vector3 *v, int count);
+
+/**
+ * @brief Следующий кадр потока: vx_live_begin, затем добавление кадра.
+ *
+ * С окном кадр, вышедший из последних l->window, сначала убирается
+ * целиком — по его записям, а не по вершинам. Стоимость —
+ * O(вершин кадра + записей убранного кадра).
+ */
+void vx_live_push(vx_live *l, const Vector3 *v, int count);
+
+/**
+ * @brief Вершин в ячейке с линейным индексом @p key (0 — пуста).
+ */
+int64_t vx_live_count(const vx_live *l, int64_t key);
+
+/**
+ * @brief Кадров с последнего попадания в ячейку или -1, если она пуста.
+ */
+int64_t vx_live_age(const vx_live *l, int64_t key);
+
+/**
+ * @brief Номера слотов занятых ячеек по возрастанию ключа.
+ *
+ * Для полной выгрузки (первый кадр потребителя, запись файла);
+ * между кадрами достаточно l->changes.
+ *
+ * @param order [out] Массив номеров (освобождать free).
+ * @return Длина массива.
+ */
+int vx_live_sorted(const vx_live *l, int **order);
+
+#endif /* VXLIVE_H */
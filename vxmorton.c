@@ -0,0 +1,250 @@
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "vxmorton.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define VX_HAVE_X86 1
+#include <immintrin.h>
+#endif
+
+/* Маски битов осей в 64-битном коде */
+#define VX_MORTON_MASK_X 0x1249249249249249ull
+#define VX_MORTON_MASK_Y 0x2492492492492492ull
+#define VX_MORTON_MASK_Z 0x4924924924924924ull
+
+/* Разряд поразрядной сортировки, бит */
+#define VX_MORTON_RADIX 11
+
+/* Байт координаты -> его биты через два на третий (бит i -> бит 3i) */
+static const uint32_t spread8[256] = {
+    0x000000, 0x000001, 0x000008, 0x000009, 0x000040, 0x000041, 0x000048, 0x000049,
+    0x000200, 0x000201, 0x000208, 0x000209, 0x000240, 0x000241, 0x000248, 0x000249,
+    0x001000, 0x001001, 0x001008, 0x001009, 0x001040, 0x001041, 0x001048, 0x001049,
+    0x001200, 0x001201, 0x001208, 0x001209, 0x001240, 0x001241, 0x001248, 0x001249,
+    0x008000, 0x008001, 0x008008, 0x008009, 0x008040, 0x008041, 0x008048, 0x008049,
+    0x008200, 0x008201, 0x008208, 0x008209, 0x008240, 0x008241, 0x008248, 0x008249,
+    0x009000, 0x009001, 0x009008, 0x009009, 0x009040, 0x009041, 0x009048, 0x009049,
+    0x009200, 0x009201, 0x009208, 0x009209, 0x009240, 0x009241, 0x009248, 0x009249,
+    0x040000, 0x040001, 0x040008, 0x040009, 0x040040, 0x040041, 0x040048, 0x040049,
+    0x040200, 0x040201, 0x040208, 0x040209, 0x040240, 0x040241, 0x040248, 0x040249,
+    0x041000, 0x041001, 0x041008, 0x041009, 0x041040, 0x041041, 0x041048, 0x041049,
+    0x041200, 0x041201, 0x041208, 0x041209, 0x041240, 0x041241, 0x041248, 0x041249,
+    0x048000, 0x048001, 0x048008, 0x048009, 0x048040, 0x048041, 0x048048, 0x048049,
+    0x048200, 0x048201, 0x048208, 0x048209, 0x048240, 0x048241, 0x048248, 0x048249,
+    0x049000, 0x049001, 0x049008, 0x049009, 0x049040, 0x049041, 0x049048, 0x049049,
+    0x049200, 0x049201, 0x049208, 0x049209, 0x049240, 0x049241, 0x049248, 0x049249,
+    0x200000, 0x200001, 0x200008, 0x200009, 0x200040, 0x200041, 0x200048, 0x200049,
+    0x200200, 0x200201, 0x200208, 0x200209, 0x200240, 0x200241, 0x200248, 0x200249,
+    0x201000, 0x201001, 0x201008, 0x201009, 0x201040, 0x201041, 0x201048, 0x201049,
+    0x201200, 0x201201, 0x201208, 0x201209, 0x201240, 0x201241, 0x201248, 0x201249,
+    0x208000, 0x208001, 0x208008, 0x208009, 0x208040, 0x208041, 0x208048, 0x208049,
+    0x208200, 0x208201, 0x208208, 0x208209, 0x208240, 0x208241, 0x208248, 0x208249,
+    0x209000, 0x209001, 0x209008, 0x209009, 0x209040, 0x209041, 0x209048, 0x209049,
+    0x209200, 0x209201, 0x209208, 0x209209, 0x209240, 0x209241, 0x209248, 0x209249,
+    0x240000, 0x240001, 0x240008, 0x240009, 0x240040, 0x240041, 0x240048, 0x240049,
+    0x240200, 0x240201, 0x240208, 0x240209, 0x240240, 0x240241, 0x240248, 0x240249,
+    0x241000, 0x241001, 0x241008, 0x241009, 0x241040, 0x241041, 0x241048, 0x241049,
+    0x241200, 0x241201, 0x241208, 0x241209, 0x241240, 0x241241, 0x241248, 0x241249,
+    0x248000, 0x248001, 0x248008, 0x248009, 0x248040, 0x248041, 0x248048, 0x248049,
+    0x248200, 0x248201, 0x248208, 0x248209, 0x248240, 0x248241, 0x248248, 0x248249,
+    0x249000, 0x249001, 0x249008, 0x249009, 0x249040, 0x249041, 0x249048, 0x249049,
+    0x249200, 0x249201, 0x249208, 0x249209, 0x249240, 0x249241, 0x249248, 0x249249,
+};
+
+/* =========================================================
+ *  Табличная реализация
+ * ========================================================= */
+static uint64_t spread_table(uint32_t v)
+{
+    return (uint64_t)spread8[v & 0xff] |
+           (uint64_t)spread8[(v >> 8) & 0xff] << 24 |
+           (uint64_t)spread8[(v >> 16) & 0x1f] << 48;
+}
+
+static uint64_t encode_table(uint32_t x, uint32_t y, uint32_t z)
+{
+    return spread_table(x) | spread_table(y) << 1 | spread_table(z) << 2;
+}
+
+/* Обратное к spread: биты 0, 3, 6, ... -> биты 0, 1, 2, ... */
+static uint32_t compact_bits(uint64_t v)
+{
+    v &= VX_MORTON_MASK_X;
+    v = (v ^ (v >> 2))  & 0x10c30c30c30c30c3ull;
+    v = (v ^ (v >> 4))  & 0x100f00f00f00f00full;
+    v = (v ^ (v >> 8))  & 0x1f0000ff0000ffull;
+    v = (v ^ (v >> 16)) & 0x1f00000000ffffull;
+    v = (v ^ (v >> 32)) & 0x1fffffull;
+    return (uint32_t)v;
+}
+
+static void cells_table(const Vector3 *v, int n, const vx_quant *q, uint64_t *out)
+{
+    for (int i = 0; i < n; i++) {
+        out[i] = encode_table((uint32_t)vx_quantize_axis(v[i].x, q->inv_w, q->nx),
+                              (uint32_t)vx_quantize_axis(v[i].y, q->inv_w, q->ny),
+                              (uint32_t)vx_quantize_axis(v[i].z, q->inv_w, q->nz));
+    }
+}
+
+/* =========================================================
+ *  BMI2
+ * ========================================================= */
+#if defined(VX_HAVE_X86) && defined(__x86_64__)
+#define VX_HAVE_BMI2 1
+
+__attribute__((target("bmi2")))
+static uint64_t encode_bmi2(uint32_t x, uint32_t y, uint32_t z)
+{
+    return _pdep_u64(x, VX_MORTON_MASK_X) | _pdep_u64(y, VX_MORTON_MASK_Y) |
+           _pdep_u64(z, VX_MORTON_MASK_Z);
+}
+
+__attribute__((target("bmi2")))
+static void decode_bmi2(uint64_t code, uint32_t *x, uint32_t *y, uint32_t *z)
+{
+    *x = (uint32_t)_pext_u64(code, VX_MORTON_MASK_X);
+    *y = (uint32_t)_pext_u64(code, VX_MORTON_MASK_Y);
+    *z = (uint32_t)_pext_u64(code, VX_MORTON_MASK_Z);
+}
+
+__attribute__((target("bmi2")))
+static void cells_bmi2(const Vector3 *v, int n, const vx_quant *q, uint64_t *out)
+{
+    for (int i = 0; i < n; i++) {
+        out[i] = _pdep_u64((uint32_t)vx_quantize_axis(v[i].x, q->inv_w, q->nx), VX_MORTON_MASK_X) |
+                 _pdep_u64((uint32_t)vx_quantize_axis(v[i].y, q->inv_w, q->ny), VX_MORTON_MASK_Y) |
+                 _pdep_u64((uint32_t)vx_quantize_axis(v[i].z, q->inv_w, q->nz), VX_MORTON_MASK_Z);
+    }
+}
+#endif
+
+/* =========================================================
+ *  Диспетчеризация (как в vxsimd.c: гонка первого вызова
+ *  безвредна)
+ * ========================================================= */
+static int morton_level = -1;
+
+static vx_morton_impl detect_impl(void)
+{
+#ifdef VX_HAVE_BMI2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("bmi2") &&
+        !__builtin_cpu_is("znver1") && !__builtin_cpu_is("znver2")) return VX_MORTON_BMI2;
+#endif
+    return VX_MORTON_TABLE;
+}
+
+vx_morton_impl vx_morton_level(void)
+{
+    if (morton_level < 0) morton_level = detect_impl();
+    return (vx_morton_impl)morton_level;
+}
+
+void vx_morton_force(vx_morton_impl impl)
+{
+    bool bmi2 = false;
+#ifdef VX_HAVE_BMI2
+    __builtin_cpu_init();
+    bmi2 = __builtin_cpu_supports("bmi2");
+#endif
+    morton_level = impl == VX_MORTON_BMI2 && bmi2 ? VX_MORTON_BMI2 : VX_MORTON_TABLE;
+}
+
+const char *vx_morton_name(vx_morton_impl impl)
+{
+    return impl == VX_MORTON_BMI2 ? "bmi2" : "table";
+}
+
+uint64_t vx_morton_encode(uint32_t xi, uint32_t yi, uint32_t zi)
+{
+#ifdef VX_HAVE_BMI2
+    if (vx_morton_level() == VX_MORTON_BMI2) return encode_bmi2(xi, yi, zi);
+#endif
+    return encode_table(xi, yi, zi);
+}
+
+void vx_morton_decode(uint64_t code, uint32_t *xi, uint32_t *yi, uint32_t *zi)
+{
+#ifdef VX_HAVE_BMI2
+    if (vx_morton_level() == VX_MORTON_BMI2) {
+        decode_bmi2(code, xi, yi, zi);
+        return;
+    }
+#endif
+    *xi = compact_bits(code);
+    *yi = compact_bits(code >> 1);
+    *zi = compact_bits(code >> 2);
+}
+
+void vx_morton_cells(const Vector3 *v, int n, const vx_quant *q, uint64_t *out)
+{
+#ifdef VX_HAVE_BMI2
+    if (vx_morton_level() == VX_MORTON_BMI2) {
+        cells_bmi2(v, n, q, out);
+        return;
+    }
+#endif
+    cells_table(v, n, q, out);
+}
+
+/* =========================================================
+ *  vx_morton_sort
+ *  Ключи и номера вершин сортируются парами, вершины
+ *  переставляются один раз в конце.
+ * ========================================================= */
+void vx_morton_sort(Vector3 *v, int n, const vx_quant *q)
+{
+    if (n < 2) return;
+
+    uint64_t *key  = malloc((size_t)n * sizeof(uint64_t));
+    uint64_t *key2 = malloc((size_t)n * sizeof(uint64_t));
+    int32_t  *idx  = malloc((size_t)n * sizeof(int32_t));
+    int32_t  *idx2 = malloc((size_t)n * sizeof(int32_t));
+    assert(key != NULL && key2 != NULL && idx != NULL && idx2 != NULL);
+
+    vx_morton_cells(v, n, q, key);
+    for (int i = 0; i < n; i++) idx[i] = i;
+
+    /* Старший значащий бит кода — у угла сетки (nx-1, ny-1, nz-1) */
+    uint64_t top  = vx_morton_encode((uint32_t)q->nx - 1, (uint32_t)q->ny - 1, (uint32_t)q->nz - 1);
+    int      bits = 0;
+    while (bits < 64 && (top >> bits) != 0) bits++;
+
+    int *count = malloc(sizeof(int) << VX_MORTON_RADIX);
+    assert(count != NULL);
+
+    for (int shift = 0; shift < bits; shift += VX_MORTON_RADIX) {
+        uint64_t mask = (1u << VX_MORTON_RADIX) - 1;
+        memset(count, 0, sizeof(int) << VX_MORTON_RADIX);
+        for (int i = 0; i < n; i++) count[(key[i] >> shift) & mask]++;
+        if (count[(key[0] >> shift) & mask] == n) continue; /* разряд у всех одинаков */
+
+        int sum = 0;
+        for (int d = 0; d < (1 << VX_MORTON_RADIX); d++) {
+            int c = count[d];
+            count[d] = sum;
+            sum += c;
+        }
+        for (int i = 0; i < n; i++) {
+            int pos   = count[(key[i] >> shift) & mask]++;
+            key2[pos] = key[i];
+            idx2[pos] = idx[i];
+        }
+        uint64_t *tk = key; key = key2; key2 = tk;
+        int32_t  *ti = idx; idx = idx2; idx2 = ti;
+    }
+    free(count);
+    free(key);
+    free(key2);
+    free(idx2);
+
+    Vector3 *sorted = malloc((size_t)n * sizeof(Vector3));
+    assert(sorted != NULL);
+    for (int i = 0; i < n; i++) sorted[i] = v[idx[i]];
+    memcpy(v, sorted, (size_t)n * sizeof(Vector3));
+
+    free(sorted);
+    free(idx);
+}
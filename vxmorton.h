@@ -0,0 +1,104 @@
+#ifndef VXMORTON_H
+#define VXMORTON_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "voxel.h"
+#include "vxsimd.h"
+
+/* =========================================================
+ *  Порядок Мортона (Z-кривая)
+ *
+ *  Код ячейки — чередование битов xi, yi, zi: ...z1y1x1z0y0x0.
+ *  Ячейки, соседние по любой оси, в среднем близки и в коде,
+ *  поэтому и воксели, и вершины, упорядоченные по коду, лежат
+ *  в памяти пространственно связными группами.
+ *
+ *  Кодирование — BMI2 pdep, если процессор его поддерживает
+ *  (и выполняет быстро), иначе по таблице на 256 значений.
+ * ========================================================= */
+
+/** Бит на ось в 64-битном коде. */
+#define VX_MORTON_BITS 21
+
+/**
+ * @brief Реализация кодирования.
+ */
+typedef enum {
+    VX_MORTON_TABLE = 0, /**< Таблица на байт координаты.       */
+    VX_MORTON_BMI2  = 1, /**< Инструкции pdep / pext (BMI2).     */
+} vx_morton_impl;
+
+/**
+ * @brief Реализация, выбранная при первом обращении.
+ *
+ * BMI2 не выбирается на AMD Zen 1/2, где pdep микрокодирован и
+ * медленнее таблицы.
+ */
+vx_morton_impl vx_morton_level(void);
+
+/**
+ * @brief Принудительно задаёт реализацию (BMI2 — только если поддерживается).
+ */
+void vx_morton_force(vx_morton_impl impl);
+
+/**
+ * @brief Имя реализации ("bmi2", "table").
+ */
+const char *vx_morton_name(vx_morton_impl impl);
+
+/**
+ * @brief Код Мортона ячейки (xi, yi, zi), каждая координата < 2^21.
+ */
+uint64_t vx_morton_encode(uint32_t xi, uint32_t yi, uint32_t zi);
+
+/**
+ * @brief Координаты ячейки по коду Мортона.
+ */
+void vx_morton_decode(uint64_t code, uint32_t *xi, uint32_t *yi, uint32_t *zi);
+
+/**
+ * @brief Код соседней ячейки: шаг ±1 по оси без декодирования.
+ *
+ * Сложение в «прореженных» битах одной оси: биты других осей
+ * заполняются единицами, чтобы перенос проходил сквозь них.
+ * Выход за границу сетки не проверяется.
+ *
+ * @param code Код ячейки.
+ * @param axis Ось: 0 — X, 1 — Y, 2 — Z.
+ * @param dir  +1 или -1.
+ */
+static inline uint64_t vx_morton_step(uint64_t code, int axis, int dir)
+{
+    uint64_t mask = 0x1249249249249249ull << axis;
+    uint64_t one  = (uint64_t)1 << axis;
+    uint64_t a    = dir > 0 ? ((code | ~mask) + one) & mask : ((code & mask) - one) & mask;
+    return a | (code & ~mask);
+}
+
+/**
+ * @brief Коды Мортона ячеек, в которые попадают вершины.
+ *
+ * Квантование то же, что у vx_quantize: trunc(clamp(v · inv_w, 0, n - 1)).
+ *
+ * @param v   Вершины (n штук).
+ * @param q   Параметры квантования.
+ * @param out [out] Коды, n штук.
+ */
+void vx_morton_cells(const Vector3 *v, int n, const vx_quant *q, uint64_t *out);
+
+/**
+ * @brief Переставляет вершины по возрастанию кода Мортона их ячеек.
+ *
+ * Поразрядная (LSD) устойчивая сортировка по 11 бит за проход;
+ * проходов — по числу значащих бит кода (3 для сетки 1024³),
+ * проходы с одним непустым разрядом пропускаются. Вершины одной
+ * ячейки сохраняют исходный порядок.
+ *
+ * @param v Вершины; переставляются на месте.
+ * @param n Их количество.
+ * @param q Сетка, по ячейкам которой идёт упорядочение.
+ */
+void vx_morton_sort(Vector3 *v, int n, const vx_quant *q);
+
+#endif /* VXMORTON_H */
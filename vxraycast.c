@@ -0,0 +1,341 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include "vxraycast.h"
+#include "vxsys.h"
+
+void vx_image_init(vx_image *img, int width, int height)
+{
+    size_t bytes = (size_t)(width > 0 ? width : 1) * (height > 0 ? height : 1) * 4;
+    img->pixels = calloc(bytes, 1);
+    assert(img->pixels != NULL);
+    img->width  = width;
+    img->height = height;
+}
+
+void vx_image_free(vx_image *img)
+{
+    free(img->pixels);
+    *img = (vx_image){0};
+}
+
+vx_status vx_image_write_ppm(const vx_image *img, const char *filename, vx_error *err)
+{
+    FILE *f = fopen(filename, "wb");
+    if (f == NULL) return vx_fail(err, VX_ERR_OPEN, "Не удалось создать %s", filename);
+    fprintf(f, "P6\n%d %d\n255\n", img->width, img->height);
+
+    uint8_t *row = malloc((size_t)(img->width > 0 ? img->width : 1) * 3);
+    assert(row != NULL);
+    bool ok = true;
+    for (int y = 0; y < img->height && ok; y++) {
+        const uint8_t *p = img->pixels + (size_t)y * img->width * 4;
+        for (int x = 0; x < img->width; x++) {
+            row[3 * x + 0] = p[4 * x + 0];
+            row[3 * x + 1] = p[4 * x + 1];
+            row[3 * x + 2] = p[4 * x + 2];
+        }
+        ok = fwrite(row, 3, (size_t)img->width, f) == (size_t)img->width;
+    }
+    free(row);
+    if (fclose(f) != 0 || !ok) return vx_fail(err, VX_ERR_WRITE, "Ошибка записи %s", filename);
+    return VX_OK;
+}
+
+/* =========================================================
+ *  Пирамида занятости
+ *  Бит блока ставится по первой занятой ячейке блока в строке;
+ *  остаток блока в этой строке перешагивается, поэтому уровень
+ *  строится за O(слов + строк · блоков в строке) даже для
+ *  сплошных тел.
+ * ========================================================= */
+static void build_level(vxbits *dst, const vxbits *src)
+{
+    vxbits_init(dst, (src->nx + VX_RAY_BLOCK - 1) / VX_RAY_BLOCK,
+                (src->ny + VX_RAY_BLOCK - 1) / VX_RAY_BLOCK,
+                (src->nz + VX_RAY_BLOCK - 1) / VX_RAY_BLOCK, false);
+
+    for (int64_t c = vxbits_next(src, 0); c >= 0; c = vxbits_next(src, c)) {
+        int64_t row = c / src->nx;
+        int     x   = (int)(c - row * src->nx);
+        int     y   = (int)(row % src->ny);
+        int     z   = (int)(row / src->ny);
+        vxbits_set(dst, vxbits_cell(dst, x / VX_RAY_BLOCK, y / VX_RAY_BLOCK, z / VX_RAY_BLOCK));
+
+        int next_x = (x / VX_RAY_BLOCK + 1) * VX_RAY_BLOCK;
+        c += (next_x < src->nx ? next_x : src->nx) - x;
+    }
+}
+
+void vx_raygrid_init(vx_raygrid *g, const vxbits *cells, Vector3 origin, float voxel_w)
+{
+    memset(g, 0, sizeof(*g));
+    g->cells   = cells;
+    g->origin  = origin;
+    g->voxel_w = voxel_w;
+    g->levels  = 1;
+
+    const vxbits *top = cells;
+    while (g->levels < VX_RAY_MAX_LEVELS &&
+           (top->nx > VX_RAY_BLOCK || top->ny > VX_RAY_BLOCK || top->nz > VX_RAY_BLOCK)) {
+        build_level(&g->coarse[g->levels], top);
+        top = &g->coarse[g->levels];
+        g->levels++;
+    }
+}
+
+void vx_raygrid_free(vx_raygrid *g)
+{
+    for (int k = 1; k < g->levels; k++) vxbits_free(&g->coarse[k]);
+    memset(g, 0, sizeof(*g));
+}
+
+/* =========================================================
+ *  Обход луча
+ *  march идёт 3D-DDA по ячейкам одного уровня внутри диапазона
+ *  [lo, hi) от t до t_end. В занятом блоке он спускается на
+ *  уровень ниже — в те же 8×8×8 ячеек и на отрезок луча внутри
+ *  блока; пустые блоки проходятся за один шаг. Координаты луча —
+ *  в ячейках уровня 0, ячейка уровня k — куб со стороной size = 8^k.
+ * ========================================================= */
+typedef struct {
+    float   o[3];    /* начало луча, ячейки уровня 0   */
+    float   d[3];    /* направление в тех же единицах  */
+    float   inv[3];  /* 1 / d или INFINITY при d = 0   */
+    int     step[3]; /* ±1                             */
+    int64_t steps;   /* шагов DDA на всех уровнях      */
+} ray;
+
+static const vxbits *level_bits(const vx_raygrid *g, int level)
+{
+    return level == 0 ? g->cells : &g->coarse[level];
+}
+
+static bool march(const vx_raygrid *g, ray *r, int level, float size, const int lo[3],
+                  const int hi[3], float t, float t_end, int *axis)
+{
+    const vxbits *b = level_bits(g, level);
+    int   c[3];
+    float tmax[3], tdelta[3];
+
+    for (int a = 0; a < 3; a++) {
+        int ci = (int)floorf((r->o[a] + r->d[a] * t) / size);
+        c[a]   = ci < lo[a] ? lo[a] : ci >= hi[a] ? hi[a] - 1 : ci;
+        if (r->d[a] == 0.0f) {
+            tmax[a]   = INFINITY;
+            tdelta[a] = INFINITY;
+        } else {
+            float edge = (float)(c[a] + (r->step[a] > 0)) * size;
+            tmax[a]    = (edge - r->o[a]) * r->inv[a];
+            tdelta[a]  = size * fabsf(r->inv[a]);
+        }
+    }
+
+    for (;;) {
+        r->steps++;
+        int   a      = tmax[0] < tmax[1] ? (tmax[0] < tmax[2] ? 0 : 2) : (tmax[1] < tmax[2] ? 1 : 2);
+        float t_next = tmax[a];
+
+        if (vxbits_test(b, vxbits_cell(b, c[0], c[1], c[2]))) {
+            if (level == 0) return true;
+
+            const vxbits *below = level_bits(g, level - 1);
+            int dims[3] = {below->nx, below->ny, below->nz};
+            int clo[3], chi[3];
+            for (int k = 0; k < 3; k++) {
+                clo[k] = c[k] * VX_RAY_BLOCK;
+                chi[k] = clo[k] + VX_RAY_BLOCK < dims[k] ? clo[k] + VX_RAY_BLOCK : dims[k];
+            }
+            int sub = *axis;
+            if (march(g, r, level - 1, size / VX_RAY_BLOCK, clo, chi, t,
+                      t_next < t_end ? t_next : t_end, &sub)) {
+                *axis = sub;
+                return true;
+            }
+        }
+
+        if (t_next > t_end) return false;
+        c[a] += r->step[a];
+        if (c[a] < lo[a] || c[a] >= hi[a]) return false;
+        t        = t_next;
+        tmax[a] += tdelta[a];
+        *axis    = a;
+    }
+}
+
+/* Вход в параллелепипед сетки и обход сверху пирамиды.
+ * *axis — ось грани, через которую луч вошёл в найденную ячейку */
+static bool trace(const vx_raygrid *g, ray *r, int *axis)
+{
+    const vxbits *cells = g->cells;
+    int   dims[3] = {cells->nx, cells->ny, cells->nz};
+    float t_near  = -INFINITY, t_far = INFINITY;
+    int   near_axis = 0;
+
+    for (int a = 0; a < 3; a++) {
+        if (fabsf(r->d[a]) > fabsf(r->d[near_axis])) near_axis = a;
+    }
+    int entry_axis = near_axis;
+    for (int a = 0; a < 3; a++) {
+        if (r->d[a] == 0.0f) {
+            if (r->o[a] < 0.0f || r->o[a] > (float)dims[a]) return false;
+            continue;
+        }
+        float t0 = (0.0f - r->o[a]) * r->inv[a];
+        float t1 = ((float)dims[a] - r->o[a]) * r->inv[a];
+        if (t0 > t1) { float s = t0; t0 = t1; t1 = s; }
+        if (t0 > t_near) { t_near = t0; entry_axis = a; }
+        if (t1 < t_far) t_far = t1;
+    }
+    if (t_near > t_far || t_far < 0.0f) return false;
+    if (t_near < 0.0f) t_near = 0.0f;  /* камера внутри сетки */
+    else               near_axis = entry_axis;
+
+    int   top  = g->levels - 1;
+    const vxbits *tb = level_bits(g, top);
+    float size = 1.0f;
+    for (int k = 0; k < top; k++) size *= VX_RAY_BLOCK;
+    int lo[3] = {0, 0, 0};
+    int hi[3] = {tb->nx, tb->ny, tb->nz};
+
+    *axis = near_axis;
+    return march(g, r, top, size, lo, hi, t_near, t_far, axis);
+}
+
+/* =========================================================
+ *  Кадр: плитки VX_RAY_TILE × VX_RAY_TILE разбираются
+ *  задачами по атомарному счётчику, так что плитки с плотной
+ *  сценой не тормозят остальные потоки.
+ * ========================================================= */
+typedef struct {
+    vx_image         *img;
+    const vx_raygrid *g;
+    float             o[3];            /* камера в ячейках уровня 0          */
+    float             fwd[3], right[3], up[3];
+    float             half_h, half_w;  /* tan(fovy/2) и с учётом сторон кадра */
+    float             color[3];
+    int               tiles_x;
+    int               tile_count;
+    int               next_tile;       /* атомарно                           */
+    int64_t           steps;           /* атомарно                           */
+} ray_job;
+
+static void cast_tile(ray_job *job, int tile, int64_t *steps)
+{
+    vx_image *img = job->img;
+    int x0 = (tile % job->tiles_x) * VX_RAY_TILE;
+    int y0 = (tile / job->tiles_x) * VX_RAY_TILE;
+    int x1 = x0 + VX_RAY_TILE < img->width  ? x0 + VX_RAY_TILE : img->width;
+    int y1 = y0 + VX_RAY_TILE < img->height ? y0 + VX_RAY_TILE : img->height;
+
+    for (int y = y0; y < y1; y++) {
+        float    sy = (1.0f - 2.0f * ((float)y + 0.5f) / (float)img->height) * job->half_h;
+        uint8_t *px = img->pixels + ((size_t)y * img->width + x0) * 4;
+        for (int x = x0; x < x1; x++, px += 4) {
+            float sx = (2.0f * ((float)x + 0.5f) / (float)img->width - 1.0f) * job->half_w;
+            ray   r  = {.steps = 0};
+            float len2 = 0.0f;
+            for (int a = 0; a < 3; a++) {
+                r.o[a]    = job->o[a];
+                r.d[a]    = job->fwd[a] + job->right[a] * sx + job->up[a] * sy;
+                r.inv[a]  = r.d[a] != 0.0f ? 1.0f / r.d[a] : INFINITY;
+                r.step[a] = r.d[a] < 0.0f ? -1 : 1;
+                len2     += r.d[a] * r.d[a];
+            }
+
+            int axis;
+            if (trace(job->g, &r, &axis)) {
+                float shade = 0.3f + 0.7f * fabsf(r.d[axis]) / sqrtf(len2);
+                px[0] = (uint8_t)(job->color[0] * shade);
+                px[1] = (uint8_t)(job->color[1] * shade);
+                px[2] = (uint8_t)(job->color[2] * shade);
+                px[3] = 255;
+            } else {
+                px[0] = px[1] = px[2] = px[3] = 0;
+            }
+            *steps += r.steps;
+        }
+    }
+}
+
+static void cast_task(void *ctx, int task, int tasks)
+{
+    (void)task; (void)tasks;
+    ray_job *job   = ctx;
+    int64_t  steps = 0;
+    for (;;) {
+        int tile = __atomic_fetch_add(&job->next_tile, 1, __ATOMIC_RELAXED);
+        if (tile >= job->tile_count) break;
+        cast_tile(job, tile, &steps);
+    }
+    __atomic_fetch_add(&job->steps, steps, __ATOMIC_RELAXED);
+}
+
+static void normalize3(float v[3])
+{
+    float len = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    if (len > 0.0f) { v[0] /= len; v[1] /= len; v[2] /= len; }
+}
+
+vx_view vx_raygrid_view(const vx_raygrid *g, Vector3 dir, float fovy)
+{
+    const vxbits *c = g->cells;
+    float   half[3] = {c->nx * g->voxel_w * 0.5f, c->ny * g->voxel_w * 0.5f, c->nz * g->voxel_w * 0.5f};
+    float   radius  = sqrtf(half[0] * half[0] + half[1] * half[1] + half[2] * half[2]);
+    float   dist    = radius / sinf(fovy * 0.5f * 0.017453292f);
+    float   d[3]    = {dir.x, dir.y, dir.z};
+    normalize3(d);
+
+    Vector3 center = {g->origin.x + half[0], g->origin.y + half[1], g->origin.z + half[2]};
+    vx_view view   = {
+        .position = {center.x + d[0] * dist, center.y + d[1] * dist, center.z + d[2] * dist},
+        .target   = center,
+        .up       = {0.0f, 1.0f, 0.0f},
+        .fovy     = fovy,
+    };
+    return view;
+}
+
+int64_t vx_raycast(vx_image *img, const vx_raygrid *g, const vx_view *view, Vector3 color,
+                   const vx_bin_opts *opts)
+{
+    if (img->width <= 0 || img->height <= 0) return 0;
+    if (g->cells == NULL || g->cells->cells == 0) {
+        memset(img->pixels, 0, (size_t)img->width * img->height * 4);
+        return 0;
+    }
+
+    ray_job job = {.img = img, .g = g, .color = {color.x, color.y, color.z}};
+
+    /* Базис камеры в координатах сцены; масштаб к ячейкам не меняет направлений */
+    float inv_w = 1.0f / g->voxel_w;
+    job.o[0] = (view->position.x - g->origin.x) * inv_w;
+    job.o[1] = (view->position.y - g->origin.y) * inv_w;
+    job.o[2] = (view->position.z - g->origin.z) * inv_w;
+
+    float *f = job.fwd, *r = job.right, *u = job.up;
+    f[0] = view->target.x - view->position.x;
+    f[1] = view->target.y - view->position.y;
+    f[2] = view->target.z - view->position.z;
+    normalize3(f);
+    r[0] = f[1] * view->up.z - f[2] * view->up.y;
+    r[1] = f[2] * view->up.x - f[0] * view->up.z;
+    r[2] = f[0] * view->up.y - f[1] * view->up.x;
+    normalize3(r);
+    u[0] = r[1] * f[2] - r[2] * f[1];
+    u[1] = r[2] * f[0] - r[0] * f[2];
+    u[2] = r[0] * f[1] - r[1] * f[0];
+
+    job.half_h     = tanf(view->fovy * 0.5f * 0.017453292f);
+    job.half_w     = job.half_h * (float)img->width / (float)img->height;
+    job.tiles_x    = (img->width + VX_RAY_TILE - 1) / VX_RAY_TILE;
+    job.tile_count = job.tiles_x * ((img->height + VX_RAY_TILE - 1) / VX_RAY_TILE);
+
+    int tasks = opts != NULL && opts->threads > 0 ? opts->threads : vx_thread_count();
+    if (tasks > job.tile_count) tasks = job.tile_count;
+    if (tasks > 1) vx_parallel_run(tasks, cast_task, &job);
+    else           cast_task(&job, 0, 1);
+    return job.steps;
+}
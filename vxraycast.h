@@ -0,0 +1,127 @@
+#ifndef VXRAYCAST_H
+#define VXRAYCAST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "voxel.h"
+#include "vxbits.h"
+
+/* =========================================================
+ *  Программная трассировка лучей по сетке занятости
+ *
+ *  Для машин без GPU: вместо линий и кубов на каждую ячейку
+ *  из каждого пикселя пускается луч и идёт по ячейкам 3D-DDA
+ *  (Amanatides–Woo) до первой занятой. Пустое пространство
+ *  пропускается по пирамиде занятости: бит уровня k отмечает
+ *  блок 8^k × 8^k × 8^k ячеек, где есть хоть одна занятая, и
+ *  луч спускается в блок, только если бит стоит. Поэтому
+ *  время кадра зависит от размера изображения и числа
+ *  пересекаемых занятых блоков, а не от числа ячеек сетки.
+ *  Изображение делится на плитки, которые разбирают потоки
+ *  пула vx_parallel_run.
+ * ========================================================= */
+
+/** Сторона блока пирамиды занятости в ячейках уровня ниже. */
+#define VX_RAY_BLOCK 8
+
+/** Наибольшее число уровней пирамиды (8^10 ячеек по оси — с запасом). */
+#define VX_RAY_MAX_LEVELS 10
+
+/** Сторона плитки изображения в пикселях. */
+#define VX_RAY_TILE 32
+
+/**
+ * @brief Камера с перспективой, как у raylib (Camera3D, CAMERA_PERSPECTIVE).
+ */
+typedef struct vx_view {
+    Vector3 position; /**< Положение камеры.                 */
+    Vector3 target;   /**< Точка, куда смотрит камера.       */
+    Vector3 up;       /**< Направление «вверх».              */
+    float   fovy;     /**< Вертикальный угол обзора, градусы. */
+} vx_view;
+
+/**
+ * @brief Изображение RGBA8, строки сверху вниз.
+ */
+typedef struct vx_image {
+    uint8_t *pixels; /**< width · height · 4 байт.  */
+    int      width;  /**< Ширина в пикселях.        */
+    int      height; /**< Высота в пикселях.        */
+} vx_image;
+
+/**
+ * @brief Сетка занятости с пирамидой для пропуска пустоты.
+ *
+ * Уровень 0 — сама сетка (не копируется), уровни 1..levels-1 — блоки.
+ * Верхний уровень не больше VX_RAY_BLOCK блоков по каждой оси.
+ */
+typedef struct vx_raygrid {
+    const vxbits *cells;                      /**< Уровень 0: ячейки.                     */
+    vxbits        coarse[VX_RAY_MAX_LEVELS];  /**< Уровни 1.. (coarse[0] не используется). */
+    int           levels;                     /**< Число уровней, включая нулевой.        */
+    Vector3       origin;                     /**< Угол ячейки (0, 0, 0) в координатах сцены. */
+    float         voxel_w;                    /**< Длина ребра ячейки.                    */
+} vx_raygrid;
+
+/**
+ * @brief Создаёт изображение, залитое прозрачным чёрным.
+ */
+void vx_image_init(vx_image *img, int width, int height);
+
+/**
+ * @brief Освобождает пиксели и обнуляет поля.
+ */
+void vx_image_free(vx_image *img);
+
+/**
+ * @brief Записывает изображение в binary PPM (P6, альфа отбрасывается).
+ *
+ * @param err [out] Текст ошибки или NULL.
+ * @return VX_OK, VX_ERR_OPEN (файл не создан) или VX_ERR_WRITE.
+ */
+vx_status vx_image_write_ppm(const vx_image *img, const char *filename, vx_error *err);
+
+/**
+ * @brief Строит пирамиду занятости над @p cells.
+ *
+ * Стоимость — O(слов сетки + строк · блоков в строке). @p cells должна
+ * жить дольше @p g и не меняться; после её изменения пирамиду нужно
+ * построить заново.
+ *
+ * @param origin  Угол ячейки (0, 0, 0) (для vxlist — mesh->origin).
+ * @param voxel_w Длина ребра ячейки.
+ */
+void vx_raygrid_init(vx_raygrid *g, const vxbits *cells, Vector3 origin, float voxel_w);
+
+/**
+ * @brief Освобождает уровни пирамиды (но не cells).
+ */
+void vx_raygrid_free(vx_raygrid *g);
+
+/**
+ * @brief Камера, в кадр которой целиком входит параллелепипед сетки.
+ *
+ * Смотрит на центр сетки со стороны @p dir (не обязательно единичного)
+ * с расстояния, на котором описанная сфера сетки вписана в угол
+ * обзора @p fovy; «вверх» — ось Y.
+ */
+vx_view vx_raygrid_view(const vx_raygrid *g, Vector3 dir, float fovy);
+
+/**
+ * @brief Рисует занятые ячейки сетки @p g в @p img.
+ *
+ * Каждый пиксель — луч через его центр. Попадание закрашивается цветом
+ * @p color (0..255), умноженным на освещённость грани от источника у
+ * камеры: 0.3 + 0.7·|cos| между лучом и нормалью грани, через которую
+ * луч вошёл в ячейку. Промах — прозрачный чёрный (0, 0, 0, 0), так что
+ * изображение можно наложить на сцену.
+ *
+ * @param opts Потоки (opts->threads) или NULL — все ядра; остальные поля
+ *             не используются.
+ * @return Число шагов DDA по всем уровням и лучам (мера глубинной
+ *         сложности сцены).
+ */
+int64_t vx_raycast(vx_image *img, const vx_raygrid *g, const vx_view *view, Vector3 color,
+                   const vx_bin_opts *opts);
+
+#endif /* VXRAYCAST_H */
@@ -0,0 +1,207 @@
+#include <stdlib.h>
+#include <assert.h>
+#include "raylib.h"
+#include "raymath.h"
+#include "rlgl.h"
+#include "vxrender.h"
+
+/* Вершин линий на один сброс пакета rlgl: чётно и не больше
+ * ёмкости пакета по умолчанию (4 · 2048 вершин в OpenGL ES 2) */
+#define VXR_LINE_CHUNK 8192
+
+/* Маркеров в одном Mesh (36 вершин на маркер) */
+#define VXR_MARKERS_PER_MESH 16384
+
+/* Углы куба: бит 0 — +x, бит 1 — +y, бит 2 — +z */
+static const int cube_tris[36] = {
+    1, 3, 7,  1, 7, 5, /* +X */
+    0, 4, 6,  0, 6, 2, /* -X */
+    2, 6, 7,  2, 7, 3, /* +Y */
+    0, 1, 5,  0, 5, 4, /* -Y */
+    4, 5, 7,  4, 7, 6, /* +Z */
+    0, 2, 3,  0, 3, 1, /* -Z */
+};
+
+void vxrender_init(vxrender *r)
+{
+    *r = (vxrender){0};
+    r->material = LoadMaterialDefault();
+}
+
+static void vxrender_release(vxrender *r)
+{
+    free(r->lines);
+    r->lines      = NULL;
+    r->line_verts = 0;
+    for (int i = 0; i < r->marker_meshes; i++) UnloadMesh(r->markers[i]);
+    free(r->markers);
+    r->markers       = NULL;
+    r->marker_meshes = 0;
+    r->marker_count  = 0;
+    r->built_items   = NULL;
+    r->built_count   = 0;
+}
+
+void vxrender_free(vxrender *r)
+{
+    vxrender_release(r);
+    UnloadMaterial(r->material);
+}
+
+/* Отрезок a -> b в буфер линий */
+static void push_line(float *out, int *n, Vector3 a, Vector3 b)
+{
+    float *p = out + 3 * (size_t)*n;
+    p[0] = a.x; p[1] = a.y; p[2] = a.z;
+    p[3] = b.x; p[4] = b.y; p[5] = b.z;
+    *n += 2;
+}
+
+/* =========================================================
+ *  build_lines
+ *  Решётка плотной сетки: вдоль каждой оси по одному отрезку
+ *  на узел двух других осей.
+ * ========================================================= */
+static void build_lines(vxrender *r, const vxlist *mesh)
+{
+    int     nx = mesh->nx, ny = mesh->ny, nz = mesh->nz;
+    float   w  = mesh->voxel_w;
+    Vector3 o  = mesh->origin;
+    if (nx == 0) return; /* сетка без геометрии (make_vxlist) */
+
+    int total = 2 * ((ny + 1) * (nz + 1) + (nx + 1) * (nz + 1) + (nx + 1) * (ny + 1));
+    r->lines = malloc((size_t)total * 3 * sizeof(float));
+    assert(r->lines != NULL);
+
+    float ex = o.x + nx * w, ey = o.y + ny * w, ez = o.z + nz * w;
+    for (int k = 0; k <= nz; k++) {
+        for (int j = 0; j <= ny; j++) {
+            float y = o.y + j * w, z = o.z + k * w;
+            push_line(r->lines, &r->line_verts, (Vector3){o.x, y, z}, (Vector3){ex, y, z});
+        }
+        for (int i = 0; i <= nx; i++) {
+            float x = o.x + i * w, z = o.z + k * w;
+            push_line(r->lines, &r->line_verts, (Vector3){x, o.y, z}, (Vector3){x, ey, z});
+        }
+    }
+    for (int j = 0; j <= ny; j++) {
+        for (int i = 0; i <= nx; i++) {
+            float x = o.x + i * w, y = o.y + j * w;
+            push_line(r->lines, &r->line_verts, (Vector3){x, y, o.z}, (Vector3){x, y, ez});
+        }
+    }
+}
+
+/* =========================================================
+ *  build_markers
+ *  Сплошные кубы в центрах занятых вокселей, по
+ *  VXR_MARKERS_PER_MESH в каждом Mesh. Воксели выше порога
+ *  берутся из vx_cells_at_least, без обхода всей сетки.
+ * ========================================================= */
+static void build_markers(vxrender *r, const vxlist *mesh, int min_count, float size)
+{
+    const int *cells;
+    r->marker_count = vx_cells_at_least(mesh, min_count, &cells);
+    if (r->marker_count == 0) return;
+
+    r->marker_meshes = (r->marker_count + VXR_MARKERS_PER_MESH - 1) / VXR_MARKERS_PER_MESH;
+    r->markers       = calloc(r->marker_meshes, sizeof(Mesh));
+    assert(r->markers != NULL);
+
+    float h = size * 0.5f;
+    for (int m = 0; m < r->marker_meshes; m++) {
+        int   k    = r->marker_count - m * VXR_MARKERS_PER_MESH;
+        if (k > VXR_MARKERS_PER_MESH) k = VXR_MARKERS_PER_MESH;
+        Mesh *mesh_m = &r->markers[m];
+        mesh_m->vertexCount   = 36 * k;
+        mesh_m->triangleCount = 12 * k;
+        mesh_m->vertices      = MemAlloc(mesh_m->vertexCount * 3 * sizeof(float));
+        assert(mesh_m->vertices != NULL);
+
+        float *v = mesh_m->vertices;
+        for (int i = 0; i < k; i++) {
+            Vector3 c = mesh->items[cells[m * VXR_MARKERS_PER_MESH + i]].vx_center;
+            for (int t = 0; t < 36; t++) {
+                int corner = cube_tris[t];
+                *v++ = c.x + ((corner & 1) ? h : -h);
+                *v++ = c.y + ((corner & 2) ? h : -h);
+                *v++ = c.z + ((corner & 4) ? h : -h);
+            }
+        }
+        UploadMesh(mesh_m, false);
+    }
+}
+
+void vxrender_sync(vxrender *r, const vxlist *mesh, int min_count, float marker_size)
+{
+    if (r->built_items == mesh->items && r->built_count == mesh->count &&
+        r->built_min == min_count) return;
+
+    vxrender_release(r);
+    build_lines(r, mesh);
+    build_markers(r, mesh, min_count, marker_size);
+    r->built_items = mesh->items;
+    r->built_count = mesh->count;
+    r->built_min   = min_count;
+}
+
+int vxrender_draw_grid(const vxrender *r, Color color)
+{
+    int calls = 0;
+    for (int b = 0; b < r->line_verts; b += VXR_LINE_CHUNK) {
+        int n = r->line_verts - b < VXR_LINE_CHUNK ? r->line_verts - b : VXR_LINE_CHUNK;
+        rlCheckRenderBatchLimit(n);
+        rlBegin(RL_LINES);
+        rlColor4ub(color.r, color.g, color.b, color.a);
+        const float *p = r->lines + 3 * (size_t)b;
+        for (int i = 0; i < n; i++, p += 3) rlVertex3f(p[0], p[1], p[2]);
+        rlEnd();
+        rlDrawRenderBatchActive();
+        calls++;
+    }
+    return calls;
+}
+
+int vxrender_draw_markers(vxrender *r, Color color)
+{
+    r->material.maps[MATERIAL_MAP_DIFFUSE].color = color;
+    for (int m = 0; m < r->marker_meshes; m++) DrawMesh(r->markers[m], r->material, MatrixIdentity());
+    return r->marker_meshes;
+}
+
+/* =========================================================
+ *  vxrender_draw_stats
+ *  Панель замеров: строка на стадию с вызовами, затем
+ *  счётчики раскладки и кадра.
+ * ========================================================= */
+void vxrender_draw_stats(const vx_stats *s, int x, int y)
+{
+    const int line = 12;
+    int rows = 4;
+    for (int i = 0; i < VX_STAGE_COUNT; i++) rows += s->calls[i] > 0;
+
+    DrawRectangle(x, y, 230, rows * line + 8, Fade(BLACK, 0.6f));
+    DrawRectangleLines(x, y, 230, rows * line + 8, DARKGRAY);
+    x += 6;
+    y += 4;
+    for (int i = 0; i < VX_STAGE_COUNT; i++) {
+        if (s->calls[i] == 0) continue;
+        DrawText(TextFormat("%-9s %8.2f ms  x%lld", vx_stage_name((vx_stage)i),
+                            s->last_ms[i], (long long)s->calls[i]),
+                 x, y, 10, RAYWHITE);
+        y += line;
+    }
+    DrawText(TextFormat("bin allocs: %lld (%.1f KB)", (long long)s->allocs,
+                        s->alloc_bytes / 1024.0), x, y, 10, RAYWHITE);
+    y += line;
+    DrawText(TextFormat("occupied: %lld of %lld points", (long long)s->occupied,
+                        (long long)s->points), x, y, 10, RAYWHITE);
+    y += line;
+    DrawText(TextFormat("draw calls: %lld", (long long)s->draw_calls), x, y, 10, RAYWHITE);
+    y += line;
+#ifndef VX_STATS
+    DrawText("(built with STATS=0)", x, y, 10, GRAY);
+#else
+    DrawText("H: hide panel", x, y, 10, GRAY);
+#endif
+}
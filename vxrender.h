@@ -0,0 +1,80 @@
+#ifndef VXRENDER_H
+#define VXRENDER_H
+
+#include "raylib.h"
+#include "voxel.h"
+
+/* =========================================================
+ *  Пакетная отрисовка сетки (только просмотрщик, raylib)
+ *
+ *  Линии сетки и маркеры занятых вокселей собираются в буферы
+ *  один раз при смене сетки и рисуются несколькими вызовами
+ *  отрисовки вместо DrawCubeWires на каждую ячейку.
+ * ========================================================= */
+
+/**
+ * @brief Закэшированная геометрия отрисовки одной сетки.
+ */
+typedef struct vxrender {
+    const Voxel *built_items; /**< Сетка, для которой собраны буферы.        */
+    int          built_count; /**< Её число вокселей.                         */
+    int          built_min;   /**< Порог вершин для маркеров.                 */
+
+    float       *lines;       /**< Отрезки сетки: пары вершин, x y z подряд.  */
+    int          line_verts;  /**< Вершин в lines.                            */
+
+    Mesh        *markers;     /**< Маркеры занятых вокселей, кусками.         */
+    int          marker_meshes;
+    int          marker_count;/**< Всего маркеров.                            */
+    Material     material;    /**< Материал маркеров (цвет — diffuse).        */
+} vxrender;
+
+/**
+ * @brief Готовит пустой рендерер. Вызывать после InitWindow.
+ */
+void vxrender_init(vxrender *r);
+
+/**
+ * @brief Освобождает буферы и материал. Вызывать до CloseWindow.
+ */
+void vxrender_free(vxrender *r);
+
+/**
+ * @brief Пересобирает буферы, если сетка или порог изменились.
+ *
+ * Линии строятся по решётке плотной сетки (nx+1)·(ny+1) отрезков
+ * вдоль каждой оси — общие рёбра соседних ячеек не дублируются.
+ * Маркер — сплошной куб со стороной marker_size в центре вокселя,
+ * где вершин не меньше @p min_count.
+ *
+ * @param mesh        Плотная сетка.
+ * @param min_count   Порог вершин для маркера.
+ * @param marker_size Сторона маркера.
+ */
+void vxrender_sync(vxrender *r, const vxlist *mesh, int min_count, float marker_size);
+
+/**
+ * @brief Рисует линии сетки (внутри BeginMode3D).
+ *
+ * @return Число вызовов отрисовки.
+ */
+int vxrender_draw_grid(const vxrender *r, Color color);
+
+/**
+ * @brief Рисует маркеры занятых вокселей (внутри BeginMode3D).
+ *
+ * @return Число вызовов отрисовки.
+ */
+int vxrender_draw_markers(vxrender *r, Color color);
+
+/**
+ * @brief Рисует панель замеров @p s (2D, вне BeginMode3D).
+ *
+ * Стадии с вызовами — длительность последнего вызова и число вызовов;
+ * ниже выделения раскладки, занятые ячейки и вызовы отрисовки.
+ *
+ * @param x, y Левый верхний угол панели.
+ */
+void vxrender_draw_stats(const vx_stats *s, int x, int y);
+
+#endif /* VXRENDER_H */
@@ -0,0 +1,443 @@
+#include <stdint.h>
+#include "vxsimd.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define VX_HAVE_X86 1
+#include <immintrin.h>
+#endif
+
+/* Блок перестановки AoS -> SoA для vx_quantize_aos */
+#define VX_AOS_BLOCK 256
+
+/* =========================================================
+ *  Скалярные реализации (эталон для векторных)
+ * ========================================================= */
+static void quantize_scalar(const float *x, const float *y, const float *z, int n,
+                            const vx_quant *q, int32_t *out)
+{
+    int32_t nxy = q->nx * q->ny;
+    for (int i = 0; i < n; i++) {
+        int32_t xi = vx_quantize_axis(x[i], q->inv_w, q->nx);
+        int32_t yi = vx_quantize_axis(y[i], q->inv_w, q->ny);
+        int32_t zi = vx_quantize_axis(z[i], q->inv_w, q->nz);
+        out[i] = zi * nxy + yi * q->nx + xi;
+    }
+}
+
+static void minmax_scalar(const float *a, int n, float *mn, float *mx)
+{
+    float lo = *mn, hi = *mx;
+    for (int i = 0; i < n; i++) {
+        lo = a[i] < lo ? a[i] : lo;
+        hi = a[i] > hi ? a[i] : hi;
+    }
+    *mn = lo;
+    *mx = hi;
+}
+
+static void normalize_scalar(float *a, int n, float lo, float range, float norm_factor,
+                             float *mn, float *mx)
+{
+    float l = *mn, h = *mx;
+    for (int i = 0; i < n; i++) {
+        a[i] = norm_factor * (a[i] - lo) / range;
+        l = a[i] < l ? a[i] : l;
+        h = a[i] > h ? a[i] : h;
+    }
+    *mn = l;
+    *mx = h;
+}
+
+static void normalize_aos_scalar(Vector3 *v, int n, const float lo[3], const float range[3],
+                                 float norm_factor, float mn[3], float mx[3])
+{
+    for (int i = 0; i < n; i++) {
+        float *p = &v[i].x;
+        for (int a = 0; a < 3; a++) {
+            p[a] = norm_factor * (p[a] - lo[a]) / range[a];
+            mn[a] = p[a] < mn[a] ? p[a] : mn[a];
+            mx[a] = p[a] > mx[a] ? p[a] : mx[a];
+        }
+    }
+}
+
+#ifdef VX_HAVE_X86
+/* =========================================================
+ *  SSE4.1: 4 вершины за шаг (_mm_mullo_epi32 — из SSE4.1)
+ * ========================================================= */
+__attribute__((target("sse4.1")))
+static void quantize_sse41(const float *x, const float *y, const float *z, int n,
+                           const vx_quant *q, int32_t *out)
+{
+    const __m128  inv  = _mm_set1_ps(q->inv_w);
+    const __m128  zero = _mm_setzero_ps();
+    const __m128  hx   = _mm_set1_ps((float)(q->nx - 1));
+    const __m128  hy   = _mm_set1_ps((float)(q->ny - 1));
+    const __m128  hz   = _mm_set1_ps((float)(q->nz - 1));
+    const __m128i vnx  = _mm_set1_epi32(q->nx);
+    const __m128i vnxy = _mm_set1_epi32(q->nx * q->ny);
+
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        /* max(q, 0) первым аргументом: NaN -> 0, как в vx_quantize_axis */
+        __m128 fx = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(x + i), inv), zero), hx);
+        __m128 fy = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(y + i), inv), zero), hy);
+        __m128 fz = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(z + i), inv), zero), hz);
+        __m128i ind = _mm_add_epi32(_mm_add_epi32(_mm_mullo_epi32(_mm_cvttps_epi32(fz), vnxy),
+                                                  _mm_mullo_epi32(_mm_cvttps_epi32(fy), vnx)),
+                                    _mm_cvttps_epi32(fx));
+        _mm_storeu_si128((__m128i *)(out + i), ind);
+    }
+    quantize_scalar(x + i, y + i, z + i, n - i, q, out + i);
+}
+
+__attribute__((target("sse4.1")))
+static void minmax_sse41(const float *a, int n, float *mn, float *mx)
+{
+    __m128 lo = _mm_set1_ps(*mn), hi = _mm_set1_ps(*mx);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_loadu_ps(a + i);
+        lo = _mm_min_ps(v, lo);
+        hi = _mm_max_ps(v, hi);
+    }
+    float l[4], h[4];
+    _mm_storeu_ps(l, lo);
+    _mm_storeu_ps(h, hi);
+    for (int k = 0; k < 4; k++) {
+        if (l[k] < *mn) *mn = l[k];
+        if (h[k] > *mx) *mx = h[k];
+    }
+    minmax_scalar(a + i, n - i, mn, mx);
+}
+
+__attribute__((target("sse4.1")))
+static void normalize_sse41(float *a, int n, float lo, float range, float norm_factor,
+                            float *mn, float *mx)
+{
+    const __m128 vlo = _mm_set1_ps(lo), vr = _mm_set1_ps(range), vn = _mm_set1_ps(norm_factor);
+    __m128 l = _mm_set1_ps(*mn), h = _mm_set1_ps(*mx);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_sub_ps(_mm_loadu_ps(a + i), vlo);
+        v = _mm_div_ps(_mm_mul_ps(vn, v), vr);
+        _mm_storeu_ps(a + i, v);
+        l = _mm_min_ps(v, l);
+        h = _mm_max_ps(v, h);
+    }
+    float lb[4], hb[4];
+    _mm_storeu_ps(lb, l);
+    _mm_storeu_ps(hb, h);
+    for (int k = 0; k < 4; k++) {
+        if (lb[k] < *mn) *mn = lb[k];
+        if (hb[k] > *mx) *mx = hb[k];
+    }
+    normalize_scalar(a + i, n - i, lo, range, norm_factor, mn, mx);
+}
+
+/* AoS: 4 вершины = 12 float = 3 вектора; коэффициенты осей повторяются
+ * с периодом 3, поэтому у каждого из трёх векторов цикла свой шаблон */
+__attribute__((target("sse4.1")))
+static void normalize_aos_sse41(Vector3 *v, int n, const float lo[3], const float range[3],
+                                float norm_factor, float mn[3], float mx[3])
+{
+    float  *a = (float *)v;
+    __m128  plo[3], prg[3], pmn[3], pmx[3];
+    const __m128 vn = _mm_set1_ps(norm_factor);
+    for (int p = 0; p < 3; p++) {
+        float bl[4], br[4], bn[4], bx[4];
+        for (int k = 0; k < 4; k++) {
+            int axis = (4 * p + k) % 3;
+            bl[k] = lo[axis]; br[k] = range[axis]; bn[k] = mn[axis]; bx[k] = mx[axis];
+        }
+        plo[p] = _mm_loadu_ps(bl); prg[p] = _mm_loadu_ps(br);
+        pmn[p] = _mm_loadu_ps(bn); pmx[p] = _mm_loadu_ps(bx);
+    }
+
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        float *f = a + 3 * (size_t)i;
+        for (int p = 0; p < 3; p++) {
+            __m128 r = _mm_div_ps(_mm_mul_ps(vn, _mm_sub_ps(_mm_loadu_ps(f + 4 * p), plo[p])), prg[p]);
+            _mm_storeu_ps(f + 4 * p, r);
+            pmn[p] = _mm_min_ps(r, pmn[p]);
+            pmx[p] = _mm_max_ps(r, pmx[p]);
+        }
+    }
+    for (int p = 0; p < 3; p++) {
+        float bn[4], bx[4];
+        _mm_storeu_ps(bn, pmn[p]);
+        _mm_storeu_ps(bx, pmx[p]);
+        for (int k = 0; k < 4; k++) {
+            int axis = (4 * p + k) % 3;
+            if (bn[k] < mn[axis]) mn[axis] = bn[k];
+            if (bx[k] > mx[axis]) mx[axis] = bx[k];
+        }
+    }
+    normalize_aos_scalar(v + i, n - i, lo, range, norm_factor, mn, mx);
+}
+
+/* =========================================================
+ *  AVX2: 8 вершин за шаг
+ * ========================================================= */
+__attribute__((target("avx2")))
+static void quantize_avx2(const float *x, const float *y, const float *z, int n,
+                          const vx_quant *q, int32_t *out)
+{
+    const __m256  inv  = _mm256_set1_ps(q->inv_w);
+    const __m256  zero = _mm256_setzero_ps();
+    const __m256  hx   = _mm256_set1_ps((float)(q->nx - 1));
+    const __m256  hy   = _mm256_set1_ps((float)(q->ny - 1));
+    const __m256  hz   = _mm256_set1_ps((float)(q->nz - 1));
+    const __m256i vnx  = _mm256_set1_epi32(q->nx);
+    const __m256i vnxy = _mm256_set1_epi32(q->nx * q->ny);
+
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 fx = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(x + i), inv), zero), hx);
+        __m256 fy = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(y + i), inv), zero), hy);
+        __m256 fz = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(z + i), inv), zero), hz);
+        __m256i ind = _mm256_add_epi32(_mm256_add_epi32(_mm256_mullo_epi32(_mm256_cvttps_epi32(fz), vnxy),
+                                                        _mm256_mullo_epi32(_mm256_cvttps_epi32(fy), vnx)),
+                                       _mm256_cvttps_epi32(fx));
+        _mm256_storeu_si256((__m256i *)(out + i), ind);
+    }
+    quantize_scalar(x + i, y + i, z + i, n - i, q, out + i);
+}
+
+__attribute__((target("avx2")))
+static void minmax_avx2(const float *a, int n, float *mn, float *mx)
+{
+    __m256 lo = _mm256_set1_ps(*mn), hi = _mm256_set1_ps(*mx);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 v = _mm256_loadu_ps(a + i);
+        lo = _mm256_min_ps(v, lo);
+        hi = _mm256_max_ps(v, hi);
+    }
+    float l[8], h[8];
+    _mm256_storeu_ps(l, lo);
+    _mm256_storeu_ps(h, hi);
+    for (int k = 0; k < 8; k++) {
+        if (l[k] < *mn) *mn = l[k];
+        if (h[k] > *mx) *mx = h[k];
+    }
+    minmax_scalar(a + i, n - i, mn, mx);
+}
+
+__attribute__((target("avx2")))
+static void normalize_avx2(float *a, int n, float lo, float range, float norm_factor,
+                           float *mn, float *mx)
+{
+    const __m256 vlo = _mm256_set1_ps(lo), vr = _mm256_set1_ps(range), vn = _mm256_set1_ps(norm_factor);
+    __m256 l = _mm256_set1_ps(*mn), h = _mm256_set1_ps(*mx);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 v = _mm256_sub_ps(_mm256_loadu_ps(a + i), vlo);
+        v = _mm256_div_ps(_mm256_mul_ps(vn, v), vr);
+        _mm256_storeu_ps(a + i, v);
+        l = _mm256_min_ps(v, l);
+        h = _mm256_max_ps(v, h);
+    }
+    float lb[8], hb[8];
+    _mm256_storeu_ps(lb, l);
+    _mm256_storeu_ps(hb, h);
+    for (int k = 0; k < 8; k++) {
+        if (lb[k] < *mn) *mn = lb[k];
+        if (hb[k] > *mx) *mx = hb[k];
+    }
+    normalize_scalar(a + i, n - i, lo, range, norm_factor, mn, mx);
+}
+
+/* AoS: 8 вершин = 24 float = 3 вектора (см. normalize_aos_sse41) */
+__attribute__((target("avx2")))
+static void normalize_aos_avx2(Vector3 *v, int n, const float lo[3], const float range[3],
+                               float norm_factor, float mn[3], float mx[3])
+{
+    float  *a = (float *)v;
+    __m256  plo[3], prg[3], pmn[3], pmx[3];
+    const __m256 vn = _mm256_set1_ps(norm_factor);
+    for (int p = 0; p < 3; p++) {
+        float bl[8], br[8], bn[8], bx[8];
+        for (int k = 0; k < 8; k++) {
+            int axis = (8 * p + k) % 3;
+            bl[k] = lo[axis]; br[k] = range[axis]; bn[k] = mn[axis]; bx[k] = mx[axis];
+        }
+        plo[p] = _mm256_loadu_ps(bl); prg[p] = _mm256_loadu_ps(br);
+        pmn[p] = _mm256_loadu_ps(bn); pmx[p] = _mm256_loadu_ps(bx);
+    }
+
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        float *f = a + 3 * (size_t)i;
+        for (int p = 0; p < 3; p++) {
+            __m256 r = _mm256_div_ps(_mm256_mul_ps(vn, _mm256_sub_ps(_mm256_loadu_ps(f + 8 * p), plo[p])), prg[p]);
+            _mm256_storeu_ps(f + 8 * p, r);
+            pmn[p] = _mm256_min_ps(r, pmn[p]);
+            pmx[p] = _mm256_max_ps(r, pmx[p]);
+        }
+    }
+    for (int p = 0; p < 3; p++) {
+        float bn[8], bx[8];
+        _mm256_storeu_ps(bn, pmn[p]);
+        _mm256_storeu_ps(bx, pmx[p]);
+        for (int k = 0; k < 8; k++) {
+            int axis = (8 * p + k) % 3;
+            if (bn[k] < mn[axis]) mn[axis] = bn[k];
+            if (bx[k] > mx[axis]) mx[axis] = bx[k];
+        }
+    }
+    normalize_aos_scalar(v + i, n - i, lo, range, norm_factor, mn, mx);
+}
+#endif /* VX_HAVE_X86 */
+
+/* =========================================================
+ *  Диспетчеризация
+ *  Уровень определяется при первом обращении; гонка при
+ *  первом вызове из нескольких потоков безвредна — все
+ *  запишут одно и то же значение.
+ * ========================================================= */
+static int simd_level = -1;
+
+static vx_simd_isa detect_level(void)
+{
+#ifdef VX_HAVE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))   return VX_SIMD_AVX2;
+    if (__builtin_cpu_supports("sse4.1")) return VX_SIMD_SSE41;
+#endif
+    return VX_SIMD_SCALAR;
+}
+
+vx_simd_isa vx_simd_level(void)
+{
+    if (simd_level < 0) simd_level = detect_level();
+    return (vx_simd_isa)simd_level;
+}
+
+void vx_simd_force(vx_simd_isa isa)
+{
+    vx_simd_isa best = detect_level();
+    simd_level = isa < best ? isa : best;
+}
+
+const char *vx_simd_name(vx_simd_isa isa)
+{
+    switch (isa) {
+    case VX_SIMD_AVX2:  return "avx2";
+    case VX_SIMD_SSE41: return "sse4.1";
+    default:            return "scalar";
+    }
+}
+
+void vx_quantize(const float *x, const float *y, const float *z, int n,
+                 const vx_quant *q, int32_t *out)
+{
+    switch (vx_simd_level()) {
+#ifdef VX_HAVE_X86
+    case VX_SIMD_AVX2:  quantize_avx2(x, y, z, n, q, out);  return;
+    case VX_SIMD_SSE41: quantize_sse41(x, y, z, n, q, out); return;
+#endif
+    default:            quantize_scalar(x, y, z, n, q, out); return;
+    }
+}
+
+void vx_quantize_aos(const Vector3 *v, int n, const vx_quant *q, int32_t *out)
+{
+    float x[VX_AOS_BLOCK], y[VX_AOS_BLOCK], z[VX_AOS_BLOCK];
+    for (int b = 0; b < n; b += VX_AOS_BLOCK) {
+        int k = n - b < VX_AOS_BLOCK ? n - b : VX_AOS_BLOCK;
+        for (int i = 0; i < k; i++) {
+            x[i] = v[b + i].x;
+            y[i] = v[b + i].y;
+            z[i] = v[b + i].z;
+        }
+        vx_quantize(x, y, z, k, q, out + b);
+    }
+}
+
+/* Ключи блоками по VX_AOS_BLOCK: ядро пишет int32, здесь — расширение */
+static void quantize_keys(const Vector3 *v, const float *x, const float *y, const float *z,
+                          int n, const vx_quant *q, int64_t *out)
+{
+    if ((int64_t)q->nx * q->ny * q->nz >= INT32_MAX) {
+        for (int i = 0; i < n; i++) {
+            Vector3 p  = v ? v[i] : (Vector3){x[i], y[i], z[i]};
+            int64_t xi = vx_quantize_axis(p.x, q->inv_w, q->nx);
+            int64_t yi = vx_quantize_axis(p.y, q->inv_w, q->ny);
+            int64_t zi = vx_quantize_axis(p.z, q->inv_w, q->nz);
+            out[i] = (zi * q->ny + yi) * q->nx + xi;
+        }
+        return;
+    }
+
+    int32_t cell[VX_AOS_BLOCK];
+    for (int b = 0; b < n; b += VX_AOS_BLOCK) {
+        int k = n - b < VX_AOS_BLOCK ? n - b : VX_AOS_BLOCK;
+        if (v) vx_quantize_aos(v + b, k, q, cell);
+        else   vx_quantize(x + b, y + b, z + b, k, q, cell);
+        for (int i = 0; i < k; i++) out[b + i] = cell[i];
+    }
+}
+
+void vx_quantize_keys(const float *x, const float *y, const float *z, int n,
+                      const vx_quant *q, int64_t *out)
+{
+    quantize_keys(NULL, x, y, z, n, q, out);
+}
+
+void vx_quantize_keys_aos(const Vector3 *v, int n, const vx_quant *q, int64_t *out)
+{
+    quantize_keys(v, NULL, NULL, NULL, n, q, out);
+}
+
+void vx_minmax(const float *a, int n, float *mn, float *mx)
+{
+    switch (vx_simd_level()) {
+#ifdef VX_HAVE_X86
+    case VX_SIMD_AVX2:  minmax_avx2(a, n, mn, mx);  return;
+    case VX_SIMD_SSE41: minmax_sse41(a, n, mn, mx); return;
+#endif
+    default:            minmax_scalar(a, n, mn, mx); return;
+    }
+}
+
+void vx_minmax_aos(const Vector3 *v, int n, float mn[3], float mx[3])
+{
+    float x[VX_AOS_BLOCK], y[VX_AOS_BLOCK], z[VX_AOS_BLOCK];
+    for (int b = 0; b < n; b += VX_AOS_BLOCK) {
+        int k = n - b < VX_AOS_BLOCK ? n - b : VX_AOS_BLOCK;
+        for (int i = 0; i < k; i++) {
+            x[i] = v[b + i].x;
+            y[i] = v[b + i].y;
+            z[i] = v[b + i].z;
+        }
+        vx_minmax(x, k, &mn[0], &mx[0]);
+        vx_minmax(y, k, &mn[1], &mx[1]);
+        vx_minmax(z, k, &mn[2], &mx[2]);
+    }
+}
+
+void vx_normalize_aos(Vector3 *v, int n, const float lo[3], const float range[3],
+                      float norm_factor, float mn[3], float mx[3])
+{
+    switch (vx_simd_level()) {
+#ifdef VX_HAVE_X86
+    case VX_SIMD_AVX2:  normalize_aos_avx2(v, n, lo, range, norm_factor, mn, mx);  return;
+    case VX_SIMD_SSE41: normalize_aos_sse41(v, n, lo, range, norm_factor, mn, mx); return;
+#endif
+    default:            normalize_aos_scalar(v, n, lo, range, norm_factor, mn, mx); return;
+    }
+}
+
+void vx_normalize_axis(float *a, int n, float lo, float range, float norm_factor,
+                       float *mn, float *mx)
+{
+    switch (vx_simd_level()) {
+#ifdef VX_HAVE_X86
+    case VX_SIMD_AVX2:  normalize_avx2(a, n, lo, range, norm_factor, mn, mx);  return;
+    case VX_SIMD_SSE41: normalize_sse41(a, n, lo, range, norm_factor, mn, mx); return;
+#endif
+    default:            normalize_scalar(a, n, lo, range, norm_factor, mn, mx); return;
+    }
+}
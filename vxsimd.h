@@ -0,0 +1,135 @@
+#ifndef VXSIMD_H
+#define VXSIMD_H
+
+#include <stdint.h>
+#include "voxel.h"
+
+/* =========================================================
+ *  Векторные ядра: квантование, нормализация, границы
+ *
+ *  Реализации AVX2 (8 вершин за шаг), SSE4.1 (4 вершины) и
+ *  скалярная; выбор — во время выполнения по CPUID. Все три
+ *  дают побитно одинаковый результат.
+ * ========================================================= */
+
+/**
+ * @brief Набор инструкций, используемый ядрами.
+ */
+typedef enum {
+    VX_SIMD_SCALAR = 0, /**< Скалярная реализация. */
+    VX_SIMD_SSE41  = 1, /**< SSE4.1, 4 вершины за шаг. */
+    VX_SIMD_AVX2   = 2, /**< AVX2, 8 вершин за шаг.    */
+} vx_simd_isa;
+
+/**
+ * @brief Параметры квантования вершин в индексы ячеек плотной сетки.
+ */
+typedef struct vx_quant {
+    float inv_w; /**< 1 / voxel_w — умножение вместо деления.         */
+    int   nx;    /**< Ячеек вдоль X.                                   */
+    int   ny;    /**< Ячеек вдоль Y.                                   */
+    int   nz;    /**< Ячеек вдоль Z.                                   */
+} vx_quant;
+
+/**
+ * @brief Квантует одну координату: trunc(clamp(v · inv_w, 0, n - 1)).
+ *
+ * Зажим выполняется до преобразования в int, поэтому огромные значения
+ * и NaN не приводят к переполнению; NaN попадает в ячейку 0. Порядок
+ * операций совпадает с векторными ядрами.
+ */
+static inline int vx_quantize_axis(float v, float inv_w, int n)
+{
+    float q = v * inv_w;
+    float hi = (float)(n - 1);
+    q = q > 0.0f ? q : 0.0f;
+    q = q < hi ? q : hi;
+    return (int)q;
+}
+
+/**
+ * @brief Возвращает набор инструкций, выбранный для ядер.
+ */
+vx_simd_isa vx_simd_level(void);
+
+/**
+ * @brief Принудительно задаёт набор инструкций (не выше поддерживаемого CPU).
+ *
+ * Нужен для бенчмарков и сравнения реализаций.
+ */
+void vx_simd_force(vx_simd_isa isa);
+
+/**
+ * @brief Имя набора инструкций ("avx2", "sse4.1", "scalar").
+ */
+const char *vx_simd_name(vx_simd_isa isa);
+
+/**
+ * @brief Вычисляет линейные индексы ячеек zi·(nx·ny) + yi·nx + xi для SoA-вершин.
+ *
+ * @param x, y, z Координаты вершин (n штук в каждом массиве).
+ * @param n       Количество вершин.
+ * @param q       Параметры квантования (nx·ny·nz < 2^31).
+ * @param out     [out] Индексы ячеек, n штук.
+ */
+void vx_quantize(const float *x, const float *y, const float *z, int n,
+                 const vx_quant *q, int32_t *out);
+
+/**
+ * @brief То же для массива Vector3: вершины блоками переставляются в SoA.
+ */
+void vx_quantize_aos(const Vector3 *v, int n, const vx_quant *q, int32_t *out);
+
+/**
+ * @brief Линейные индексы ячеек в 64 битах — для сеток любого размера.
+ *
+ * Сетки меньше 2^31 ячеек квантуются ядром vx_quantize, большие —
+ * скалярно: произведение zi·(nx·ny) уже не помещается в int32.
+ *
+ * @param out [out] Индексы ячеек, n штук.
+ */
+void vx_quantize_keys(const float *x, const float *y, const float *z, int n,
+                      const vx_quant *q, int64_t *out);
+
+/**
+ * @brief То же для массива Vector3.
+ */
+void vx_quantize_keys_aos(const Vector3 *v, int n, const vx_quant *q, int64_t *out);
+
+/**
+ * @brief Обновляет текущие min/max по массиву @p a.
+ *
+ * @param mn [in,out] Текущий минимум.
+ * @param mx [in,out] Текущий максимум.
+ */
+void vx_minmax(const float *a, int n, float *mn, float *mx);
+
+/**
+ * @brief То же по осям массива Vector3: блоки вершин переставляются
+ *        в SoA и идут в vx_minmax.
+ *
+ * @param mn [in,out] Текущий минимум по X, Y, Z.
+ * @param mx [in,out] Текущий максимум по X, Y, Z.
+ */
+void vx_minmax_aos(const Vector3 *v, int n, float mn[3], float mx[3]);
+
+/**
+ * @brief Нормализует координату на месте: a = norm_factor · (a − lo) / range.
+ *
+ * Попутно обновляет min/max нормализованных значений (как vx_minmax).
+ */
+void vx_normalize_axis(float *a, int n, float lo, float range, float norm_factor,
+                       float *mn, float *mx);
+
+/**
+ * @brief Нормализует массив Vector3 на месте без перестановки в SoA.
+ *
+ * Память обрабатывается как плоский поток float; коэффициенты осей
+ * повторяются с периодом 3, поэтому на цикл из 3 векторов приходится
+ * 3 шаблона коэффициентов. Результат побитно совпадает с покомпонентной
+ * формулой norm_factor · (v − lo) / range; min/max обновляются по осям.
+ */
+void vx_normalize_aos(Vector3 *v, int n, const float lo[3], const float range[3],
+                      float norm_factor, float mn[3], float mx[3]);
+
+#endif /* VXSIMD_H */
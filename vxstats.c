@@ -0,0 +1,76 @@
+#include <string.h>
+#include "vxstats.h"
+
+static const char *const stage_names[VX_STAGE_COUNT] = {
+    "parse", "normalize", "mesh", "bin", "surface", "fill", "write", "render", "export", "edt", "label",
+};
+
+const char *vx_stage_name(vx_stage stage)
+{
+    return (unsigned)stage < VX_STAGE_COUNT ? stage_names[stage] : "?";
+}
+
+void vx_stats_reset(vx_stats *s)
+{
+    memset(s, 0, sizeof(*s));
+}
+
+void vx_stats_add(vx_stats *s, vx_stage stage, double ms)
+{
+    if (s == NULL) return;
+    s->last_ms[stage]   = ms;
+    s->total_ms[stage] += ms;
+    s->calls[stage]++;
+}
+
+void vx_stats_end(vx_stats *s, vx_stage stage, double t0)
+{
+    if (s == NULL) return;
+    vx_stats_add(s, stage, (vx_now() - t0) * 1000.0);
+}
+
+void vx_stats_alloc(vx_stats *s, size_t bytes)
+{
+    if (s == NULL) return;
+    s->allocs++;
+    s->alloc_bytes += (int64_t)bytes;
+}
+
+void vx_stats_merge(vx_stats *dst, const vx_stats *src)
+{
+    for (int i = 0; i < VX_STAGE_COUNT; i++) {
+        if (src->calls[i] == 0) continue;
+        dst->last_ms[i]   = src->last_ms[i];
+        dst->total_ms[i] += src->total_ms[i];
+        dst->calls[i]    += src->calls[i];
+    }
+    dst->allocs      += src->allocs;
+    dst->alloc_bytes += src->alloc_bytes;
+    if (src->calls[VX_STAGE_BIN] > 0) {
+        dst->points   = src->points;
+        dst->occupied = src->occupied;
+    }
+    if (src->calls[VX_STAGE_RENDER] > 0) dst->draw_calls = src->draw_calls;
+}
+
+/* =========================================================
+ *  vx_stats_write_json
+ *  Время — в миллисекундах с тремя знаками, счётчики — целые.
+ * ========================================================= */
+void vx_stats_write_json(FILE *f, const vx_stats *s)
+{
+    fprintf(f, "{\n  \"stages\": {");
+    const char *sep = "\n";
+    for (int i = 0; i < VX_STAGE_COUNT; i++) {
+        if (s->calls[i] == 0) continue;
+        fprintf(f, "%s    \"%s\": {\"calls\": %lld, \"last_ms\": %.3f, \"total_ms\": %.3f}",
+                sep, stage_names[i], (long long)s->calls[i], s->last_ms[i], s->total_ms[i]);
+        sep = ",\n";
+    }
+    fprintf(f, "%s},\n", sep[0] == ',' ? "\n  " : "");
+    fprintf(f, "  \"bin_allocs\": %lld,\n",      (long long)s->allocs);
+    fprintf(f, "  \"bin_alloc_bytes\": %lld,\n", (long long)s->alloc_bytes);
+    fprintf(f, "  \"points\": %lld,\n",          (long long)s->points);
+    fprintf(f, "  \"occupied\": %lld,\n",        (long long)s->occupied);
+    fprintf(f, "  \"draw_calls\": %lld\n}\n",    (long long)s->draw_calls);
+}
@@ -0,0 +1,136 @@
+#ifndef VXSTATS_H
+#define VXSTATS_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "vxsys.h"
+
+/* =========================================================
+ *  Счётчики и таймеры стадий конвейера
+ *
+ *  Замеры копятся в vx_stats: время и число вызовов каждой
+ *  стадии, выделения памяти в ind_finder, занятые ячейки и
+ *  вызовы отрисовки кадра. Сборка с -DVX_NO_STATS (make
+ *  STATS=0) убирает замеры целиком: макросы VX_STATS_*
+ *  превращаются в пустые выражения, а поля остаются нулями.
+ * ========================================================= */
+
+#ifndef VX_NO_STATS
+#define VX_STATS 1
+#endif
+
+/**
+ * @brief Стадии конвейера.
+ */
+typedef enum vx_stage {
+    VX_STAGE_PARSE,     /**< Чтение PLY.                        */
+    VX_STAGE_NORMALIZE, /**< Нормализация вершин.               */
+    VX_STAGE_MESH,      /**< Построение пустой сетки.           */
+    VX_STAGE_BIN,       /**< Раскладка вершин (ind_finder).     */
+    VX_STAGE_SURFACE,   /**< Вокселизация треугольников.        */
+    VX_STAGE_FILL,      /**< Заливка внутренности.              */
+    VX_STAGE_WRITE,     /**< Запись результата.                 */
+    VX_STAGE_RENDER,    /**< Отрисовка кадра (просмотрщик).     */
+    VX_STAGE_EXPORT,    /**< Экспорт треугольной сетки.         */
+    VX_STAGE_EDT,       /**< Поле расстояний.                   */
+    VX_STAGE_LABEL,     /**< Разметка связных компонент.        */
+    VX_STAGE_COUNT
+} vx_stage;
+
+/**
+ * @brief Накопленные замеры.
+ *
+ * Не потокобезопасна: у каждого потока (контекста) свой экземпляр,
+ * сводятся они через vx_stats_merge.
+ */
+typedef struct vx_stats {
+    double  last_ms[VX_STAGE_COUNT];  /**< Длительность последнего вызова, мс. */
+    double  total_ms[VX_STAGE_COUNT]; /**< Суммарная длительность, мс.         */
+    int64_t calls[VX_STAGE_COUNT];    /**< Число вызовов.                      */
+    int64_t allocs;      /**< Выделений и перевыделений в ind_finder.          */
+    int64_t alloc_bytes; /**< Их суммарный размер, байт.                       */
+    int64_t points;      /**< Вершин в последней раскладке.                    */
+    int64_t occupied;    /**< Занятых ячеек в последней раскладке.             */
+    int64_t draw_calls;  /**< Вызовов отрисовки в последнем кадре.             */
+} vx_stats;
+
+/**
+ * @brief Имя стадии для вывода ("parse", "bin", ...).
+ */
+const char *vx_stage_name(vx_stage stage);
+
+/**
+ * @brief Обнуляет замеры.
+ */
+void vx_stats_reset(vx_stats *s);
+
+/**
+ * @brief Учитывает вызов стадии длительностью @p ms миллисекунд.
+ *
+ * @param s Замеры или NULL (ничего не делает).
+ */
+void vx_stats_add(vx_stats *s, vx_stage stage, double ms);
+
+/**
+ * @brief Завершает замер стадии, начатый в момент @p t0 (vx_now()).
+ *
+ * @param s Замеры или NULL (ничего не делает).
+ */
+void vx_stats_end(vx_stats *s, vx_stage stage, double t0);
+
+/**
+ * @brief Учитывает одно выделение @p bytes байт.
+ *
+ * @param s Замеры или NULL (ничего не делает).
+ */
+void vx_stats_alloc(vx_stats *s, size_t bytes);
+
+/**
+ * @brief Добавляет замеры @p src к @p dst.
+ *
+ * Время и вызовы стадий суммируются, last_ms берётся у @p src для
+ * стадий, которые в нём вызывались; points и occupied — у @p src,
+ * если в нём была раскладка, draw_calls — если в нём был кадр.
+ */
+void vx_stats_merge(vx_stats *dst, const vx_stats *src);
+
+/**
+ * @brief Пишет замеры одним JSON-объектом.
+ *
+ * Стадии без вызовов пропускаются. Формат:
+ * {"stages": {"parse": {"calls": 1, "last_ms": ..., "total_ms": ...}, ...},
+ *  "bin_allocs": ..., "bin_alloc_bytes": ..., "points": ...,
+ *  "occupied": ..., "draw_calls": ...}
+ */
+void vx_stats_write_json(FILE *f, const vx_stats *s);
+
+/* ---------------------------------------------------------
+ *  Макросы замеров: без VX_STATS не стоят ничего
+ *
+ *  double t0 = VX_STATS_BEGIN();
+ *  ... стадия ...
+ *  VX_STATS_END(stats, VX_STAGE_BIN, t0);
+ *
+ *  VX_STATS_SCOPE(stats, VX_STAGE_BIN) { ... } — то же блоком;
+ *  выход из блока через return/break/goto замер не закрывает.
+ * ------------------------------------------------------- */
+#ifdef VX_STATS
+#define VX_STATS_BEGIN()               vx_now()
+#define VX_STATS_END(s, stage, t0)     vx_stats_end((s), (stage), (t0))
+#define VX_STATS_ADD(s, stage, ms)     vx_stats_add((s), (stage), (ms))
+#define VX_STATS_ALLOC(s, bytes)       vx_stats_alloc((s), (bytes))
+#define VX_STATS_SET(s, field, value)  do { if ((s) != NULL) (s)->field = (value); } while (0)
+#else
+#define VX_STATS_BEGIN()               0.0
+#define VX_STATS_END(s, stage, t0)     ((void)(s), (void)(t0))
+#define VX_STATS_ADD(s, stage, ms)     ((void)(s), (void)(ms))
+#define VX_STATS_ALLOC(s, bytes)       ((void)(s), (void)(bytes))
+#define VX_STATS_SET(s, field, value)  ((void)(s), (void)(value))
+#endif
+
+#define VX_STATS_SCOPE(s, stage)                                                  \
+    for (double vx_scope_t0 = VX_STATS_BEGIN(), vx_scope_once = 1; vx_scope_once; \
+         vx_scope_once = 0, VX_STATS_END((s), (stage), vx_scope_t0))
+
+#endif /* VXSTATS_H */
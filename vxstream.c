@@ -0,0 +1,396 @@
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <float.h>
+#include <math.h>
+#include "vxstream.h"
+#include "vxsimd.h"
+#include "ply.h"
+
+/* Вершин на один вызов ядра квантования */
+#define VX_ACCUM_BLOCK 512
+
+/* Массив сумм по 3 double на ячейку, если поле включено */
+static double *sums_alloc(double *old, int fields, int field, int capacity)
+{
+    if (!(fields & field)) return NULL;
+    double *p = realloc(old, (size_t)capacity * 3 * sizeof(double));
+    assert(p != NULL);
+    return p;
+}
+
+void vx_accum_init(vx_accum *a, int nx, int ny, int nz, float voxel_w, Vector3 origin,
+                   int fields)
+{
+    *a = (vx_accum){0};
+    a->nx       = nx;
+    a->ny       = ny;
+    a->nz       = nz;
+    a->voxel_w  = voxel_w;
+    a->origin   = origin;
+    a->fields   = fields;
+    a->capacity = 1024;
+    a->keys     = malloc((size_t)a->capacity * sizeof(int64_t));
+    a->counts   = malloc((size_t)a->capacity * sizeof(int64_t));
+    assert(a->keys != NULL && a->counts != NULL);
+    a->sums    = sums_alloc(NULL, fields, VX_ACCUM_CENTROID, a->capacity);
+    a->colors  = sums_alloc(NULL, fields, VX_ACCUM_COLOR, a->capacity);
+    a->normals = sums_alloc(NULL, fields, VX_ACCUM_NORMAL, a->capacity);
+    vxhash_init(&a->cells, a->capacity);
+}
+
+void vx_accum_free(vx_accum *a)
+{
+    free(a->keys);
+    free(a->counts);
+    free(a->sums);
+    free(a->colors);
+    free(a->normals);
+    free(a->near_pos);
+    free(a->near_color);
+    free(a->near_normal);
+    free(a->near_d2);
+    vxhash_free(&a->cells);
+    *a = (vx_accum){0};
+}
+
+size_t vx_accum_bytes(const vx_accum *a)
+{
+    size_t per_cell = 2 * sizeof(int64_t);
+    if (a->sums)        per_cell += 3 * sizeof(double);
+    if (a->colors)      per_cell += 3 * sizeof(double);
+    if (a->normals)     per_cell += 3 * sizeof(double);
+    if (a->near_pos)    per_cell += sizeof(Vector3) + sizeof(float);
+    if (a->near_color)  per_cell += sizeof(Vector3);
+    if (a->near_normal) per_cell += sizeof(Vector3);
+    return (size_t)a->capacity * per_cell +
+           (size_t)a->cells.capacity * (sizeof(uint64_t) + sizeof(int));
+}
+
+/* Номер ячейки key; новая ячейка дописывается в конец массивов */
+static int accum_cell(vx_accum *a, int64_t key)
+{
+    int i = vxhash_insert(&a->cells, (uint64_t)key, a->count);
+    if (i < a->count) return i;
+
+    if (a->count == a->capacity) {
+        a->capacity *= 2;
+        a->keys   = realloc(a->keys, (size_t)a->capacity * sizeof(int64_t));
+        a->counts = realloc(a->counts, (size_t)a->capacity * sizeof(int64_t));
+        assert(a->keys != NULL && a->counts != NULL);
+        a->sums    = sums_alloc(a->sums, a->fields, VX_ACCUM_CENTROID, a->capacity);
+        a->colors  = sums_alloc(a->colors, a->fields, VX_ACCUM_COLOR, a->capacity);
+        a->normals = sums_alloc(a->normals, a->fields, VX_ACCUM_NORMAL, a->capacity);
+    }
+    a->keys[i]   = key;
+    a->counts[i] = 0;
+    if (a->sums)    memset(&a->sums[3 * i], 0, 3 * sizeof(double));
+    if (a->colors)  memset(&a->colors[3 * i], 0, 3 * sizeof(double));
+    if (a->normals) memset(&a->normals[3 * i], 0, 3 * sizeof(double));
+    a->count++;
+    return i;
+}
+
+static void sum_add(double *sums, int cell, const Vector3 *v)
+{
+    sums[3 * cell]     += v->x;
+    sums[3 * cell + 1] += v->y;
+    sums[3 * cell + 2] += v->z;
+}
+
+/* =========================================================
+ *  vx_accum_add_attrs
+ *  Подряд идущие вершины облака обычно лежат в одной ячейке,
+ *  поэтому поиск в хеше делается только при смене ячейки;
+ *  суммы копятся в том же проходе, что и счётчик.
+ * ========================================================= */
+void vx_accum_add_attrs(vx_accum *a, const Vector3 *v, const Vector3 *color,
+                        const Vector3 *normal, int count)
+{
+    vx_quant q    = {.inv_w = 1.0f / a->voxel_w, .nx = a->nx, .ny = a->ny, .nz = a->nz};
+    int64_t  key[VX_ACCUM_BLOCK];
+    int64_t  last = -1;
+    int      cell = -1;
+    if (a->colors == NULL)  color  = NULL;
+    if (a->normals == NULL) normal = NULL;
+
+    for (int i = 0; i < count; i += VX_ACCUM_BLOCK) {
+        int n = count - i < VX_ACCUM_BLOCK ? count - i : VX_ACCUM_BLOCK;
+        vx_quantize_keys_aos(v + i, n, &q, key);
+
+        for (int k = 0; k < n; k++) {
+            if (key[k] != last) {
+                cell = accum_cell(a, key[k]);
+                last = key[k];
+            }
+            a->counts[cell]++;
+            if (a->sums) sum_add(a->sums, cell, &v[i + k]);
+            if (color)   sum_add(a->colors, cell, &color[i + k]);
+            if (normal)  sum_add(a->normals, cell, &normal[i + k]);
+        }
+    }
+    a->point_count += count;
+}
+
+void vx_accum_add(vx_accum *a, const Vector3 *v, int count)
+{
+    vx_accum_add_attrs(a, v, NULL, NULL, count);
+}
+
+/* =========================================================
+ *  vx_accum_nearest
+ * ========================================================= */
+void vx_accum_nearest(vx_accum *a, const Vector3 *v, const Vector3 *color,
+                      const Vector3 *normal, int count)
+{
+    assert(a->sums != NULL);
+    if (a->near_pos == NULL) {
+        a->near_pos = malloc(((size_t)a->capacity) * sizeof(Vector3));
+        a->near_d2  = malloc(((size_t)a->capacity) * sizeof(float));
+        assert(a->near_pos != NULL && a->near_d2 != NULL);
+        for (int i = 0; i < a->count; i++) a->near_d2[i] = FLT_MAX;
+        if (a->colors) {
+            a->near_color = calloc((size_t)a->capacity, sizeof(Vector3));
+            assert(a->near_color != NULL);
+        }
+        if (a->normals) {
+            a->near_normal = calloc((size_t)a->capacity, sizeof(Vector3));
+            assert(a->near_normal != NULL);
+        }
+    }
+
+    vx_quant q    = {.inv_w = 1.0f / a->voxel_w, .nx = a->nx, .ny = a->ny, .nz = a->nz};
+    int64_t  key[VX_ACCUM_BLOCK];
+    int64_t  last = -1;
+    int      cell = -1;
+    Vector3  c    = {0};
+
+    for (int i = 0; i < count; i += VX_ACCUM_BLOCK) {
+        int n = count - i < VX_ACCUM_BLOCK ? count - i : VX_ACCUM_BLOCK;
+        vx_quantize_keys_aos(v + i, n, &q, key);
+
+        for (int k = 0; k < n; k++) {
+            if (key[k] != last) {
+                cell = vxhash_find(&a->cells, (uint64_t)key[k]);
+                last = key[k];
+                if (cell >= 0) c = vx_accum_centroid(a, cell);
+            }
+            if (cell < 0) continue;
+
+            const Vector3 *p  = &v[i + k];
+            float          dx = p->x - c.x, dy = p->y - c.y, dz = p->z - c.z;
+            float          d2 = dx * dx + dy * dy + dz * dz;
+            if (d2 >= a->near_d2[cell]) continue;
+            a->near_d2[cell]  = d2;
+            a->near_pos[cell] = *p;
+            if (a->near_color && color)   a->near_color[cell]  = color[i + k];
+            if (a->near_normal && normal) a->near_normal[cell] = normal[i + k];
+        }
+    }
+}
+
+/* =========================================================
+ *  Средние по ячейке
+ * ========================================================= */
+Vector3 vx_accum_centroid(const vx_accum *a, int i)
+{
+    if (a->sums == NULL) {
+        int64_t key = a->keys[i], nxy = (int64_t)a->nx * a->ny;
+        return (Vector3){a->origin.x + ((float)(key % a->nx) + 0.5f) * a->voxel_w,
+                         a->origin.y + ((float)(key / a->nx % a->ny) + 0.5f) * a->voxel_w,
+                         a->origin.z + ((float)(key / nxy) + 0.5f) * a->voxel_w};
+    }
+    double c = (double)a->counts[i];
+    return (Vector3){(float)(a->sums[3 * i] / c), (float)(a->sums[3 * i + 1] / c),
+                     (float)(a->sums[3 * i + 2] / c)};
+}
+
+Vector3 vx_accum_color(const vx_accum *a, int i)
+{
+    if (a->colors == NULL) return (Vector3){0.0f, 0.0f, 0.0f};
+    double c = (double)a->counts[i];
+    return (Vector3){(float)(a->colors[3 * i] / c), (float)(a->colors[3 * i + 1] / c),
+                     (float)(a->colors[3 * i + 2] / c)};
+}
+
+Vector3 vx_accum_normal(const vx_accum *a, int i)
+{
+    if (a->normals == NULL) return (Vector3){0.0f, 0.0f, 0.0f};
+    const double *s   = &a->normals[3 * i];
+    double        len = sqrt(s[0] * s[0] + s[1] * s[1] + s[2] * s[2]);
+    if (len == 0.0) return (Vector3){0.0f, 0.0f, 0.0f};
+    return (Vector3){(float)(s[0] / len), (float)(s[1] / len), (float)(s[2] / len)};
+}
+
+/* =========================================================
+ *  vx_accum_sorted
+ * ========================================================= */
+int vx_accum_sorted(const vx_accum *a, int min_count, int **order)
+{
+    return vx_keyed_sorted(a->keys, a->counts, a->count, min_count, order);
+}
+
+/* =========================================================
+ *  Проходы по файлу
+ * ========================================================= */
+static Vector3 *chunk_alloc(int *chunk)
+{
+    if (*chunk <= 0) *chunk = VX_STREAM_CHUNK;
+    Vector3 *buf = malloc((size_t)*chunk * sizeof(Vector3));
+    assert(buf != NULL);
+    return buf;
+}
+
+/* Ошибка чтения потока: текст в err, поток закрывается */
+static vx_status stream_failed(ply_stream *s, vx_error *err)
+{
+    const vx_error *e  = ply_stream_error(s);
+    vx_status       st = e->status;
+    if (err != NULL) *err = *e;
+    ply_stream_close(s);
+    return st;
+}
+
+vx_status vx_stream_bounds(vx_stream_norm *norm, const char *filename, float norm_factor,
+                           int chunk, vx_error *err)
+{
+    vx_error    open_err;
+    ply_stream *s = ply_stream_open(filename, NULL, &open_err);
+    *norm = (vx_stream_norm){.factor = norm_factor};
+    if (s == NULL) {
+        if (err != NULL) *err = open_err;
+        return open_err.status;
+    }
+    Vector3 *buf = chunk_alloc(&chunk);
+
+    float   mn[3] = { FLT_MAX,  FLT_MAX,  FLT_MAX};
+    float   mx[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    int64_t total = 0;
+    long    k;
+    while ((k = ply_stream_read(s, buf, chunk)) > 0) {
+        vx_minmax_aos(buf, (int)k, mn, mx);
+        total += k;
+    }
+    free(buf);
+    if (k < 0) return stream_failed(s, err);
+    *norm = (vx_stream_norm){.factor = norm_factor, .points = total, .attrs = ply_stream_attrs(s)};
+    ply_stream_close(s);
+
+    if (total == 0) return VX_OK;
+    for (int a = 0; a < 3; a++) {
+        norm->lo[a]    = mn[a];
+        norm->range[a] = mx[a] - mn[a];
+    }
+
+    /* Нормализованные границы — те же крайние вершины через то же ядро */
+    Vector3 corner[2] = {{mn[0], mn[1], mn[2]}, {mx[0], mx[1], mx[2]}};
+    float   lo[3] = {norm_factor, norm_factor, norm_factor}, hi[3] = {0, 0, 0};
+    vx_normalize_aos(corner, 2, norm->lo, norm->range, norm_factor, lo, hi);
+    norm->bounds = (vx_bounds){lo[0], hi[0], lo[1], hi[1], lo[2], hi[2]};
+    return VX_OK;
+}
+
+/* Проход по файлу: нормализованный кусок (с цветом и нормалями, если
+ * их копит накопитель и они есть в файле) передаётся в fn */
+typedef void (*accum_pass_fn)(vx_accum *a, const Vector3 *v, const Vector3 *color,
+                              const Vector3 *normal, int count);
+
+static vx_status stream_pass(vx_accum *a, const char *filename, const vx_stream_norm *norm,
+                             int chunk, accum_pass_fn fn, vx_error *err)
+{
+    vx_error    open_err;
+    ply_stream *s = ply_stream_open(filename, NULL, &open_err);
+    if (s == NULL) {
+        if (err != NULL) *err = open_err;
+        return open_err.status;
+    }
+    Vector3    *buf    = chunk_alloc(&chunk);
+    int         attrs  = ply_stream_attrs(s);
+    Vector3    *color  = NULL, *normal = NULL;
+    if (a->colors && (attrs & PLY_ATTR_COLOR))    color  = chunk_alloc(&chunk);
+    if (a->normals && (attrs & PLY_ATTR_NORMAL))  normal = chunk_alloc(&chunk);
+
+    long k;
+    while ((k = ply_stream_read_attrs(s, buf, color, normal, chunk)) > 0) {
+        float mn[3] = {norm->factor, norm->factor, norm->factor}, mx[3] = {0, 0, 0};
+        vx_normalize_aos(buf, (int)k, norm->lo, norm->range, norm->factor, mn, mx);
+        fn(a, buf, color, normal, (int)k);
+    }
+    free(buf);
+    free(color);
+    free(normal);
+    if (k < 0) return stream_failed(s, err);
+    ply_stream_close(s);
+    return VX_OK;
+}
+
+vx_status vx_stream_bin(vx_accum *a, const char *filename, const vx_stream_norm *norm,
+                        int chunk, vx_error *err)
+{
+    return stream_pass(a, filename, norm, chunk, vx_accum_add_attrs, err);
+}
+
+vx_status vx_stream_nearest(vx_accum *a, const char *filename, const vx_stream_norm *norm,
+                            int chunk, vx_error *err)
+{
+    return stream_pass(a, filename, norm, chunk, vx_accum_nearest, err);
+}
+
+/* =========================================================
+ *  vx_accum_write_ply
+ * ========================================================= */
+static uint8_t color_byte(float c)
+{
+    c = c < 0.0f ? 0.0f : c > 255.0f ? 255.0f : c;
+    return (uint8_t)lrintf(c);
+}
+
+vx_status vx_accum_write_ply(const vx_accum *a, const char *filename, const vx_stream_norm *norm,
+                             int min_count, bool nearest, int *written, vx_error *err)
+{
+    assert(!nearest || a->near_pos != NULL);
+    if (written != NULL) *written = 0;
+    FILE *f = fopen(filename, "wb");
+    if (f == NULL) return vx_fail(err, VX_ERR_OPEN, "Не удалось создать %s", filename);
+
+    int *order;
+    int  n = vx_accum_sorted(a, min_count, &order);
+
+    fprintf(f, "ply\nformat %s 1.0\n", ply_host_little_endian() ? "binary_little_endian"
+                                                                : "binary_big_endian");
+    fprintf(f, "comment voxel downsample %d %d %d, voxel_w %.9g, %s\n", a->nx, a->ny, a->nz,
+            a->voxel_w, nearest ? "nearest" : "centroid");
+    fprintf(f, "element vertex %d\n", n);
+    fprintf(f, "property float x\nproperty float y\nproperty float z\n");
+    if (a->colors)  fprintf(f, "property uchar red\nproperty uchar green\nproperty uchar blue\n");
+    if (a->normals) fprintf(f, "property float nx\nproperty float ny\nproperty float nz\n");
+    fprintf(f, "end_header\n");
+
+    /* Обратная нормализация: v = lo + v' · range / factor */
+    double scale[3];
+    for (int k = 0; k < 3; k++) scale[k] = (double)norm->range[k] / norm->factor;
+
+    bool ok = true;
+    for (int k = 0; k < n && ok; k++) {
+        int     i = order[k];
+        Vector3 p = nearest ? a->near_pos[i] : vx_accum_centroid(a, i);
+        float   xyz[3] = {(float)(norm->lo[0] + p.x * scale[0]),
+                          (float)(norm->lo[1] + p.y * scale[1]),
+                          (float)(norm->lo[2] + p.z * scale[2])};
+        ok = fwrite(xyz, sizeof(float), 3, f) == 3;
+        if (a->colors) {
+            Vector3 c      = nearest ? a->near_color[i] : vx_accum_color(a, i);
+            uint8_t rgb[3] = {color_byte(c.x), color_byte(c.y), color_byte(c.z)};
+            ok = ok && fwrite(rgb, 1, 3, f) == 3;
+        }
+        if (a->normals) {
+            Vector3 m = nearest ? a->near_normal[i] : vx_accum_normal(a, i);
+            ok = ok && fwrite(&m, sizeof(float), 3, f) == 3;
+        }
+    }
+
+    free(order);
+    if (fclose(f) != 0 || !ok) return vx_fail(err, VX_ERR_WRITE, "Ошибка записи %s", filename);
+    if (written != NULL) *written = n;
+    return VX_OK;
+}
@@ -0,0 +1,198 @@
+#ifndef VXSTREAM_H
+#define VXSTREAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "voxel.h"
+
+/* =========================================================
+ *  Потоковая вокселизация облаков больше памяти
+ *
+ *  verts_from_ply держит в памяти все вершины, vxlist — ещё
+ *  их копию в points. Здесь файл читается дважды кусками
+ *  (ply_stream): первый проход находит границы, второй
+ *  нормализует каждый кусок и сразу раскладывает его по
+ *  ячейкам. Вершины не сохраняются — у ячейки есть только
+ *  счётчик и (по желанию) суммы координат, цвета и нормалей,
+ *  поэтому память ограничена куском и числом занятых ячеек.
+ *  Тот же накопитель даёт прореживание облака: по точке на
+ *  занятую ячейку — центроид или ближайшая к нему вершина.
+ * ========================================================= */
+
+/** Вершин в куске по умолчанию (12 МБ). */
+#define VX_STREAM_CHUNK (1 << 20)
+
+/** Что копит vx_accum помимо счётчика (флаги fields). */
+#define VX_ACCUM_CENTROID 1 /**< Суммы координат.        */
+#define VX_ACCUM_COLOR    2 /**< Суммы цвета (r, g, b).  */
+#define VX_ACCUM_NORMAL   4 /**< Суммы нормалей.         */
+
+/**
+ * @brief Параметры нормализации, найденные первым проходом.
+ */
+typedef struct vx_stream_norm {
+    float     lo[3];    /**< Исходный минимум по осям.  */
+    float     range[3]; /**< Исходный размах по осям.   */
+    float     factor;   /**< Множитель нормализации.    */
+    int64_t   points;   /**< Вершин в файле.            */
+    int       attrs;    /**< PLY_ATTR_* файла.          */
+    vx_bounds bounds;   /**< Нормализованные границы.   */
+} vx_stream_norm;
+
+/**
+ * @brief Накопитель по занятым ячейкам вместо хранения вершин.
+ *
+ * Ячейки добавляются в порядке появления; keys, counts и суммы —
+ * параллельные массивы, cells — поиск номера по линейному индексу.
+ * Суммы — в double: у плотных ячеек вершин миллионы. Массивы near_*
+ * появляются после первого vx_accum_nearest.
+ */
+typedef struct vx_accum {
+    int64_t *keys;        /**< Линейные индексы zi·(nx·ny) + yi·nx + xi. */
+    int64_t *counts;      /**< Вершин в ячейке.                          */
+    double  *sums;        /**< Суммы координат, по 3 на ячейку, или NULL. */
+    double  *colors;      /**< Суммы цвета, по 3 на ячейку, или NULL.     */
+    double  *normals;     /**< Суммы нормалей, по 3 на ячейку, или NULL.  */
+    int      fields;      /**< VX_ACCUM_*.                               */
+    int      count;       /**< Занятых ячеек.                            */
+    int      capacity;    /**< Вместимость массивов.                     */
+    vxhash   cells;       /**< Линейный индекс -> номер ячейки.          */
+    int      nx;          /**< Ячеек вдоль X.                            */
+    int      ny;          /**< Ячеек вдоль Y.                            */
+    int      nz;          /**< Ячеек вдоль Z.                            */
+    float    voxel_w;     /**< Длина ребра ячейки.                       */
+    Vector3  origin;      /**< Угол сетки (как у create_sparse_mesh).    */
+    int64_t  point_count; /**< Всего добавлено вершин.                   */
+    Vector3 *near_pos;    /**< Вершина, ближайшая к центроиду, или NULL. */
+    Vector3 *near_color;  /**< Её цвет (если копится цвет).              */
+    Vector3 *near_normal; /**< Её нормаль (если копятся нормали).        */
+    float   *near_d2;     /**< Квадрат её расстояния до центроида.       */
+} vx_accum;
+
+/**
+ * @brief Создаёт пустой накопитель.
+ *
+ * @param fields VX_ACCUM_* — какие суммы копить (по 24 байта на ячейку каждая).
+ */
+void vx_accum_init(vx_accum *a, int nx, int ny, int nz, float voxel_w, Vector3 origin,
+                   int fields);
+
+/**
+ * @brief Освобождает память накопителя и обнуляет его поля.
+ */
+void vx_accum_free(vx_accum *a);
+
+/**
+ * @brief Байт памяти, занятых накопителем.
+ */
+size_t vx_accum_bytes(const vx_accum *a);
+
+/**
+ * @brief Добавляет нормализованные вершины.
+ *
+ * Квантование то же, что в ind_finder (vx_quantize, ребро voxel_w от
+ * нуля нормализованных координат), поэтому счётчики совпадают с
+ * count вокселей сетки, построенной из тех же вершин в памяти.
+ */
+void vx_accum_add(vx_accum *a, const Vector3 *v, int count);
+
+/**
+ * @brief То же с цветом и нормалью вершин (NULL — нет в данных).
+ *
+ * Суммы, которых нет в fields, не копятся; суммы из fields без данных
+ * остаются нулевыми.
+ */
+void vx_accum_add_attrs(vx_accum *a, const Vector3 *v, const Vector3 *color,
+                        const Vector3 *normal, int count);
+
+/**
+ * @brief Запоминает для каждой ячейки вершину, ближайшую к её центроиду.
+ *
+ * Вызывается после того, как все вершины добавлены (нужен
+ * VX_ACCUM_CENTROID), — тем же набором вершин ещё раз. Вершины вне
+ * накопленных ячеек пропускаются. Цвет и нормаль ближайшей вершины
+ * сохраняются, если они копятся.
+ */
+void vx_accum_nearest(vx_accum *a, const Vector3 *v, const Vector3 *color,
+                      const Vector3 *normal, int count);
+
+/**
+ * @brief Центроид вершин ячейки @p i (нормализованные координаты).
+ *
+ * Без VX_ACCUM_CENTROID — центр ячейки.
+ */
+Vector3 vx_accum_centroid(const vx_accum *a, int i);
+
+/**
+ * @brief Средний цвет ячейки @p i (0..255) или 0 без VX_ACCUM_COLOR.
+ */
+Vector3 vx_accum_color(const vx_accum *a, int i);
+
+/**
+ * @brief Средняя нормаль ячейки @p i, приведённая к единичной длине.
+ */
+Vector3 vx_accum_normal(const vx_accum *a, int i);
+
+/**
+ * @brief Номера ячеек, где не меньше @p min_count вершин, по возрастанию ключа.
+ *
+ * @param order [out] Массив номеров (освобождать free).
+ * @return Длина массива.
+ */
+int vx_accum_sorted(const vx_accum *a, int min_count, int **order);
+
+/**
+ * @brief Первый проход: границы облака.
+ *
+ * Заполняет @p norm; norm->bounds — те же границы, что дают
+ * vx_ctx_load_ply + vx_ctx_normalize (нормализованы той же формулой,
+ * что и вершины во втором проходе), поэтому cube_volume и voxel_w
+ * считаются так же, как для облака в памяти. Глобальное состояние
+ * не меняется.
+ *
+ * @param chunk Вершин в куске (<= 0 — VX_STREAM_CHUNK).
+ * @param err   [out] Текст ошибки файла или NULL.
+ * @return VX_OK или код ошибки (ply_stream_open, ply_stream_read).
+ */
+vx_status vx_stream_bounds(vx_stream_norm *norm, const char *filename, float norm_factor,
+                           int chunk, vx_error *err);
+
+/**
+ * @brief Второй проход: нормализует кусок за куском и добавляет в @p a.
+ *
+ * При ошибке в @p a остаются вершины, прочитанные до неё.
+ *
+ * @param norm  Результат vx_stream_bounds для того же файла.
+ * @param chunk Вершин в куске (<= 0 — VX_STREAM_CHUNK).
+ * @param err   [out] Текст ошибки файла или NULL.
+ * @return VX_OK или код ошибки.
+ */
+vx_status vx_stream_bin(vx_accum *a, const char *filename, const vx_stream_norm *norm,
+                        int chunk, vx_error *err);
+
+/**
+ * @brief Третий проход: vx_accum_nearest по всем вершинам файла.
+ */
+vx_status vx_stream_nearest(vx_accum *a, const char *filename, const vx_stream_norm *norm,
+                            int chunk, vx_error *err);
+
+/**
+ * @brief Записывает прореженное облако: по вершине на ячейку.
+ *
+ * Binary PLY в порядке байт машины: x, y, z (float, в исходных
+ * координатах — нормализация @p norm обращается), затем, если
+ * копились, red, green, blue (uchar) и nx, ny, nz (float). Вершина —
+ * центроид ячейки или, с @p nearest, ближайшая к нему вершина облака
+ * (тогда её собственные цвет и нормаль). Ячейки, где вершин меньше
+ * @p min_count, пропускаются. Ячейки идут по возрастанию линейного
+ * индекса.
+ *
+ * @param written [out] Число записанных вершин или NULL.
+ * @param err     [out] Текст ошибки или NULL.
+ * @return VX_OK, VX_ERR_OPEN (файл не создан) или VX_ERR_WRITE.
+ */
+vx_status vx_accum_write_ply(const vx_accum *a, const char *filename, const vx_stream_norm *norm,
+                             int min_count, bool nearest, int *written, vx_error *err);
+
+#endif /* VXSTREAM_H */
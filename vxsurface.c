@@ -0,0 +1,174 @@
+#include <math.h>
+#include <stdint.h>
+#include "vxsurface.h"
+#include "vxsys.h"
+
+/* Треугольников в одном блоке задачи */
+#define VX_SURF_BLOCK 4096
+
+/* Допуск тестов относительно ребра ячейки: касание по грани или
+ * ребру ячейки засчитывается обоим соседям независимо от
+ * округления, поэтому общие рёбра треугольников не дают щелей. */
+#define VX_SURF_EPS 1e-5f
+
+/* Ячейка отмечается атомарно; уже выставленный бит не трогаем,
+ * чтобы не гонять строку кэша между потоками. */
+static void mark_cell(vxbits *b, int64_t cell)
+{
+    uint64_t  bit = (uint64_t)1 << (cell & 63);
+    uint64_t *w   = &b->words[cell >> 6];
+    if (!(__atomic_load_n(w, __ATOMIC_RELAXED) & bit)) __atomic_fetch_or(w, bit, __ATOMIC_RELAXED);
+}
+
+static int clampi(int v, int lo, int hi)
+{
+    return v < lo ? lo : v > hi ? hi : v;
+}
+
+/* Ребро треугольника в проекции на плоскость осей (u, v):
+ * ne·p + d >= 0 для ячеек, которые не лежат целиком снаружи */
+typedef struct {
+    float nu, nv, d, tol;
+} surf_edge;
+
+static surf_edge edge_2d(float eu, float ev, float pu, float pv, float sign, float w)
+{
+    surf_edge e;
+    e.nu  = -ev * sign;
+    e.nv  =  eu * sign;
+    e.d   = -(e.nu * pu + e.nv * pv) + fmaxf(0.0f, w * e.nu) + fmaxf(0.0f, w * e.nv);
+    e.tol = VX_SURF_EPS * w * (fabsf(e.nu) + fabsf(e.nv));
+    return e;
+}
+
+static bool edges_pass(const surf_edge *e, float pu, float pv)
+{
+    for (int i = 0; i < 3; i++) {
+        if (e[i].nu * pu + e[i].nv * pv + e[i].d < -e[i].tol) return false;
+    }
+    return true;
+}
+
+/* =========================================================
+ *  voxelize_triangle
+ *  Тест пересечения треугольника с кубом ячейки в форме
+ *  Шварца–Зайделя: плоскость треугольника (ось — нормаль) и
+ *  по три ребра в проекциях XY, YZ, ZX (оси — произведения
+ *  рёбер на оси координат). Оси самих координат покрывает
+ *  обход только охватывающего параллелепипеда.
+ * ========================================================= */
+static void voxelize_triangle(vxbits *b, Vector3 a, Vector3 bb, Vector3 c, float w, float inv_w)
+{
+    float v[3][3] = {{a.x, a.y, a.z}, {bb.x, bb.y, bb.z}, {c.x, c.y, c.z}};
+    int   dim[3]  = {b->nx, b->ny, b->nz};
+    int   lo[3], hi[3];
+    for (int k = 0; k < 3; k++) {
+        float mn = fminf(v[0][k], fminf(v[1][k], v[2][k]));
+        float mx = fmaxf(v[0][k], fmaxf(v[1][k], v[2][k]));
+        lo[k] = clampi((int)floorf(mn * inv_w - VX_SURF_EPS), 0, dim[k] - 1);
+        hi[k] = clampi((int)floorf(mx * inv_w + VX_SURF_EPS), 0, dim[k] - 1);
+    }
+
+    /* Треугольник внутри одной ячейки — тесты не нужны */
+    if (lo[0] == hi[0] && lo[1] == hi[1] && lo[2] == hi[2]) {
+        mark_cell(b, vxbits_cell(b, lo[0], lo[1], lo[2]));
+        return;
+    }
+
+    float e[3][3];
+    for (int i = 0; i < 3; i++) {
+        for (int k = 0; k < 3; k++) e[i][k] = v[(i + 1) % 3][k] - v[i][k];
+    }
+    float n[3] = {e[0][1] * e[1][2] - e[0][2] * e[1][1],
+                  e[0][2] * e[1][0] - e[0][0] * e[1][2],
+                  e[0][0] * e[1][1] - e[0][1] * e[1][0]};
+
+    /* Плоскость: значения в ближнем и дальнем по нормали углах куба */
+    float crit[3], d1 = 0.0f, d2 = 0.0f;
+    for (int k = 0; k < 3; k++) {
+        crit[k] = n[k] > 0.0f ? w : 0.0f;
+        d1 += n[k] * (crit[k] - v[0][k]);
+        d2 += n[k] * ((w - crit[k]) - v[0][k]);
+    }
+    float plane_tol = VX_SURF_EPS * w * (fabsf(n[0]) + fabsf(n[1]) + fabsf(n[2]));
+
+    /* Рёбра в проекциях: XY (u = x, v = y), YZ (y, z), ZX (z, x) */
+    surf_edge xy[3], yz[3], zx[3];
+    float     sz = n[2] >= 0.0f ? 1.0f : -1.0f;
+    float     sx = n[0] >= 0.0f ? 1.0f : -1.0f;
+    float     sy = n[1] >= 0.0f ? 1.0f : -1.0f;
+    for (int i = 0; i < 3; i++) {
+        xy[i] = edge_2d(e[i][0], e[i][1], v[i][0], v[i][1], sz, w);
+        yz[i] = edge_2d(e[i][1], e[i][2], v[i][1], v[i][2], sx, w);
+        zx[i] = edge_2d(e[i][2], e[i][0], v[i][2], v[i][0], sy, w);
+    }
+
+    for (int zi = lo[2]; zi <= hi[2]; zi++) {
+        float pz = (float)zi * w;
+        for (int yi = lo[1]; yi <= hi[1]; yi++) {
+            float py = (float)yi * w;
+            if (!edges_pass(yz, py, pz)) continue;
+            float np_yz = n[1] * py + n[2] * pz;
+            for (int xi = lo[0]; xi <= hi[0]; xi++) {
+                float px = (float)xi * w;
+                if (!edges_pass(xy, px, py) || !edges_pass(zx, pz, px)) continue;
+                float np = n[0] * px + np_yz;
+                float p1 = np + d1, p2 = np + d2;
+                if (fminf(p1, p2) > plane_tol || fmaxf(p1, p2) < -plane_tol) continue;
+                mark_cell(b, vxbits_cell(b, xi, yi, zi));
+            }
+        }
+    }
+}
+
+/* =========================================================
+ *  Параллельный обход: задача t берёт блоки t, t + T, ...
+ * ========================================================= */
+typedef struct {
+    vxbits            *out;
+    const Vector3     *vertices;
+    const vx_trilist  *tris;
+    float              voxel_w;
+    const vx_bin_opts *opts;
+    int64_t            done;
+} surf_job;
+
+static void surface_task(void *ctx, int task, int task_count)
+{
+    surf_job *job   = ctx;
+    float     w     = job->voxel_w;
+    float     inv_w = 1.0f / w;
+    int       total = job->tris->count;
+
+    for (int b = task * VX_SURF_BLOCK; b < total; b += task_count * VX_SURF_BLOCK) {
+        const vx_bin_opts *o = job->opts;
+        if (o->cancel && __atomic_load_n(o->cancel, __ATOMIC_RELAXED)) return;
+
+        int end = b + VX_SURF_BLOCK < total ? b + VX_SURF_BLOCK : total;
+        for (int t = b; t < end; t++) {
+            const int *i = job->tris->items[t].v;
+            voxelize_triangle(job->out, job->vertices[i[0]], job->vertices[i[1]],
+                              job->vertices[i[2]], w, inv_w);
+        }
+
+        int64_t done = __atomic_add_fetch(&job->done, end - b, __ATOMIC_RELAXED);
+        if (o->progress) __atomic_store_n(o->progress, (int)(done * 1000 / total), __ATOMIC_RELAXED);
+    }
+}
+
+void vx_voxelize_surface(vxbits *out, const Vector3 *vertices, const vx_trilist *tris,
+                         float voxel_w, const vx_bin_opts *opts)
+{
+    vx_bin_opts defaults = {.threads = 0, .deterministic = true, .cancel = NULL, .progress = NULL};
+    if (opts == NULL) opts = &defaults;
+    if (tris->count == 0) return;
+
+    surf_job job = {.out = out, .vertices = vertices, .tris = tris,
+                    .voxel_w = voxel_w, .opts = opts, .done = 0};
+
+    int blocks = (tris->count + VX_SURF_BLOCK - 1) / VX_SURF_BLOCK;
+    int tasks  = opts->threads > 0 ? opts->threads : vx_thread_count();
+    if (tasks > blocks) tasks = blocks;
+    if (tasks > 1) vx_parallel_run(tasks, surface_task, &job);
+    else           surface_task(&job, 0, 1);
+}
@@ -0,0 +1,41 @@
+#ifndef VXSURFACE_H
+#define VXSURFACE_H
+
+#include "voxel.h"
+#include "vxbits.h"
+
+/* =========================================================
+ *  Поверхностная вокселизация треугольной сетки
+ *
+ *  Ячейка отмечается, если её куб пересекается хотя бы с одним
+ *  треугольником (тест разделяющих осей). Пересечение
+ *  консервативное, поэтому соседние треугольники дают сплошную
+ *  поверхность без дыр при любом разрешении — в отличие от
+ *  раскладки одних вершин, где треугольник крупнее ячейки
+ *  оставляет пустоты.
+ * ========================================================= */
+
+/**
+ * @brief Отмечает в @p out ячейки, которые пересекает поверхность.
+ *
+ * Сетка — как у ind_finder: ячейка (xi, yi, zi) — куб
+ * [xi·w, (xi+1)·w) × ... в нормализованных координатах, w = voxel_w,
+ * размеры берутся из @p out. Для каждого треугольника проверяются
+ * только ячейки его охватывающего параллелепипеда: сначала плоскость
+ * треугольника, затем проекции рёбер на плоскости XY, YZ, ZX — вместе
+ * с осями самого параллелепипеда это все 13 осей теоремы о
+ * разделяющей оси. Треугольники обрабатываются блоками в пуле
+ * потоков; биты выставляются атомарно, счётчики @p out не меняются.
+ *
+ * @param out      Битовая сетка; уже выставленные биты сохраняются.
+ * @param vertices Нормализованные вершины.
+ * @param tris     Треугольники (индексы в vertices).
+ * @param voxel_w  Длина ребра ячейки.
+ * @param opts     Потоки, отмена и ход работы (NULL — все ядра, без
+ *                 отмены); deterministic не влияет — результат от
+ *                 порядка не зависит.
+ */
+void vx_voxelize_surface(vxbits *out, const Vector3 *vertices, const vx_trilist *tris,
+                         float voxel_w, const vx_bin_opts *opts);
+
+#endif /* VXSURFACE_H */
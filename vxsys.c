@@ -0,0 +1,225 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L /* clock_gettime */
+#endif
+#if defined(__APPLE__) && !defined(_DARWIN_C_SOURCE)
+#define _DARWIN_C_SOURCE        /* _SC_NPROCESSORS_ONLN */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#endif
+
+#include "vxsys.h"
+
+/* 0 — значение не задано, используется число ядер. Читается рабочими
+ * потоками пула, поэтому доступ атомарный */
+static int thread_override = 0;
+
+/* =========================================================
+ *  vx_thread_count / vx_set_thread_count
+ * ========================================================= */
+int vx_thread_count(void)
+{
+    int n = __atomic_load_n(&thread_override, __ATOMIC_RELAXED);
+    if (n > 0) return n;
+#ifdef _WIN32
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    n = (int)si.dwNumberOfProcessors;
+#else
+    n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return n > 0 ? n : 1;
+}
+
+void vx_set_thread_count(int n)
+{
+    __atomic_store_n(&thread_override, n > 0 ? n : 0, __ATOMIC_RELAXED);
+}
+
+/* =========================================================
+ *  vx_parallel_run
+ *  Постоянный пул из (vx_thread_count() - 1) рабочих потоков,
+ *  создаётся при первом вызове и дорастает при увеличении числа
+ *  потоков. Каждый вызов заводит запись задания на своём стеке
+ *  и ставит её в очередь; рабочие берут из головы очереди по
+ *  задаче и переносят задание в хвост, так что одновременные
+ *  вызовы (из разных потоков или вложенные из задач) делят пул
+ *  по кругу. Вызывающий поток выполняет задачи своего задания
+ *  и ждёт, пока рабочие доделают взятые.
+ * ========================================================= */
+typedef struct pool_job {
+    vx_task_fn       fn;
+    void            *ctx;
+    int              task_count;
+    int              next;       /* следующая невыданная задача            */
+    int              done;       /* завершённые задачи                     */
+    struct pool_job *link;       /* следующее задание очереди               */
+} pool_job;
+
+static pthread_mutex_t pool_lock  = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  pool_wake  = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t  pool_idle  = PTHREAD_COND_INITIALIZER;
+static int             pool_size  = 0;
+static pool_job       *pool_head  = NULL; /* задания с невыданными задачами */
+static pool_job       *pool_tail  = NULL;
+
+/* Очередь меняется только под pool_lock */
+static void queue_push(pool_job *job)
+{
+    job->link = NULL;
+    if (pool_tail) pool_tail->link = job;
+    else           pool_head = job;
+    pool_tail = job;
+}
+
+static void queue_remove(pool_job *job)
+{
+    pool_job **p = &pool_head, *prev = NULL;
+    while (*p != job) {
+        prev = *p;
+        p    = &(*p)->link;
+    }
+    *p = job->link;
+    if (pool_tail == job) pool_tail = prev;
+}
+
+/* Выдаёт задачу задания; выданная последней убирает его из очереди */
+static int job_take(pool_job *job)
+{
+    int task = job->next++;
+    if (job->next == job->task_count) queue_remove(job);
+    return task;
+}
+
+/* Выполняет задачу вне pool_lock; вызывается и возвращается под ним */
+static void job_run(pool_job *job, int task)
+{
+    pthread_mutex_unlock(&pool_lock);
+    job->fn(job->ctx, task, job->task_count);
+    pthread_mutex_lock(&pool_lock);
+    if (++job->done == job->task_count) pthread_cond_broadcast(&pool_idle);
+}
+
+static void *pool_worker(void *arg)
+{
+    (void)arg;
+    pthread_mutex_lock(&pool_lock);
+    for (;;) {
+        while (pool_head == NULL) pthread_cond_wait(&pool_wake, &pool_lock);
+        pool_job *job  = pool_head;
+        int       task = job_take(job);
+        if (job->next < job->task_count && job != pool_tail) {
+            queue_remove(job);
+            queue_push(job);
+        }
+        job_run(job, task);
+    }
+    return NULL;
+}
+
+static void pool_grow(int workers)
+{
+    while (pool_size < workers) {
+        pthread_t t;
+        if (pthread_create(&t, NULL, pool_worker, NULL) != 0) break;
+        pthread_detach(t);
+        pool_size++;
+    }
+}
+
+void vx_parallel_run(int task_count, vx_task_fn fn, void *ctx)
+{
+    if (task_count <= 1) {
+        fn(ctx, 0, 1);
+        return;
+    }
+
+    pool_job job = {.fn = fn, .ctx = ctx, .task_count = task_count};
+    pthread_mutex_lock(&pool_lock);
+    pool_grow(vx_thread_count() - 1);
+    queue_push(&job);
+    pthread_cond_broadcast(&pool_wake);
+
+    while (job.next < job.task_count) job_run(&job, job_take(&job));
+    while (job.done < job.task_count) pthread_cond_wait(&pool_idle, &pool_lock);
+    pthread_mutex_unlock(&pool_lock);
+}
+
+/* =========================================================
+ *  vx_now
+ * ========================================================= */
+double vx_now(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq, t;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&t);
+    return (double)t.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+/* =========================================================
+ *  vx_peak_rss / vx_reset_peak_rss
+ *  Linux: VmHWM из /proc/self/status (сбрасывается записью
+ *  "5" в /proc/self/clear_refs); иначе — getrusage или
+ *  GetProcessMemoryInfo без возможности сброса.
+ * ========================================================= */
+size_t vx_peak_rss(void)
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return pmc.PeakWorkingSetSize;
+    return 0;
+#else
+#ifdef __linux__
+    FILE *f = fopen("/proc/self/status", "r");
+    if (f != NULL) {
+        char   line[256];
+        size_t kb = 0;
+        while (fgets(line, sizeof(line), f)) {
+            if (strncmp(line, "VmHWM:", 6) == 0) {
+                kb = (size_t)strtoul(line + 6, NULL, 10);
+                break;
+            }
+        }
+        fclose(f);
+        if (kb > 0) return kb * 1024;
+    }
+#endif
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return 0;
+#ifdef __APPLE__
+    return (size_t)ru.ru_maxrss;        /* байты */
+#else
+    return (size_t)ru.ru_maxrss * 1024; /* килобайты */
+#endif
+#endif
+}
+
+bool vx_reset_peak_rss(void)
+{
+#ifdef __linux__
+    FILE *f = fopen("/proc/self/clear_refs", "w");
+    if (f == NULL) return false;
+    bool ok = fputs("5", f) >= 0;
+    return fclose(f) == 0 && ok;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,68 @@
+#ifndef VXSYS_H
+#define VXSYS_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/* =========================================================
+ *  Системные примитивы: потоки и время
+ * ========================================================= */
+
+/**
+ * @brief Функция-задача для vx_parallel_run.
+ *
+ * @param ctx        Общий контекст, переданный в vx_parallel_run.
+ * @param task       Номер задачи в диапазоне [0, task_count).
+ * @param task_count Общее количество задач.
+ */
+typedef void (*vx_task_fn)(void *ctx, int task, int task_count);
+
+/**
+ * @brief Возвращает количество рабочих потоков.
+ *
+ * По умолчанию — число доступных процессорных ядер; может быть
+ * переопределено через vx_set_thread_count.
+ */
+int vx_thread_count(void);
+
+/**
+ * @brief Задаёт количество рабочих потоков.
+ *
+ * @param n Количество потоков; n <= 0 — вернуть значение по умолчанию.
+ */
+void vx_set_thread_count(int n);
+
+/**
+ * @brief Выполняет @p task_count задач параллельно и дожидается их завершения.
+ *
+ * Задачи раздаются постоянному пулу рабочих потоков; вызывающий поток
+ * тоже выполняет задачи. Число задач может превышать число потоков.
+ * Одновременные вызовы из разных потоков и вложенные вызовы из задач
+ * делят пул: рабочие берут задачи их заданий по очереди.
+ *
+ * @param task_count Количество задач (>= 1).
+ * @param fn         Функция-задача.
+ * @param ctx        Контекст, передаваемый каждой задаче.
+ */
+void vx_parallel_run(int task_count, vx_task_fn fn, void *ctx);
+
+/**
+ * @brief Монотонное время в секундах (для замеров).
+ */
+double vx_now(void);
+
+/**
+ * @brief Пиковый объём резидентной памяти процесса в байтах (0 — неизвестно).
+ */
+size_t vx_peak_rss(void);
+
+/**
+ * @brief Сбрасывает пик резидентной памяти к текущему значению.
+ *
+ * Поддерживается только в Linux (/proc/self/clear_refs).
+ *
+ * @return true, если пик сброшен.
+ */
+bool vx_reset_peak_rss(void);
+
+#endif /* VXSYS_H */
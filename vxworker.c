@@ -0,0 +1,127 @@
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include "vxworker.h"
+
+/* =========================================================
+ *  worker_main
+ *  Ждёт запрос, строит сетку вне блокировки и публикует её,
+ *  если за время сборки не пришёл новый запрос. Незабранный
+ *  прежний результат заменяется свежим.
+ * ========================================================= */
+static void *worker_main(void *arg)
+{
+    vxworker *w = arg;
+
+    pthread_mutex_lock(&w->lock);
+    for (;;) {
+        while (w->pending == 0 && !w->quit) pthread_cond_wait(&w->wake, &w->lock);
+        if (w->quit) break;
+
+        int voxel_num = w->pending;
+        __atomic_store_n(&w->pending, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&w->building, voxel_num, __ATOMIC_RELAXED);
+        __atomic_store_n(&w->cancel, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&w->progress, 0, __ATOMIC_RELAXED);
+        pthread_mutex_unlock(&w->lock);
+
+        vx_stats_reset(&w->model.stats);
+        vx_ctx_mesh(&w->model, (int)lround(cbrt((double)voxel_num)), VX_GRID_DENSE);
+        vx_bin_opts opts = {.threads = 0, .deterministic = true,
+                            .cancel = &w->cancel, .progress = &w->progress};
+        vx_ctx_bin(&w->model, &opts);
+        vxlist mesh    = w->model.mesh;
+        float  voxel_w = w->model.voxel_w;
+        w->model.mesh  = (vxlist){0};
+
+        pthread_mutex_lock(&w->lock);
+        __atomic_store_n(&w->building, 0, __ATOMIC_RELAXED);
+        if (__atomic_load_n(&w->cancel, __ATOMIC_RELAXED) || w->pending != 0) {
+            freeContainer(&mesh);
+            continue;
+        }
+        if (w->ready) freeContainer(&w->result);
+        w->result       = mesh;
+        w->result_num   = voxel_num;
+        w->result_w     = voxel_w;
+        w->result_stats = w->model.stats;
+        w->ready        = true;
+    }
+    pthread_mutex_unlock(&w->lock);
+    return NULL;
+}
+
+void vxworker_start(vxworker *w, const vx_ctx *model)
+{
+    memset(w, 0, sizeof(*w));
+    vx_ctx_share(&w->model, model);
+
+    pthread_mutex_init(&w->lock, NULL);
+    pthread_cond_init(&w->wake, NULL);
+    int rc = pthread_create(&w->thread, NULL, worker_main, w);
+    assert(rc == 0);
+    (void)rc;
+}
+
+void vxworker_stop(vxworker *w)
+{
+    pthread_mutex_lock(&w->lock);
+    w->quit = true;
+    __atomic_store_n(&w->cancel, 1, __ATOMIC_RELAXED);
+    pthread_cond_signal(&w->wake);
+    pthread_mutex_unlock(&w->lock);
+    pthread_join(w->thread, NULL);
+
+    if (w->ready) freeContainer(&w->result);
+    w->ready = false;
+    vx_ctx_free(&w->model);
+    pthread_cond_destroy(&w->wake);
+    pthread_mutex_destroy(&w->lock);
+}
+
+void vxworker_request(vxworker *w, int voxel_num)
+{
+    pthread_mutex_lock(&w->lock);
+    int building = w->building;
+    if (building != 0 && building != voxel_num) {
+        __atomic_store_n(&w->cancel, 1, __ATOMIC_RELAXED);
+    }
+    /* То же разрешение уже строится и не отменено — ждать его */
+    bool in_flight = building == voxel_num && !__atomic_load_n(&w->cancel, __ATOMIC_RELAXED);
+    __atomic_store_n(&w->pending, in_flight ? 0 : voxel_num, __ATOMIC_RELAXED);
+    if (w->ready && w->result_num != voxel_num) {
+        freeContainer(&w->result);
+        w->ready = false;
+    }
+    pthread_cond_signal(&w->wake);
+    pthread_mutex_unlock(&w->lock);
+}
+
+bool vxworker_poll(vxworker *w, vxlist *mesh, int *voxel_num, float *voxel_w, vx_stats *stats)
+{
+    /* Поток держит блокировку только на время обмена полями */
+    if (pthread_mutex_trylock(&w->lock) != 0) return false;
+    bool ready = w->ready;
+    if (ready) {
+        *mesh      = w->result;
+        *voxel_num = w->result_num;
+        *voxel_w   = w->result_w;
+        if (stats != NULL) *stats = w->result_stats;
+        w->result  = (vxlist){0};
+        w->ready   = false;
+    }
+    pthread_mutex_unlock(&w->lock);
+    return ready;
+}
+
+int vxworker_busy(vxworker *w)
+{
+    int pending = __atomic_load_n(&w->pending, __ATOMIC_RELAXED);
+    return pending ? pending : __atomic_load_n(&w->building, __ATOMIC_RELAXED);
+}
+
+int vxworker_progress(const vxworker *w)
+{
+    return __atomic_load_n(&w->progress, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,84 @@
+#ifndef VXWORKER_H
+#define VXWORKER_H
+
+#include <stdbool.h>
+#include <pthread.h>
+#include "voxel.h"
+
+/* =========================================================
+ *  Фоновое построение сетки
+ *
+ *  Отдельный поток выполняет vx_ctx_mesh + vx_ctx_bin для
+ *  последнего запрошенного разрешения. Поток отрисовки только
+ *  ставит запросы и забирает готовые сетки — без ожидания.
+ * ========================================================= */
+
+/**
+ * @brief Фоновый построитель сеток над одной нормализованной моделью.
+ *
+ * Поля — внутреннее состояние; обращаться через функции vxworker_*.
+ */
+typedef struct vxworker {
+    pthread_t       thread;
+    pthread_mutex_t lock;
+    pthread_cond_t  wake;
+    bool            quit;        /* поток должен завершиться            */
+    int             pending;     /* запрошенное разрешение, 0 — нет     */
+    int             building;    /* разрешение в работе, 0 — простой    */
+    int             cancel;      /* отмена текущей сборки (атомарно)    */
+    int             progress;    /* 0..1000 текущей сборки (атомарно)   */
+    bool            ready;       /* результат ждёт vxworker_poll        */
+    vxlist          result;
+    int             result_num;
+    float           result_w;
+    vx_stats        result_stats;/* замеры mesh/bin этой сборки        */
+
+    vx_ctx          model;       /* vx_ctx_share: вершины не принадлежат */
+} vxworker;
+
+/**
+ * @brief Запускает поток построения.
+ *
+ * @param w     Построитель.
+ * @param model Модель после vx_ctx_normalize; не должна меняться, пока поток жив.
+ */
+void vxworker_start(vxworker *w, const vx_ctx *model);
+
+/**
+ * @brief Отменяет текущую сборку, останавливает поток и освобождает
+ *        незабранный результат.
+ */
+void vxworker_stop(vxworker *w);
+
+/**
+ * @brief Запрашивает сетку разрешения @p voxel_num.
+ *
+ * Сборка другого разрешения, ещё идущая в фоне, отменяется; более
+ * ранний незабранный запрос заменяется этим. Повторный запрос того же
+ * разрешения, что уже строится, ничего не перезапускает.
+ * @p voxel_num = 0 — только отменить текущую работу.
+ */
+void vxworker_request(vxworker *w, int voxel_num);
+
+/**
+ * @brief Забирает готовую сетку, если она есть. Никогда не ждёт.
+ *
+ * @param mesh      [out] Сетка; владение переходит вызывающему.
+ * @param voxel_num [out] Её разрешение.
+ * @param voxel_w   [out] Длина ребра вокселя.
+ * @param stats     [out] Замеры её построения (vx_ctx_mesh, vx_ctx_bin) или NULL.
+ * @return true, если сетка передана.
+ */
+bool vxworker_poll(vxworker *w, vxlist *mesh, int *voxel_num, float *voxel_w, vx_stats *stats);
+
+/**
+ * @brief Разрешение, которое сейчас строится или ждёт очереди (0 — нет работы).
+ */
+int vxworker_busy(vxworker *w);
+
+/**
+ * @brief Готовность текущей сборки, 0..1000.
+ */
+int vxworker_progress(const vxworker *w);
+
+#endif /* VXWORKER_H */